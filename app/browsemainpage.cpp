@@ -203,7 +203,7 @@ struct BrowseMainPagePrivate : public Ui_BrowseMainPage
     void setupFilterController()
     {
         QMenu* menu = new QMenu(mAddFilterButton);
-        mFilterController = new FilterController(mFilterFrame, mDirModel);
+        mFilterController = new FilterController(mFilterFrame, mDirModel, mThumbnailView);
         Q_FOREACH(QAction * action, mFilterController->actionList()) {
             menu->addAction(action);
         }
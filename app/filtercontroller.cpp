@@ -24,8 +24,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include <config-gwenview.h>
 
 // Qt
+#include <QAbstractItemView>
 #include <QAction>
 #include <QCompleter>
+#include <QLabel>
 #include <QLineEdit>
 #include <QPainter>
 #include <QPainterPath>
@@ -42,7 +44,11 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 // Local
 #include <lib/datewidget.h>
 #include <lib/flowlayout.h>
+#include <lib/imagehash.h>
+#include <lib/imagehashindex.h>
+#include <lib/mimetypeutils.h>
 #include <lib/paintutils.h>
+#include <lib/thumbnailprovider/thumbnailprovider.h>
 
 #ifndef GWENVIEW_SEMANTICINFO_BACKEND_NONE
 // KDE
@@ -134,6 +140,134 @@ void DateFilterWidget::applyDateFilter()
     mFilter->setDate(mDateWidget->date());
 }
 
+/**
+ * Delay between two refreshes of the view while hashes are being computed
+ */
+static const int SIMILARITY_APPLY_INTERVAL = 500;
+
+SimilarityFilter::SimilarityFilter(SortedDirModel* model)
+: AbstractSortedDirModelFilter(model)
+, mMaxDistance(0)
+{
+    // Hashes are computed by the thumbnail pipeline, the normal size is
+    // enough and can be derived from existing large thumbnails
+    mThumbnailProvider = new ThumbnailProvider;
+    mThumbnailProvider->setThumbnailGroup(ThumbnailGroup::Normal);
+
+    mRequestTimer = new QTimer(this);
+    mRequestTimer->setInterval(0);
+    mRequestTimer->setSingleShot(true);
+    connect(mRequestTimer, &QTimer::timeout, this, &SimilarityFilter::requestHashes);
+
+    mApplyTimer = new QTimer(this);
+    mApplyTimer->setInterval(SIMILARITY_APPLY_INTERVAL);
+    mApplyTimer->setSingleShot(true);
+    connect(mApplyTimer, &QTimer::timeout, model, &SortedDirModel::applyFilters);
+
+    // Do not restart the timer when it is active, so that the view is
+    // refreshed regularly while hashes keep coming
+    connect(ImageHashIndex::instance(), &ImageHashIndex::hashAdded, this, [this]() {
+        if (!mApplyTimer->isActive()) {
+            mApplyTimer->start();
+        }
+    });
+}
+
+SimilarityFilter::~SimilarityFilter()
+{
+    delete mThumbnailProvider;
+}
+
+bool SimilarityFilter::acceptsIndex(const QModelIndex& index) const
+{
+    if (mReferenceItem.isNull()) {
+        return true;
+    }
+    const KFileItem item = model()->itemForSourceIndex(index);
+    if (MimeTypeUtils::fileItemKind(item) != MimeTypeUtils::KIND_RASTER_IMAGE) {
+        return false;
+    }
+    quint64 referenceHash;
+    if (!findHash(mReferenceItem, &referenceHash)) {
+        return false;
+    }
+    quint64 hash;
+    if (!findHash(item, &hash)) {
+        return false;
+    }
+    return ImageHash::distance(referenceHash, hash) <= mMaxDistance;
+}
+
+bool SimilarityFilter::findHash(const KFileItem& item, quint64* hash) const
+{
+    const time_t modificationTime = item.time(KFileItem::ModificationTime).toTime_t();
+    if (ImageHashIndex::instance()->findHash(item.url(), modificationTime, hash)) {
+        return true;
+    }
+    if (!mRequestedUrls.contains(item.url())) {
+        mRequestedUrls.insert(item.url());
+        mPendingItems << item;
+        mRequestTimer->start();
+    }
+    return false;
+}
+
+void SimilarityFilter::requestHashes()
+{
+    if (mThumbnailProvider && !mPendingItems.isEmpty()) {
+        mThumbnailProvider->appendItems(mPendingItems);
+    }
+    mPendingItems.clear();
+}
+
+void SimilarityFilter::setReferenceItem(const KFileItem& item)
+{
+    mReferenceItem = item;
+    model()->applyFilters();
+}
+
+void SimilarityFilter::setMaxDistance(int distance)
+{
+    mMaxDistance = distance;
+    model()->applyFilters();
+}
+
+SimilarityFilterWidget::SimilarityFilterWidget(SortedDirModel* model, const KFileItem& referenceItem)
+{
+    mFilter = new SimilarityFilter(model);
+
+    // Maximum number of differing bits of the 64 bit hashes
+    mModeComboBox = new KComboBox;
+    mModeComboBox->addItem(i18n("Nearly identical to"), 4);
+    mModeComboBox->addItem(i18n("Similar to"), 10);
+    mModeComboBox->addItem(i18n("Vaguely similar to"), 16);
+    mModeComboBox->setCurrentIndex(1);
+
+    mLabel = new QLabel(referenceItem.name());
+
+    QHBoxLayout* layout = new QHBoxLayout(this);
+    layout->setMargin(0);
+    layout->addWidget(mModeComboBox);
+    layout->addWidget(mLabel);
+
+    connect(mModeComboBox, SIGNAL(currentIndexChanged(int)),
+            SLOT(applySimilarityFilter()));
+
+    mFilter->setReferenceItem(referenceItem);
+    applySimilarityFilter();
+}
+
+SimilarityFilterWidget::~SimilarityFilterWidget()
+{
+    delete mFilter;
+}
+
+void SimilarityFilterWidget::applySimilarityFilter()
+{
+    QVariant data = mModeComboBox->itemData(mModeComboBox->currentIndex());
+    mFilter->setMaxDistance(data.toInt());
+}
+
 #ifndef GWENVIEW_SEMANTICINFO_BACKEND_NONE
 RatingFilterWidget::RatingFilterWidget(SortedDirModel* model)
 {
@@ -278,12 +412,13 @@ protected:
 };
 
 
-FilterController::FilterController(QFrame* frame, SortedDirModel* dirModel)
+FilterController::FilterController(QFrame* frame, SortedDirModel* dirModel, QAbstractItemView* view)
 : QObject(frame)
 {
     q = this;
     mFrame = frame;
     mDirModel = dirModel;
+    mView = view;
     mFilterWidgetCount = 0;
 
     mFrame->hide();
@@ -292,10 +427,17 @@ FilterController::FilterController(QFrame* frame, SortedDirModel* dirModel)
 
     addAction(i18nc("@action:inmenu", "Filter by Name"), SLOT(addFilterByName()));
     addAction(i18nc("@action:inmenu", "Filter by Date"), SLOT(addFilterByDate()));
+    mSimilarityAction = addAction(i18nc("@action:inmenu", "Filter by Similarity to Current Image"), SLOT(addFilterBySimilarity()));
 #ifndef GWENVIEW_SEMANTICINFO_BACKEND_NONE
     addAction(i18nc("@action:inmenu", "Filter by Rating"), SLOT(addFilterByRating()));
     addAction(i18nc("@action:inmenu", "Filter by Tag"), SLOT(addFilterByTag()));
 #endif
+
+    connect(mView->selectionModel(), SIGNAL(currentChanged(QModelIndex,QModelIndex)),
+            SLOT(updateSimilarityAction()));
+    connect(mDirModel, SIGNAL(modelReset()), SLOT(updateSimilarityAction()));
+    connect(mDirModel, SIGNAL(rowsRemoved(QModelIndex,int,int)), SLOT(updateSimilarityAction()));
+    updateSimilarityAction();
 }
 
 QList<QAction*> FilterController::actionList() const
@@ -313,6 +455,22 @@ void FilterController::addFilterByDate()
     addFilter(new DateFilterWidget(mDirModel));
 }
 
+void FilterController::updateSimilarityAction()
+{
+    const KFileItem item = mDirModel->itemForIndex(mView->currentIndex());
+    mSimilarityAction->setEnabled(!item.isNull()
+                                  && MimeTypeUtils::fileItemKind(item) == MimeTypeUtils::KIND_RASTER_IMAGE);
+}
+
+void FilterController::addFilterBySimilarity()
+{
+    const KFileItem item = mDirModel->itemForIndex(mView->currentIndex());
+    if (MimeTypeUtils::fileItemKind(item) != MimeTypeUtils::KIND_RASTER_IMAGE) {
+        return;
+    }
+    addFilter(new SimilarityFilterWidget(mDirModel, item));
+}
+
 #ifndef GWENVIEW_SEMANTICINFO_BACKEND_NONE
 void FilterController::addFilterByRating()
 {
@@ -334,11 +492,12 @@ void FilterController::slotFilterWidgetClosed()
 }
 
 
-void FilterController::addAction(const QString& text, const char* slot)
+QAction* FilterController::addAction(const QString& text, const char* slot)
 {
     QAction* action = new QAction(text, q);
     QObject::connect(action, SIGNAL(triggered()), q, slot);
     mActionList << action;
+    return action;
 }
 
 
@@ -27,6 +27,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include <QDate>
 #include <QList>
 #include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QUrl>
 #include <QWidget>
 
 // KDE
@@ -46,8 +49,11 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include <lib/semanticinfo/tagmodel.h>
 #endif
 
+class QAbstractItemView;
 class QAction;
 class QFrame;
+class QLabel;
+class QTimer;
 class QLineEdit;
 class QComboBox;
 class KComboBox;
@@ -56,6 +62,7 @@ namespace Gwenview
 {
 
 class SortedDirModel;
+class ThumbnailProvider;
 
 /**
  * An AbstractSortedDirModelFilter which filters on the file names
@@ -197,6 +204,60 @@ private:
 };
 
 
+/**
+ * An AbstractSortedDirModelFilter which only accepts the images looking like
+ * a reference image, using the perceptual hashes of ImageHashIndex. Images
+ * which have not been hashed yet are queued for thumbnailing and are
+ * accepted once their hash is known.
+ */
+class SimilarityFilter : public AbstractSortedDirModelFilter
+{
+public:
+    SimilarityFilter(SortedDirModel* model);
+    ~SimilarityFilter() override;
+
+    bool needsSemanticInfo() const override
+    {
+        return false;
+    }
+
+    bool acceptsIndex(const QModelIndex& index) const override;
+
+    void setReferenceItem(const KFileItem& item);
+
+    void setMaxDistance(int distance);
+
+private:
+    bool findHash(const KFileItem& item, quint64* hash) const;
+    void requestHashes();
+
+    KFileItem mReferenceItem;
+    int mMaxDistance;
+    QPointer<ThumbnailProvider> mThumbnailProvider;
+    QTimer* mRequestTimer;
+    QTimer* mApplyTimer;
+    // acceptsIndex() is const, but it queues the items it cannot decide on
+    mutable KFileItemList mPendingItems;
+    mutable QSet<QUrl> mRequestedUrls;
+};
+
+class SimilarityFilterWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    SimilarityFilterWidget(SortedDirModel*, const KFileItem& referenceItem);
+    ~SimilarityFilterWidget() override;
+
+private Q_SLOTS:
+    void applySimilarityFilter();
+
+private:
+    QPointer<SimilarityFilter> mFilter;
+    KComboBox* mModeComboBox;
+    QLabel* mLabel;
+};
+
+
 #ifndef GWENVIEW_SEMANTICINFO_BACKEND_NONE
 /**
  * An AbstractSortedDirModelFilter which filters on file ratings
@@ -339,13 +400,18 @@ class FilterController : public QObject
 {
     Q_OBJECT
 public:
-    FilterController(QFrame* filterFrame, SortedDirModel* model);
+    /**
+     * @p view is used to find the reference image of the similarity filter
+     */
+    FilterController(QFrame* filterFrame, SortedDirModel* model, QAbstractItemView* view);
 
     QList<QAction*> actionList() const;
 
 private Q_SLOTS:
     void addFilterByName();
     void addFilterByDate();
+    void addFilterBySimilarity();
+    void updateSimilarityAction();
 #ifndef GWENVIEW_SEMANTICINFO_BACKEND_NONE
     void addFilterByRating();
     void addFilterByTag();
@@ -353,13 +419,16 @@ private Q_SLOTS:
     void slotFilterWidgetClosed();
 
 private:
-    void addAction(const QString& text, const char* slot);
+    QAction* addAction(const QString& text, const char* slot);
     void addFilter(QWidget* widget);
 
     FilterController* q;
     QFrame* mFrame;
     SortedDirModel* mDirModel;
+    QAbstractItemView* mView;
     QList<QAction*> mActionList;
+    /// Disabled when the current item is not a raster image
+    QAction* mSimilarityAction;
 
     int mFilterWidgetCount; /**< How many filter widgets are in mFrame */
 };
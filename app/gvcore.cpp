@@ -24,6 +24,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 
 // Qt
 #include <QApplication>
+#include <QEventLoop>
+#include <QPointer>
 #include <QUrl>
 #include <QImageWriter>
 #include <QMimeDatabase>
@@ -65,6 +67,16 @@ struct GvCorePrivate
     RecentFilesModel* mRecentFilesModel;
     QPalette mPalettes[4];
     QString mFullScreenPaletteName;
+    QPointer<SaveAllHelper> mSaveAllHelper;
+
+    SaveAllHelper* saveAllHelper()
+    {
+        // A finished helper is about to be deleted, it cannot save anything
+        if (!mSaveAllHelper || mSaveAllHelper->isFinished()) {
+            mSaveAllHelper = new SaveAllHelper(mMainWindow);
+        }
+        return mSaveAllHelper;
+    }
 
     bool showSaveAsDialog(const QUrl &url, QUrl* outUrl, QByteArray* format)
     {
@@ -324,8 +336,22 @@ void GvCore::addUrlToRecentFiles(const QUrl &url)
 
 void GvCore::saveAll()
 {
-    SaveAllHelper helper(d->mMainWindow);
-    helper.save();
+    // Documents are saved in the background: if a previous request is still
+    // running, the documents modified since then are added to it
+    d->saveAllHelper()->save();
+}
+
+void GvCore::saveAllAndWait()
+{
+    QPointer<SaveAllHelper> helper = d->saveAllHelper();
+    helper->setModal(true);
+    QEventLoop loop;
+    connect(helper.data(), &SaveAllHelper::finished, &loop, &QEventLoop::quit);
+    helper->save();
+    // finish() may have been called synchronously, before the loop runs
+    if (helper && !helper->isFinished()) {
+        loop.exec();
+    }
 }
 
 void GvCore::save(const QUrl &url)
@@ -69,6 +69,11 @@ public:
     QPalette palette(PaletteType type) const;
     QString fullScreenPaletteName() const;
 
+    /**
+     * Like saveAll(), but returns once all documents have been saved
+     */
+    void saveAllAndWait();
+
 public Q_SLOTS:
     void saveAll();
     void save(const QUrl&);
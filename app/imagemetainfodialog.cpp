@@ -108,7 +108,12 @@ protected:
 private:
     void setUpRootIndex(int row)
     {
-        expand(model()->index(row, 0));
+        // Groups are filled on demand, and expand() does not fetch them if
+        // the view has not been laid out yet. Fetching an empty group is
+        // not useless: it gets filled when its meta info is loaded.
+        const QModelIndex index = model()->index(row, 0);
+        model()->fetchMore(index);
+        expand(index);
         setFirstColumnSpanned(row, QModelIndex(), true);
     }
 };
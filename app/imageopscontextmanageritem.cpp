@@ -242,7 +242,7 @@ void ImageOpsContextManagerItem::resizeImage()
     if (!dialog->exec()) {
         return;
     }
-    ResizeImageOperation* op = new ResizeImageOperation(dialog->size());
+    ResizeImageOperation* op = new ResizeImageOperation(dialog->size(), dialog->filter());
     applyImageOperation(op);
 }
 
@@ -38,7 +38,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <lib/eventwatcher.h>
 #include <lib/gvdebug.h>
 #include <lib/gwenviewconfig.h>
+#include <lib/metainfoprovider.h>
 #include <lib/preferredimagemetainfomodel.h>
+#include <lib/urlutils.h>
 #include <lib/document/document.h>
 #include <lib/document/documentfactory.h>
 
@@ -201,6 +203,12 @@ struct InfoContextManagerItemPrivate
     KeyValueWidget* mKeyValueWidget;
     Document::Ptr mDocument;
 
+    // Used instead of mDocument when the file is not loaded: reading its
+    // headers is much cheaper than loading it
+    QUrl mMetaInfoUrl;
+    QDateTime mMetaInfoModificationTime;
+    MetaInfoProvider::ModelPtr mMetaInfo;
+
     // Multiple selection fields
     QLabel* mMultipleFilesLabel;
 
@@ -211,8 +219,12 @@ struct InfoContextManagerItemPrivate
         if (!mImageMetaInfoDialog) {
             return;
         }
-        ImageMetaInfoModel* model = mDocument ? mDocument->metaInfo() : nullptr;
-        mImageMetaInfoDialog->setMetaInfo(model, GwenviewConfig::preferredMetaInfoKeyList());
+        mImageMetaInfoDialog->setMetaInfo(metaInfoModel(), GwenviewConfig::preferredMetaInfoKeyList());
+    }
+
+    ImageMetaInfoModel* metaInfoModel() const
+    {
+        return mDocument ? mDocument->metaInfo() : mMetaInfo.data();
     }
 
     void setupGroup()
@@ -255,6 +267,8 @@ struct InfoContextManagerItemPrivate
             // "Garbage collect" document
             mDocument = nullptr;
         }
+        mMetaInfoUrl.clear();
+        mMetaInfo.clear();
     }
 };
 
@@ -268,6 +282,8 @@ InfoContextManagerItem::InfoContextManagerItem(ContextManager* manager)
             SLOT(updateSideBarContent()));
     connect(contextManager(), SIGNAL(selectionDataChanged()),
             SLOT(updateSideBarContent()));
+    connect(MetaInfoProvider::instance(), &MetaInfoProvider::metaInfoLoaded,
+            this, &InfoContextManagerItem::slotMetaInfoLoaded);
 }
 
 InfoContextManagerItem::~InfoContextManagerItem()
@@ -308,10 +324,35 @@ void InfoContextManagerItem::fillOneFileGroup(const KFileItem& item)
     d->mMultipleFilesLabel->hide();
 
     d->forgetCurrentDocument();
-    d->mDocument = DocumentFactory::instance()->load(item.url());
-    connect(d->mDocument.data(), SIGNAL(metaInfoUpdated()),
-            SLOT(updateOneFileInfo()));
+    const QUrl url = item.url();
+    // Only use the document if it has already been loaded: loading it just
+    // to show its meta info would read the whole file and could evict more
+    // useful documents from the DocumentFactory cache
+    d->mDocument = DocumentFactory::instance()->getCachedDocument(url);
+    if (!d->mDocument && !UrlUtils::urlIsFastLocalFile(url)) {
+        // Reading the headers of a remote file is not cheaper than loading it
+        d->mDocument = DocumentFactory::instance()->load(url);
+    }
+
+    if (d->mDocument) {
+        connect(d->mDocument.data(), SIGNAL(metaInfoUpdated()),
+                SLOT(updateOneFileInfo()));
+    } else {
+        d->mMetaInfoUrl = url;
+        d->mMetaInfoModificationTime = item.time(KFileItem::ModificationTime);
+        d->mMetaInfo = MetaInfoProvider::instance()->metaInfo(url, d->mMetaInfoModificationTime);
+    }
+
+    d->updateMetaInfoDialog();
+    updateOneFileInfo();
+}
 
+void InfoContextManagerItem::slotMetaInfoLoaded(const QUrl& url)
+{
+    if (d->mDocument || url != d->mMetaInfoUrl) {
+        return;
+    }
+    d->mMetaInfo = MetaInfoProvider::instance()->metaInfo(url, d->mMetaInfoModificationTime);
     d->updateMetaInfoDialog();
     updateOneFileInfo();
 }
@@ -343,12 +384,13 @@ void InfoContextManagerItem::fillMultipleItemsGroup(const KFileItemList& itemLis
 
 void InfoContextManagerItem::updateOneFileInfo()
 {
-    if (!d->mDocument) {
+    ImageMetaInfoModel* metaInfoModel = d->metaInfoModel();
+    d->mKeyValueWidget->clear();
+    if (!metaInfoModel) {
+        // Still being read
+        d->mKeyValueWidget->layoutRows();
         return;
     }
-
-    ImageMetaInfoModel* metaInfoModel = d->mDocument->metaInfo();
-    d->mKeyValueWidget->clear();
     Q_FOREACH(const QString & key, GwenviewConfig::preferredMetaInfoKeyList()) {
         QString label;
         QString value;
@@ -369,7 +411,7 @@ void InfoContextManagerItem::showMetaInfoDialog()
         connect(d->mImageMetaInfoDialog, SIGNAL(preferredMetaInfoKeyListChanged(QStringList)),
                 SLOT(slotPreferredMetaInfoKeyListChanged(QStringList)));
     }
-    d->mImageMetaInfoDialog->setMetaInfo(d->mDocument ? d->mDocument->metaInfo() : nullptr, GwenviewConfig::preferredMetaInfoKeyList());
+    d->mImageMetaInfoDialog->setMetaInfo(d->metaInfoModel(), GwenviewConfig::preferredMetaInfoKeyList());
     d->mImageMetaInfoDialog->show();
 }
 
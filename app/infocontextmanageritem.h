@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "abstractcontextmanageritem.h"
 
 class QStringList;
+class QUrl;
 class KFileItem;
 class KFileItemList;
 
@@ -44,6 +45,7 @@ public:
 private Q_SLOTS:
     void updateSideBarContent();
     void updateOneFileInfo();
+    void slotMetaInfoLoaded(const QUrl&);
     void showMetaInfoDialog();
     void slotPreferredMetaInfoKeyListChanged(const QStringList&);
 
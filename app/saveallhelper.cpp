@@ -22,13 +22,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include "saveallhelper.h"
 
 // Qt
-#include <QFuture>
-#include <QFutureWatcher>
+#include <QDebug>
+#include <QHash>
 #include <QSet>
 #include <QStringList>
 #include <QUrl>
 #include <QProgressDialog>
 
+// STL
+#include <algorithm>
+
 // KDE
 #include <KLocalizedString>
 #include <KMessageBox>
@@ -37,22 +40,52 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include <lib/document/document.h>
 #include <lib/document/documentfactory.h>
 #include <lib/document/documentjob.h>
+#include <lib/gwenviewconfig.h>
+#include <lib/memorypressuremonitor.h>
 
 namespace Gwenview
 {
 
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+/**
+ * Estimates the memory needed to save @p doc: encoders work on copies of
+ * the image, and JPEG documents are encoded to a buffer before being
+ * written
+ */
+static qint64 saveCost(const Document::Ptr& doc)
+{
+    const QImage& image = doc->image();
+    return 2 * qint64(image.bytesPerLine()) * image.height();
+}
+
 struct SaveAllHelperPrivate
 {
     QWidget* mParent;
     QProgressDialog* mProgressDialog;
-    QSet<DocumentJob*> mJobSet;
+    // Documents waiting to be saved, smallest first, with their cost
+    QList<QPair<Document::Ptr, qint64> > mPendingDocuments;
+    // Running jobs, with their cost
+    QHash<DocumentJob*, qint64> mJobs;
+    qint64 mRunningCost;
     QStringList mErrorList;
+    bool mFinished;
 };
 
 SaveAllHelper::SaveAllHelper(QWidget* parent)
-: d(new SaveAllHelperPrivate)
+: QObject(parent)
+, d(new SaveAllHelperPrivate)
 {
     d->mParent = parent;
+    d->mRunningCost = 0;
+    d->mFinished = false;
     d->mProgressDialog = new QProgressDialog(parent);
     connect(d->mProgressDialog, &QProgressDialog::canceled, this, &SaveAllHelper::slotCanceled);
     d->mProgressDialog->setLabelText(i18nc("@info:progress saving all image changes", "Saving..."));
@@ -62,22 +95,107 @@ SaveAllHelper::SaveAllHelper(QWidget* parent)
 
 SaveAllHelper::~SaveAllHelper()
 {
+    delete d->mProgressDialog;
     delete d;
 }
 
+void SaveAllHelper::setModal(bool modal)
+{
+    // Qt ignores modality changes on visible windows
+    const bool visible = d->mProgressDialog->isVisible();
+    if (visible) {
+        d->mProgressDialog->hide();
+    }
+    d->mProgressDialog->setWindowModality(modal ? Qt::ApplicationModal : Qt::NonModal);
+    if (visible) {
+        d->mProgressDialog->show();
+    }
+}
+
+bool SaveAllHelper::isFinished() const
+{
+    return d->mFinished;
+}
+
 void SaveAllHelper::save()
 {
-    QList<QUrl> list = DocumentFactory::instance()->modifiedDocumentList();
-    d->mProgressDialog->setRange(0, list.size());
-    d->mProgressDialog->setValue(0);
-    Q_FOREACH(const QUrl &url, list) {
-        Document::Ptr doc = DocumentFactory::instance()->load(url);
-        DocumentJob* job = doc->save(url, doc->format());
+    if (d->mFinished) {
+        return;
+    }
+    // Skip documents which are already waiting or being saved
+    QSet<QUrl> knownUrls;
+    for (const auto& pair : qAsConst(d->mPendingDocuments)) {
+        knownUrls << pair.first->url();
+    }
+    for (DocumentJob* job : d->mJobs.keys()) {
+        knownUrls << job->document()->url();
+    }
+
+    int addedCount = 0;
+    const QList<QUrl> list = DocumentFactory::instance()->modifiedDocumentList();
+    for (const QUrl& url : list) {
+        if (knownUrls.contains(url)) {
+            continue;
+        }
+        const Document::Ptr doc = DocumentFactory::instance()->load(url);
+        d->mPendingDocuments << qMakePair(doc, saveCost(doc));
+        ++addedCount;
+    }
+    // Small documents first: they fit in the memory budget together and
+    // progress shows up quickly
+    std::stable_sort(d->mPendingDocuments.begin(), d->mPendingDocuments.end(),
+        [](const QPair<Document::Ptr, qint64>& doc1, const QPair<Document::Ptr, qint64>& doc2) {
+            return doc1.second < doc2.second;
+        });
+
+    if (d->mProgressDialog->isVisible()) {
+        d->mProgressDialog->setMaximum(d->mProgressDialog->maximum() + addedCount);
+    } else {
+        d->mProgressDialog->setRange(0, addedCount);
+        d->mProgressDialog->setValue(0);
+        d->mProgressDialog->show();
+    }
+    startJobs();
+}
+
+void SaveAllHelper::startJobs()
+{
+    if (d->mFinished) {
+        return;
+    }
+    // Save one document at a time when memory is short
+    const int maxJobCount = MemoryPressureMonitor::instance()->level() == MemoryPressureMonitor::CriticalPressure
+        ? 1
+        : qMax(GwenviewConfig::saveAllMaxJobCount(), 1);
+    const qint64 memoryBudget = qint64(GwenviewConfig::saveAllMemoryBudget()) * 1024 * 1024;
+
+    while (!d->mPendingDocuments.isEmpty() && d->mJobs.count() < maxJobCount) {
+        const qint64 cost = d->mPendingDocuments.first().second;
+        // A document larger than the budget is saved on its own
+        if (!d->mJobs.isEmpty() && d->mRunningCost + cost > memoryBudget) {
+            break;
+        }
+        const Document::Ptr doc = d->mPendingDocuments.takeFirst().first;
+        LOG("Saving" << doc->url() << "cost:" << cost << "running:" << d->mJobs.count());
+        DocumentJob* job = doc->save(doc->url(), doc->format());
         connect(job, &DocumentJob::result, this, &SaveAllHelper::slotResult);
-        d->mJobSet << job;
+        d->mJobs.insert(job, cost);
+        d->mRunningCost += cost;
+
+        const QUrl url = doc->url();
+        const QString name = url.fileName().isEmpty() ? url.toDisplayString() : url.fileName();
+        d->mProgressDialog->setLabelText(i18nc("@info:progress saving all image changes, %1 is a file name", "Saving %1...", name));
     }
 
-    d->mProgressDialog->exec();
+    if (d->mJobs.isEmpty() && d->mPendingDocuments.isEmpty()) {
+        finish();
+    }
+}
+
+void SaveAllHelper::finish()
+{
+    d->mFinished = true;
+    d->mProgressDialog->hide();
 
     // Done, show message if necessary
     if (d->mErrorList.count() > 0) {
@@ -89,13 +207,24 @@ void SaveAllHelper::save()
         msg += "</ul>";
         KMessageBox::sorry(d->mParent, msg);
     }
+    emit finished();
+    deleteLater();
 }
 
 void SaveAllHelper::slotCanceled()
 {
-    Q_FOREACH(DocumentJob * job, d->mJobSet) {
+    if (d->mFinished) {
+        return;
+    }
+    d->mPendingDocuments.clear();
+    // Killed jobs do not emit result()
+    const QList<DocumentJob*> jobs = d->mJobs.keys();
+    d->mJobs.clear();
+    d->mRunningCost = 0;
+    for (DocumentJob* job : jobs) {
         job->kill();
     }
+    finish();
 }
 
 void SaveAllHelper::slotResult(KJob* _job)
@@ -107,8 +236,9 @@ void SaveAllHelper::slotResult(KJob* _job)
         d->mErrorList << xi18nc("@info %1 is the name of the document which failed to save, %2 is the reason for the failure",
                                 "<filename>%1</filename>: %2", name, kxi18n(qPrintable(job->errorString())));
     }
-    d->mJobSet.remove(job);
+    d->mRunningCost -= d->mJobs.take(job);
     d->mProgressDialog->setValue(d->mProgressDialog->value() + 1);
+    startJobs();
 }
 
 } // namespace
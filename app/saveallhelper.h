@@ -34,6 +34,15 @@ namespace Gwenview
 {
 
 struct SaveAllHelperPrivate;
+/**
+ * Saves all modified documents in the background, showing progress in a
+ * non-modal dialog. The helper deletes itself once done.
+ *
+ * Documents are saved smallest first. At most GwenviewConfig::saveAllMaxJobCount()
+ * of them are saved at the same time, and only as many as fit in
+ * GwenviewConfig::saveAllMemoryBudget(), so that saving many images does
+ * not exhaust memory or thrash the disk.
+ */
 class SaveAllHelper : public QObject
 {
     Q_OBJECT
@@ -41,14 +50,35 @@ public:
     explicit SaveAllHelper(QWidget* parent);
     ~SaveAllHelper() override;
 
+    /**
+     * Saves the modified documents. Can be called again while documents are
+     * being saved, to save the documents modified since the previous call.
+     */
     void save();
 
+    /**
+     * Makes the progress dialog modal, for callers which need to wait for
+     * the documents to be saved
+     */
+    void setModal(bool modal);
+
+    /**
+     * Returns true once all documents have been saved or saving has been
+     * stopped. The helper is then about to be deleted.
+     */
+    bool isFinished() const;
+
+Q_SIGNALS:
+    void finished();
+
 private Q_SLOTS:
     void slotCanceled();
     void slotResult(KJob*);
 
 private:
     SaveAllHelperPrivate* const d;
+    void startJobs();
+    void finish();
 };
 
 } // namespace
@@ -0,0 +1,194 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "animationinfo.h"
+
+// Qt
+#include <QDebug>
+#include <QtEndian>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+namespace AnimationInfo
+{
+
+static bool reachedMax(int count, int maxFrames)
+{
+    return maxFrames > 0 && count >= maxFrames;
+}
+
+/**
+ * Skips GIF data sub-blocks, starting at @p pos. Returns the position after
+ * the block terminator, or -1 if the data is truncated.
+ */
+static int skipGifSubBlocks(const QByteArray& data, int pos)
+{
+    while (pos < data.size()) {
+        const int size = quint8(data[pos]);
+        ++pos;
+        if (size == 0) {
+            return pos;
+        }
+        pos += size;
+    }
+    return -1;
+}
+
+static int gifFrameCount(const QByteArray& data, int maxFrames)
+{
+    // Header and logical screen descriptor
+    int pos = 13;
+    if (data.size() < pos) {
+        return -1;
+    }
+    const quint8 flags = data[10];
+    if (flags & 0x80) {
+        // Global color table
+        pos += 3 * (1 << ((flags & 0x07) + 1));
+    }
+
+    int count = 0;
+    while (pos < data.size() && !reachedMax(count, maxFrames)) {
+        const quint8 introducer = data[pos];
+        if (introducer == 0x21) {
+            // Extension: label, then sub-blocks
+            pos = skipGifSubBlocks(data, pos + 2);
+        } else if (introducer == 0x2C) {
+            // Image descriptor
+            if (pos + 10 > data.size()) {
+                break;
+            }
+            const quint8 imageFlags = data[pos + 9];
+            pos += 10;
+            if (imageFlags & 0x80) {
+                // Local color table
+                pos += 3 * (1 << ((imageFlags & 0x07) + 1));
+            }
+            // LZW minimum code size, then sub-blocks
+            pos = skipGifSubBlocks(data, pos + 1);
+            if (pos == -1) {
+                // Count truncated frames, the decoder shows what it can
+                ++count;
+                break;
+            }
+            ++count;
+        } else if (introducer == 0x3B) {
+            // Trailer
+            break;
+        } else {
+            LOG("Unexpected GIF block" << introducer);
+            return count > 0 ? count : -1;
+        }
+        if (pos == -1) {
+            break;
+        }
+    }
+    return count > 0 ? count : -1;
+}
+
+static int pngFrameCount(const QByteArray& data)
+{
+    // Chunks: length (4), type (4), data, crc (4). acTL must come before
+    // the first IDAT chunk.
+    int pos = 8;
+    while (pos + 8 <= data.size()) {
+        const quint32 length = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data.constData() + pos));
+        const QByteArray type = data.mid(pos + 4, 4);
+        if (type == "acTL") {
+            if (pos + 12 > data.size()) {
+                return -1;
+            }
+            return int(qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data.constData() + pos + 8)));
+        }
+        if (type == "IDAT") {
+            return 1;
+        }
+        if (length > quint32(data.size())) {
+            return -1;
+        }
+        pos += 12 + length;
+    }
+    return -1;
+}
+
+static int webpFrameCount(const QByteArray& data, int maxFrames)
+{
+    // RIFF header, then chunks: fourcc (4), size (4, little endian), data
+    // padded to an even size
+    int pos = 12;
+    int count = 0;
+    bool animated = false;
+    while (pos + 8 <= data.size() && !reachedMax(count, maxFrames)) {
+        const QByteArray fourcc = data.mid(pos, 4);
+        const quint32 size = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data.constData() + pos + 4));
+        if (fourcc == "VP8X") {
+            if (pos + 9 > data.size()) {
+                return -1;
+            }
+            animated = quint8(data[pos + 8]) & 0x02;
+            if (!animated) {
+                return 1;
+            }
+        } else if (fourcc == "VP8 " || fourcc == "VP8L") {
+            // Still image bitstream
+            return animated ? -1 : 1;
+        } else if (fourcc == "ANMF") {
+            ++count;
+        }
+        if (size > quint32(data.size())) {
+            break;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return count > 0 ? count : -1;
+}
+
+int frameCount(const QByteArray& data, int maxFrames)
+{
+    if (data.startsWith("GIF87a") || data.startsWith("GIF89a")) {
+        return gifFrameCount(data, maxFrames);
+    }
+    if (data.startsWith("\x89PNG\r\n\x1a\n")) {
+        return pngFrameCount(data);
+    }
+    if (data.startsWith("RIFF") && data.mid(8, 4) == "WEBP") {
+        return webpFrameCount(data, maxFrames);
+    }
+    return -1;
+}
+
+} // namespace
+
+} // namespace
@@ -0,0 +1,56 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef ANIMATIONINFO_H
+#define ANIMATIONINFO_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QByteArray>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+/**
+ * Counts the frames of GIF, APNG and WebP images by walking the blocks of
+ * their container, without decoding any pixel.
+ */
+namespace AnimationInfo
+{
+
+/**
+ * Returns the number of frames of the image stored in @p data, stopping at
+ * @p maxFrames frames if it is > 0. The format is detected from the content.
+ *
+ * Returns 1 for PNG and WebP images which are not animated, and -1 if the
+ * format is not supported or the data cannot be parsed.
+ */
+GWENVIEWLIB_EXPORT int frameCount(const QByteArray& data, int maxFrames = 0);
+
+} // namespace
+
+} // namespace
+
+#endif /* ANIMATIONINFO_H */
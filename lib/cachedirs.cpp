@@ -0,0 +1,78 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "cachedirs.h"
+
+// Qt
+#include <QHash>
+#include <QMutex>
+#include <QStandardPaths>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+namespace CacheDirs
+{
+
+struct Registry
+{
+    Registry()
+    : mBaseDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/gwenview/"))
+    {}
+
+    QMutex mMutex;
+    const QString mBaseDir;
+    QHash<QString, QString> mCustomPaths;
+};
+
+Q_GLOBAL_STATIC(Registry, sRegistry)
+
+QString path(const QString& name)
+{
+    Registry* registry = sRegistry;
+    QMutexLocker locker(&registry->mMutex);
+    const QString customPath = registry->mCustomPaths.value(name);
+    if (!customPath.isEmpty()) {
+        return customPath;
+    }
+    return registry->mBaseDir + name + QLatin1Char('/');
+}
+
+void setPath(const QString& name, const QString& dir)
+{
+    Registry* registry = sRegistry;
+    QMutexLocker locker(&registry->mMutex);
+    if (dir.isEmpty()) {
+        registry->mCustomPaths.remove(name);
+    } else if (dir.endsWith(QLatin1Char('/'))) {
+        registry->mCustomPaths.insert(name, dir);
+    } else {
+        registry->mCustomPaths.insert(name, dir + QLatin1Char('/'));
+    }
+}
+
+} // namespace
+
+} // namespace
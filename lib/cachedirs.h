@@ -0,0 +1,58 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef CACHEDIRS_H
+#define CACHEDIRS_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QString>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+/**
+ * Directories of the caches Gwenview maintains itself, stored in
+ * $XDG_CACHE_HOME/gwenview. These functions are thread-safe.
+ */
+namespace CacheDirs
+{
+
+/**
+ * Returns the path of cache @p name, ending with a slash
+ */
+GWENVIEWLIB_EXPORT QString path(const QString& name);
+
+/**
+ * Stores cache @p name in @p dir instead, useful for unit-testing. An empty
+ * @p dir restores the default path.
+ */
+GWENVIEWLIB_EXPORT void setPath(const QString& name, const QString& dir);
+
+} // namespace
+
+} // namespace
+
+#endif /* CACHEDIRS_H */
@@ -37,6 +37,8 @@ extern "C" {
 // Qt
 #include <QBuffer>
 #include <QDebug>
+#include <QImage>
+#include <QVector>
 #include <QtGlobal>
 
 // lcms
@@ -251,6 +253,150 @@ Profile::Ptr Profile::getSRgbProfile()
     return Profile::Ptr(new Profile(cmsCreate_sRGBProfile()));
 }
 
+Profile::Ptr Profile::getGrayProfile()
+{
+    const cmsCIExyY whitePoint = {0.3127, 0.3290, 1.0};
+    // Parameters of the sRGB tone curve, as used by cmsCreate_sRGBProfile()
+    const cmsFloat64Number parameters[5] = {2.4, 1. / 1.055, 0.055 / 1.055, 1. / 12.92, 0.04045};
+    cmsToneCurve* curve = cmsBuildParametricToneCurve(nullptr, 4, parameters);
+    cmsHPROFILE hProfile = cmsCreateGrayProfile(&whitePoint, curve);
+    cmsFreeToneCurve(curve);
+    return Profile::Ptr(new Profile(hProfile));
+}
+
+bool Profile::isGray() const
+{
+    return d->mProfile && cmsGetColorSpace(d->mProfile) == cmsSigGrayData;
+}
+
+//- Image transformation -------------------------------------------------------
+static cmsHTRANSFORM createTransform(const Profile::Ptr& profile, cmsUInt32Number inputType,
+                                     const Profile::Ptr& outputProfile, cmsUInt32Number outputType,
+                                     quint32 renderingIntent)
+{
+    return cmsCreateTransform(profile->handle(), inputType,
+                              outputProfile->handle(), outputType,
+                              renderingIntent, cmsFLAGS_BLACKPOINTCOMPENSATION);
+}
+
+/**
+ * Transforms the lines of @p image in place. Lines are transformed one by
+ * one, because the lines of 8 and 16 bit images may be padded.
+ */
+static void transformLines(cmsHTRANSFORM transform, QImage* image)
+{
+    const int width = image->width();
+    for (int y = 0; y < image->height(); ++y) {
+        uchar* line = image->scanLine(y);
+        cmsDoTransform(transform, line, line, width);
+    }
+}
+
+bool transformImage(QImage* image, const Profile::Ptr& profile, const Profile::Ptr& outputProfile, quint32 renderingIntent)
+{
+    GV_RETURN_VALUE_IF_FAIL(profile && outputProfile, false);
+    const bool grayInput = profile->isGray();
+    const bool grayOutput = outputProfile->isGray();
+
+    cmsUInt32Number grayType;
+    switch (image->format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    {
+        if (grayInput || grayOutput) {
+            return false;
+        }
+        cmsHTRANSFORM transform = createTransform(profile, TYPE_BGRA_8, outputProfile, TYPE_BGRA_8, renderingIntent);
+        if (!transform) {
+            return false;
+        }
+        transformLines(transform, image);
+        cmsDeleteTransform(transform);
+        return true;
+    }
+
+    case QImage::Format_Indexed8:
+    {
+        if (grayOutput) {
+            return false;
+        }
+        QVector<QRgb> colorTable = image->colorTable();
+        if (!grayInput) {
+            cmsHTRANSFORM transform = createTransform(profile, TYPE_BGRA_8, outputProfile, TYPE_BGRA_8, renderingIntent);
+            if (!transform) {
+                return false;
+            }
+            cmsDoTransform(transform, colorTable.data(), colorTable.data(), colorTable.size());
+            cmsDeleteTransform(transform);
+        } else {
+            cmsHTRANSFORM transform = createTransform(profile, TYPE_GRAY_8, outputProfile, TYPE_BGRA_8, renderingIntent);
+            if (!transform) {
+                return false;
+            }
+            QVector<quint8> grays(colorTable.size());
+            for (int idx = 0; idx < colorTable.size(); ++idx) {
+                grays[idx] = quint8(qGray(colorTable.at(idx)));
+            }
+            // lcms does not write the alpha byte
+            QVector<QRgb> rgbs = colorTable;
+            cmsDoTransform(transform, grays.constData(), rgbs.data(), rgbs.size());
+            cmsDeleteTransform(transform);
+            colorTable = rgbs;
+        }
+        image->setColorTable(colorTable);
+        return true;
+    }
+
+    case QImage::Format_Grayscale8:
+        grayType = TYPE_GRAY_8;
+        break;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    case QImage::Format_Grayscale16:
+        grayType = TYPE_GRAY_16;
+        break;
+#endif
+
+    default:
+        return false;
+    }
+
+    if (!grayInput) {
+        // An RGB profile on gray pixels
+        if (grayOutput) {
+            return false;
+        }
+        *image = image->convertToFormat(QImage::Format_RGB32);
+        return transformImage(image, profile, outputProfile, renderingIntent);
+    }
+
+    if (grayOutput) {
+        cmsHTRANSFORM transform = createTransform(profile, grayType, outputProfile, grayType, renderingIntent);
+        if (!transform) {
+            return false;
+        }
+        transformLines(transform, image);
+        cmsDeleteTransform(transform);
+        return true;
+    }
+
+    cmsHTRANSFORM transform = createTransform(profile, grayType, outputProfile, TYPE_BGRA_8, renderingIntent);
+    if (!transform) {
+        return false;
+    }
+    QImage result(image->size(), QImage::Format_RGB32);
+    // lcms does not write the alpha byte
+    result.fill(Qt::black);
+    const int width = image->width();
+    for (int y = 0; y < image->height(); ++y) {
+        cmsDoTransform(transform, image->constScanLine(y), result.scanLine(y), width);
+    }
+    cmsDeleteTransform(transform);
+    result.setDotsPerMeterX(image->dotsPerMeterX());
+    result.setDotsPerMeterY(image->dotsPerMeterY());
+    *image = result;
+    return true;
+}
+
 } // namespace Cms
 
 } // namespace Gwenview
@@ -33,6 +33,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include <exiv2/image.hpp>
 
 class QByteArray;
+class QImage;
 class QString;
 
 typedef void* cmsHPROFILE;
@@ -67,11 +68,32 @@ public:
     static Profile::Ptr getMonitorProfile();
     static Profile::Ptr getSRgbProfile();
 
+    /**
+     * Returns a gray profile with the white point and tone curve of sRGB,
+     * for grayscale images without a profile
+     */
+    static Profile::Ptr getGrayProfile();
+
+    bool isGray() const;
+
 private:
     Profile(cmsHPROFILE);
     ProfilePrivate* const d;
 };
 
+/**
+ * Converts the colors of @p image from @p profile to @p outputProfile.
+ *
+ * RGB32, ARGB32, Indexed8 and grayscale images are supported. The color
+ * table of Indexed8 images is converted instead of their pixels. lcms can
+ * only convert gray pixels in place between two gray profiles: grayscale
+ * images are converted to RGB32 when either profile is an RGB profile.
+ *
+ * Returns false if @p image has an unsupported format, or if its pixels do
+ * not match the color space of the profiles.
+ */
+GWENVIEWLIB_EXPORT bool transformImage(QImage* image, const Profile::Ptr& profile, const Profile::Ptr& outputProfile, quint32 renderingIntent);
+
 } // namespace Cms
 } // namespace Gwenview
 
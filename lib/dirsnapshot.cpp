@@ -0,0 +1,222 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "dirsnapshot.h"
+
+#include <sys/types.h>
+#include <utime.h>
+
+// Qt
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QUrl>
+
+// KDE
+#include <kio_version.h>
+
+// Local
+#include "cachedirs.h"
+#include "timeutils.h"
+#include "tracing.h"
+
+namespace Gwenview
+{
+
+namespace DirSnapshot
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+static const quint32 SNAPSHOT_MAGIC = 0x47564453; // "GVDS"
+static const quint32 SNAPSHOT_VERSION = 1;
+
+static const int MAX_SNAPSHOTS = 20;
+
+/**
+ * Lower bound of the size of a serialized entry: the field count of the
+ * UDSEntry and the date
+ */
+static const int MIN_ENTRY_SIZE = 16;
+
+QString cacheDir()
+{
+    return CacheDirs::path(QStringLiteral("dirsnapshots"));
+}
+
+void setCacheDir(const QString& dir)
+{
+    CacheDirs::setPath(QStringLiteral("dirsnapshots"), dir);
+}
+
+static QString snapshotUrlString(const QUrl& dirUrl)
+{
+    return dirUrl.adjusted(QUrl::StripTrailingSlash).toString(QUrl::FullyEncoded);
+}
+
+static QString snapshotPath(const QUrl& dirUrl)
+{
+    QCryptographicHash md5(QCryptographicHash::Md5);
+    md5.addData(snapshotUrlString(dirUrl).toUtf8());
+    return cacheDir() + QString::fromLatin1(md5.result().toHex()) + QStringLiteral(".snapshot");
+}
+
+/**
+ * Removes the least recently used snapshots until there are no more than
+ * MAX_SNAPSHOTS
+ */
+static void evictSnapshots()
+{
+    QDir dir(cacheDir());
+    const QFileInfoList list = dir.entryInfoList(QStringList() << QStringLiteral("*.snapshot"), QDir::Files, QDir::Time | QDir::Reversed);
+    for (int idx = 0; idx < list.size() - MAX_SNAPSHOTS; ++idx) {
+        LOG("Evicting" << list.at(idx).fileName());
+        QFile::remove(list.at(idx).absoluteFilePath());
+    }
+}
+
+EntryList entriesForItems(const KFileItemList& items)
+{
+    EntryList entries;
+    entries.reserve(items.count());
+    for (const KFileItem& item : items) {
+        Entry entry;
+        entry.entry = item.entry();
+        // Store the mime type, so that it does not have to be determined
+        // again when the snapshot is loaded
+        if (!entry.entry.contains(KIO::UDSEntry::UDS_MIME_TYPE) && item.isMimeTypeKnown()) {
+#if KIO_VERSION >= QT_VERSION_CHECK(5, 48, 0)
+            entry.entry.replace(KIO::UDSEntry::UDS_MIME_TYPE, item.mimetype());
+#else
+            entry.entry.insert(KIO::UDSEntry::UDS_MIME_TYPE, item.mimetype());
+#endif
+        }
+        entry.dateTime = TimeUtils::cachedDateTimeForFileItem(item);
+        entries << entry;
+    }
+    return entries;
+}
+
+void store(const QUrl& dirUrl, const EntryList& entries)
+{
+    TraceSpan span("dirSnapshotStore", dirUrl);
+    if (!QDir().mkpath(cacheDir())) {
+        qWarning() << "Could not create folder snapshot dir" << cacheDir();
+        return;
+    }
+    QSaveFile file(snapshotPath(dirUrl));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not store snapshot of" << dirUrl;
+        return;
+    }
+    QDataStream stream(&file);
+    stream << SNAPSHOT_MAGIC << SNAPSHOT_VERSION
+           << snapshotUrlString(dirUrl)
+           << qint32(entries.count());
+    for (const Entry& entry : entries) {
+        stream << entry.entry << entry.dateTime;
+    }
+    if (!file.commit()) {
+        qWarning() << "Could not store snapshot of" << dirUrl;
+        return;
+    }
+    LOG("Stored" << entries.count() << "entries for" << dirUrl);
+    evictSnapshots();
+}
+
+KFileItemList load(const QUrl& dirUrl)
+{
+    TraceSpan span("dirSnapshotLoad", dirUrl);
+    const QString path = snapshotPath(dirUrl);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return KFileItemList();
+    }
+    QDataStream stream(&file);
+    quint32 magic, version;
+    QString urlString;
+    qint32 count;
+    stream >> magic >> version;
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+        return KFileItemList();
+    }
+    stream >> urlString >> count;
+    if (stream.status() != QDataStream::Ok || urlString != snapshotUrlString(dirUrl) || count < 0) {
+        return KFileItemList();
+    }
+    if (count > (file.size() - file.pos()) / MIN_ENTRY_SIZE) {
+        qWarning() << "Corrupted snapshot for" << dirUrl;
+        file.close();
+        QFile::remove(path);
+        return KFileItemList();
+    }
+
+    KFileItemList items;
+    items.reserve(count);
+    QVector<QDateTime> dateTimes;
+    dateTimes.reserve(count);
+    for (int idx = 0; idx < count; ++idx) {
+        KIO::UDSEntry entry;
+        QDateTime dateTime;
+        stream >> entry >> dateTime;
+        if (stream.status() != QDataStream::Ok) {
+            qWarning() << "Corrupted snapshot for" << dirUrl;
+            file.close();
+            QFile::remove(path);
+            return KFileItemList();
+        }
+        items << KFileItem(entry, dirUrl, true /* delayedMimeTypes */, true /* urlIsDirectory */);
+        dateTimes << dateTime;
+    }
+    file.close();
+
+    for (int idx = 0; idx < count; ++idx) {
+        if (dateTimes.at(idx).isValid()) {
+            TimeUtils::setCachedDateTimeForFileItem(items.at(idx), dateTimes.at(idx));
+        }
+    }
+
+    // Touch the snapshot so that eviction works on a least-recently-used
+    // basis
+    utime(QFile::encodeName(path).constData(), nullptr);
+
+    LOG("Loaded" << items.count() << "entries for" << dirUrl);
+    return items;
+}
+
+void remove(const QUrl& dirUrl)
+{
+    QFile::remove(snapshotPath(dirUrl));
+}
+
+} // namespace
+
+} // namespace
@@ -0,0 +1,103 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef DIRSNAPSHOT_H
+#define DIRSNAPSHOT_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QDateTime>
+#include <QString>
+#include <QVector>
+
+// KDE
+#include <KFileItem>
+#include <KIO/UDSEntry>
+
+// Local
+
+class QUrl;
+
+namespace Gwenview
+{
+
+/**
+ * Persists the content of big folders in an on-disk cache, so that they can
+ * be shown as soon as they are opened again, before KDirLister is done
+ * listing them. Each snapshot contains the entries of the folder, with their
+ * mime type and the date used to sort them by date.
+ *
+ * Only folders with at least MIN_ITEM_COUNT items are stored, smaller ones
+ * are listed fast enough.
+ */
+namespace DirSnapshot
+{
+
+const int MIN_ITEM_COUNT = 500;
+
+struct Entry
+{
+    KIO::UDSEntry entry;
+    /// Date returned by TimeUtils::dateTimeForFileItem(), if it was known
+    QDateTime dateTime;
+};
+
+typedef QVector<Entry> EntryList;
+
+/**
+ * Returns the directory where snapshots are stored
+ */
+GWENVIEWLIB_EXPORT QString cacheDir();
+
+/**
+ * Sets the dir where snapshots are stored, useful for unit-testing
+ */
+GWENVIEWLIB_EXPORT void setCacheDir(const QString&);
+
+/**
+ * Converts @p items to entries which can be stored. Must be called from the
+ * GUI thread, since it reads the TimeUtils cache.
+ */
+GWENVIEWLIB_EXPORT EntryList entriesForItems(const KFileItemList& items);
+
+/**
+ * Stores the snapshot of @p dirUrl, evicting the least recently used
+ * snapshots. Can be called from any thread.
+ */
+GWENVIEWLIB_EXPORT void store(const QUrl& dirUrl, const EntryList& entries);
+
+/**
+ * Returns the items stored for @p dirUrl, or an empty list if there is no
+ * snapshot for it. Dates found in the snapshot are put back in the
+ * TimeUtils cache, so this must be called from the GUI thread.
+ */
+GWENVIEWLIB_EXPORT KFileItemList load(const QUrl& dirUrl);
+
+/**
+ * Removes the snapshot of @p dirUrl
+ */
+GWENVIEWLIB_EXPORT void remove(const QUrl& dirUrl);
+
+} // namespace
+
+} // namespace
+
+#endif /* DIRSNAPSHOT_H */
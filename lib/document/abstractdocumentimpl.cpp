@@ -67,6 +67,11 @@ void AbstractDocumentImpl::setDocumentImageSize(const QSize& size)
     d->mDocument->setSize(size);
 }
 
+void AbstractDocumentImpl::setDocumentFileInfo(const QDateTime& modificationTime, qint64 size)
+{
+    d->mDocument->setFileInfo(modificationTime, size);
+}
+
 void AbstractDocumentImpl::setDocumentFormat(const QByteArray& format)
 {
     d->mDocument->setFormat(format);
@@ -87,6 +92,11 @@ void AbstractDocumentImpl::setDocumentDownSampledImage(const QImage& image, int
     d->mDocument->setDownSampledImage(image, invertedZoom);
 }
 
+void AbstractDocumentImpl::setDocumentImageRegion(const QRect& rect, const QImage& image)
+{
+    d->mDocument->setImageRegion(rect, image);
+}
+
 void AbstractDocumentImpl::setDocumentErrorString(const QString& string)
 {
     d->mDocument->setErrorString(string);
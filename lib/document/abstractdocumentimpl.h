@@ -95,6 +95,28 @@ public:
         return nullptr;
     }
 
+    /**
+     * Returns true if loadImageRegion() can be used
+     */
+    virtual bool canLoadImageRegions() const
+    {
+        return false;
+    }
+
+    /**
+     * Decodes the part of the full image contained in @a rect, and passes it
+     * to the document with setDocumentImageRegion()
+     */
+    virtual void loadImageRegion(const QRect& /*rect*/)
+    {}
+
+    /**
+     * Called when the worker lane of the document changes, so that work
+     * which has not started yet can be moved to the new lane
+     */
+    virtual void workerLaneChanged()
+    {}
+
 Q_SIGNALS:
     void imageRectUpdated(const QRect&);
     void metaInfoLoaded();
@@ -106,10 +128,12 @@ Q_SIGNALS:
 protected:
     void setDocumentImage(const QImage& image);
     void setDocumentImageSize(const QSize& size);
+    void setDocumentFileInfo(const QDateTime& modificationTime, qint64 size);
     void setDocumentKind(MimeTypeUtils::Kind);
     void setDocumentFormat(const QByteArray& format);
     void setDocumentExiv2Image(Exiv2::Image::AutoPtr);
     void setDocumentDownSampledImage(const QImage&, int invertedZoom);
+    void setDocumentImageRegion(const QRect&, const QImage&);
     void setDocumentCmsProfile(Cms::Profile::Ptr profile);
     void setDocumentErrorString(const QString&);
     void switchToImpl(AbstractDocumentImpl*  impl);
@@ -22,7 +22,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 // Qt
 #include <QApplication>
+#include <QFileInfo>
 #include <QImage>
+#include <QMap>
 #include <QUndoStack>
 #include <QUrl>
 #include <QDebug>
@@ -39,6 +41,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "loadingdocumentimpl.h"
 #include "loadingjob.h"
 #include "savejob.h"
+#include "tracing.h"
 
 namespace Gwenview
 {
@@ -85,7 +88,97 @@ static void logQueue(DocumentPrivate* d)
 
 #endif
 
+static const int IMAGE_REGION_TILE_SIZE = 512;
+
+// In kilobytes. This is the minimum: the cache grows when a region needs
+// more tiles, see reserveImageRegionTiles()
+static const int MAX_IMAGE_REGION_TILES_COST = 128 * 1024;
+
+// In kilobytes, for a 32 bit tile
+static const int IMAGE_REGION_TILE_COST = IMAGE_REGION_TILE_SIZE * IMAGE_REGION_TILE_SIZE * 4 / 1024 + 1;
+
+static quint64 imageRegionTileKey(int column, int row)
+{
+    return (quint64(row) << 32) | quint32(column);
+}
+
 //- DocumentPrivate ---------------------------------------
+QRect DocumentPrivate::imageRegionTileRange(const QRect& rect) const
+{
+    const QRect imageRect = rect.intersected(QRect(QPoint(0, 0), mSize));
+    if (imageRect.isEmpty()) {
+        return QRect();
+    }
+    return QRect(
+        QPoint(imageRect.left() / IMAGE_REGION_TILE_SIZE, imageRect.top() / IMAGE_REGION_TILE_SIZE),
+        QPoint(imageRect.right() / IMAGE_REGION_TILE_SIZE, imageRect.bottom() / IMAGE_REGION_TILE_SIZE));
+}
+
+QRect DocumentPrivate::imageRegionTileRect(int column, int row) const
+{
+    return QRect(
+        column * IMAGE_REGION_TILE_SIZE, row * IMAGE_REGION_TILE_SIZE,
+        IMAGE_REGION_TILE_SIZE, IMAGE_REGION_TILE_SIZE
+    ).intersected(QRect(QPoint(0, 0), mSize));
+}
+
+bool DocumentPrivate::hasImageRegionTiles(const QRect& tileRange) const
+{
+    for (int row = tileRange.top(); row <= tileRange.bottom(); ++row) {
+        for (int column = tileRange.left(); column <= tileRange.right(); ++column) {
+            if (!mImageRegionTiles.contains(imageRegionTileKey(column, row))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void DocumentPrivate::loadImageRegionTiles(const QRect& tileRange)
+{
+    // libjpeg decodes whole rows, so decode consecutive missing tiles of a
+    // row together
+    for (int row = tileRange.top(); row <= tileRange.bottom(); ++row) {
+        int column = tileRange.left();
+        while (column <= tileRange.right()) {
+            const quint64 key = imageRegionTileKey(column, row);
+            if (mImageRegionTiles.contains(key) || mPendingImageRegionTiles.contains(key)) {
+                ++column;
+                continue;
+            }
+            QRect rect = imageRegionTileRect(column, row);
+            for (; column <= tileRange.right(); ++column) {
+                const quint64 key = imageRegionTileKey(column, row);
+                if (mImageRegionTiles.contains(key) || mPendingImageRegionTiles.contains(key)) {
+                    break;
+                }
+                mPendingImageRegionTiles.insert(key);
+                rect |= imageRegionTileRect(column, row);
+            }
+            LOG("Loading image region" << rect);
+            mImpl->loadImageRegion(rect);
+        }
+    }
+}
+
+void DocumentPrivate::reserveImageRegionTiles(const QRect& tileRange)
+{
+    // Tiles must stay in the cache until the region they belong to has been
+    // scaled, otherwise they get decoded over and over
+    const int cost = tileRange.width() * tileRange.height() * IMAGE_REGION_TILE_COST;
+    if (cost > mImageRegionTiles.maxCost()) {
+        LOG("Growing image region tile cache to" << cost << "KB");
+        mImageRegionTiles.setMaxCost(cost);
+    }
+}
+
+void DocumentPrivate::clearImageRegionTiles()
+{
+    mImageRegionTiles.clear();
+    mImageRegionTiles.setMaxCost(MAX_IMAGE_REGION_TILES_COST);
+    mPendingImageRegionTiles.clear();
+}
+
 void DocumentPrivate::scheduleImageLoading(int invertedZoom)
 {
     LoadingDocumentImpl* impl = qobject_cast<LoadingDocumentImpl*>(mImpl);
@@ -115,6 +208,7 @@ void DocumentPrivate::scheduleImageDownSampling(int invertedZoom)
             return;
         } else {
             LOG("Removing downsampling job");
+            Tracing::endAsync("documentJobQueued", mUrl, job);
             mJobQueue.erase(it);
             delete job;
         }
@@ -124,6 +218,7 @@ void DocumentPrivate::scheduleImageDownSampling(int invertedZoom)
 
 void DocumentPrivate::downSampleImage(int invertedZoom)
 {
+    TraceSpan span("downSampleImage", mUrl);
     mDownSampledImageMap[invertedZoom] = mImage.scaled(mImage.size() / invertedZoom, Qt::KeepAspectRatio, Qt::FastTransformation);
     if (mDownSampledImageMap[invertedZoom].size().isEmpty()) {
         mDownSampledImageMap[invertedZoom] = mImage;
@@ -146,7 +241,7 @@ qreal Document::maxDownSampledZoom()
     return 0.5;
 }
 
-Document::Document(const QUrl &url)
+Document::Document(const QUrl &url, WorkerLane::Enum lane)
 : QObject()
 , d(new DocumentPrivate)
 {
@@ -154,6 +249,8 @@ Document::Document(const QUrl &url)
     d->mImpl = nullptr;
     d->mUrl = url;
     d->mKeepRawData = false;
+    d->mWorkerLane = lane;
+    d->mImageRegionTiles.setMaxCost(MAX_IMAGE_REGION_TILES_COST);
 
     reload();
 }
@@ -171,8 +268,11 @@ Document::~Document()
 void Document::reload()
 {
     d->mSize = QSize();
+    d->mFileModificationTime = QDateTime();
+    d->mFileSize = -1;
     d->mImage = QImage();
     d->mDownSampledImageMap.clear();
+    d->clearImageRegionTiles();
     d->mExiv2Image.reset();
     d->mKind = MimeTypeUtils::KIND_UNKNOWN;
     d->mFormat = QByteArray();
@@ -226,6 +326,107 @@ const QImage& Document::downSampledImageForZoom(qreal zoom) const
     return d->mDownSampledImageMap[invertedZoom];
 }
 
+QImage Document::downSampledImageForPixelSize(int pixelSize) const
+{
+    // Iterate from the smallest down sampled image to the biggest one
+    QMapIterator<int, QImage> it(d->mDownSampledImageMap);
+    it.toBack();
+    while (it.hasPrevious()) {
+        it.previous();
+        const QImage& image = it.value();
+        if (qMax(image.width(), image.height()) >= pixelSize) {
+            return image;
+        }
+    }
+    return d->mImage;
+}
+
+bool Document::canLoadImageRegions() const
+{
+    return d->mImpl->canLoadImageRegions();
+}
+
+bool Document::prepareImageRegion(const QRect& rect)
+{
+    if (!d->mImage.isNull()) {
+        return true;
+    }
+    if (!canLoadImageRegions()) {
+        startLoadingFullImage();
+        return false;
+    }
+
+    const QRect tileRange = d->imageRegionTileRange(rect);
+    if (tileRange.isEmpty()) {
+        return true;
+    }
+    // Decode a margin of tiles after the region itself, so that they are
+    // ready when the user scrolls
+    const QRect allTiles = d->imageRegionTileRange(QRect(QPoint(0, 0), d->mSize));
+    const QRect marginRange = tileRange.adjusted(-1, -1, 1, 1).intersected(allTiles);
+    d->reserveImageRegionTiles(marginRange);
+    d->loadImageRegionTiles(tileRange);
+    d->loadImageRegionTiles(marginRange);
+    return d->hasImageRegionTiles(tileRange);
+}
+
+QImage Document::imageRegion(const QRect& rect) const
+{
+    if (!d->mImage.isNull()) {
+        return d->mImage.copy(rect);
+    }
+
+    const QRect regionRect = rect.intersected(QRect(QPoint(0, 0), d->mSize));
+    const QRect tileRange = d->imageRegionTileRange(regionRect);
+    QImage region;
+    for (int row = tileRange.top(); row <= tileRange.bottom(); ++row) {
+        for (int column = tileRange.left(); column <= tileRange.right(); ++column) {
+            const QImage* tile = d->mImageRegionTiles.object(imageRegionTileKey(column, row));
+            if (!tile) {
+                return QImage();
+            }
+            if (region.isNull()) {
+                region = QImage(regionRect.size(), tile->format());
+            }
+            // Tiles may be 8 or 32 bit images, copy bytes instead of painting
+            const int bytesPerPixel = tile->depth() / 8;
+            const QRect tileRect = d->imageRegionTileRect(column, row);
+            const QRect part = tileRect.intersected(regionRect);
+            for (int y = part.top(); y <= part.bottom(); ++y) {
+                memcpy(
+                    region.scanLine(y - regionRect.top()) + (part.left() - regionRect.left()) * bytesPerPixel,
+                    tile->constScanLine(y - tileRect.top()) + (part.left() - tileRect.left()) * bytesPerPixel,
+                    part.width() * bytesPerPixel);
+            }
+        }
+    }
+    return region;
+}
+
+void Document::setImageRegion(const QRect& rect, const QImage& image)
+{
+    if (!d->mImage.isNull()) {
+        // The full image has been loaded in the meantime
+        return;
+    }
+    const QRect tileRange = d->imageRegionTileRange(rect);
+    for (int row = tileRange.top(); row <= tileRange.bottom(); ++row) {
+        for (int column = tileRange.left(); column <= tileRange.right(); ++column) {
+            const quint64 key = imageRegionTileKey(column, row);
+            d->mPendingImageRegionTiles.remove(key);
+            if (image.isNull()) {
+                continue;
+            }
+            const QRect tileRect = d->imageRegionTileRect(column, row);
+            QImage* tile = new QImage(image.copy(tileRect.translated(-rect.topLeft())));
+            d->mImageRegionTiles.insert(key, tile, tile->byteCount() / 1024 + 1);
+        }
+    }
+    if (!image.isNull()) {
+        emit imageRegionReady(rect);
+    }
+}
+
 Document::LoadingState Document::loadingState() const
 {
     return d->mImpl->loadingState();
@@ -257,6 +458,8 @@ void Document::setImageInternal(const QImage& image)
 {
     d->mImage = image;
     d->mDownSampledImageMap.clear();
+    // The full image replaces the tiles
+    d->clearImageRegionTiles();
 
     // If we didn't get the image size before decoding the full image, set it
     // now
@@ -320,6 +523,12 @@ void Document::slotSaveResult(KJob* job)
         SaveJob* saveJob = static_cast<SaveJob*>(job);
         d->mUrl = saveJob->newUrl();
         d->mImageMetaInfoModel.setUrl(d->mUrl);
+        if (d->mUrl.isLocalFile()) {
+            const QFileInfo info(d->mUrl.toLocalFile());
+            setFileInfo(info.lastModified(), info.size());
+        } else {
+            setFileInfo(QDateTime(), -1);
+        }
         saved(saveJob->oldUrl(), d->mUrl);
     }
 }
@@ -351,6 +560,22 @@ QSize Document::size() const
     return d->mSize;
 }
 
+QDateTime Document::fileModificationTime() const
+{
+    return d->mFileModificationTime;
+}
+
+qint64 Document::fileSize() const
+{
+    return d->mFileSize;
+}
+
+void Document::setFileInfo(const QDateTime& modificationTime, qint64 size)
+{
+    d->mFileModificationTime = modificationTime;
+    d->mFileSize = size;
+}
+
 bool Document::hasAlphaChannel() const
 {
     if (d->mImage.isNull()) {
@@ -364,6 +589,7 @@ int Document::memoryUsage() const
 {
     // FIXME: Take undo stack into account
     int usage = d->mImage.byteCount();
+    usage += d->mImageRegionTiles.totalCost() * 1024;
     usage += rawData().length();
     return usage;
 }
@@ -520,10 +746,12 @@ void Document::enqueueJob(DocumentJob* job)
     job->setDocument(Ptr(this));
     connect(job, &LoadingJob::finished, this, &Document::slotJobFinished);
     if (d->mCurrentJob) {
+        Tracing::beginAsync("documentJobQueued", d->mUrl, job);
         d->mJobQueue.enqueue(job);
     } else {
         d->mCurrentJob = job;
         LOG("Starting first job");
+        Tracing::beginAsync("documentJob", d->mUrl, job);
         job->start();
         busyChanged(d->mUrl, true);
     }
@@ -534,6 +762,7 @@ void Document::slotJobFinished(KJob* job)
 {
     LOG("job=" << job);
     GV_RETURN_IF_FAIL(job == d->mCurrentJob.data());
+    Tracing::endAsync("documentJob", d->mUrl, job);
 
     if (d->mJobQueue.isEmpty()) {
         LOG("All done");
@@ -544,6 +773,8 @@ void Document::slotJobFinished(KJob* job)
         LOG("Starting next job");
         d->mCurrentJob = d->mJobQueue.dequeue();
         GV_RETURN_IF_FAIL(d->mCurrentJob);
+        Tracing::endAsync("documentJobQueued", d->mUrl, d->mCurrentJob.data());
+        Tracing::beginAsync("documentJob", d->mUrl, d->mCurrentJob.data());
         d->mCurrentJob.data()->start();
     }
     LOG_QUEUE("Removed done job", d);
@@ -554,6 +785,22 @@ bool Document::isBusy() const
     return !d->mJobQueue.isEmpty();
 }
 
+WorkerLane::Enum Document::workerLane() const
+{
+    return d->mWorkerLane;
+}
+
+void Document::setWorkerLane(WorkerLane::Enum lane)
+{
+    if (d->mWorkerLane == lane) {
+        return;
+    }
+    d->mWorkerLane = lane;
+    if (d->mImpl) {
+        d->mImpl->workerLaneChanged();
+    }
+}
+
 QSvgRenderer* Document::svgRenderer() const
 {
     return d->mImpl->svgRenderer();
@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <exiv2/image.hpp>
 
 // Qt
+#include <QDateTime>
 #include <QObject>
 #include <QSharedData>
 #include <QSize>
@@ -33,6 +34,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 // Local
 #include <lib/mimetypeutils.h>
 #include <lib/cms/cmsprofile.h>
+#include <lib/workerlane.h>
 
 class QImage;
 class QRect;
@@ -64,6 +66,10 @@ class ImageMetaInfoModel;
  * images load much faster than the full image but you need to load the full
  * image to manipulate it (use startLoadingFullImage() to do so).
  *
+ * Big JPEG images can also be viewed at high zoom levels without loading the
+ * full image: prepareImageRegion() and imageRegion() decode only the tiles
+ * of the image which are needed.
+ *
  * To get a Document instance for url, ask for one with
  * DocumentFactory::instance()->load(url);
  */
@@ -119,6 +125,41 @@ public:
 
     const QImage& downSampledImageForZoom(qreal zoom) const;
 
+    /**
+     * Returns the smallest image currently in memory, be it the full image or
+     * one of its down sampled versions, whose bigger side is at least
+     * @a pixelSize pixels. If the full image is smaller than @a pixelSize,
+     * returns the full image.
+     * Returns a null image if no image big enough has been loaded yet.
+     */
+    QImage downSampledImageForPixelSize(int pixelSize) const;
+
+    /**
+     * Returns true if parts of the full image can be decoded on their own,
+     * without loading the full image. This is the case for big JPEG images
+     * once their meta info has been loaded.
+     */
+    bool canLoadImageRegions() const;
+
+    /**
+     * Prepare the pixels of the full image contained in @a rect, plus a
+     * margin around them.
+     * If the document cannot load image regions, the full image is loaded
+     * instead. The tile cache grows as needed to keep the whole region in
+     * memory until the full image replaces it.
+     *
+     * @return true if the pixels are ready, false if not. In this case the
+     * imageRegionReady() signal will be emitted as parts of the region get
+     * decoded, or loaded() if the full image had to be loaded.
+     */
+    bool prepareImageRegion(const QRect& rect);
+
+    /**
+     * Returns the pixels of the full image contained in @a rect. Returns a
+     * null image if they have not been prepared with prepareImageRegion().
+     */
+    QImage imageRegion(const QRect& rect) const;
+
     /**
      * Returns an implementation of AbstractDocumentEditor if this document can
      * be edited.
@@ -135,6 +176,19 @@ public:
 
     QSize size() const;
 
+    /**
+     * Returns the modification time of the file the document has been
+     * loaded from or saved to. Invalid if it is not known, for example for
+     * remote urls.
+     */
+    QDateTime fileModificationTime() const;
+
+    /**
+     * Returns the size of the file the document has been loaded from or
+     * saved to, or -1 if it is not known
+     */
+    qint64 fileSize() const;
+
     int width() const
     {
         return size().width();
@@ -204,8 +258,16 @@ public:
      */
     bool isBusy() const;
 
+    /**
+     * The lane in which the loading and threaded jobs of this document run.
+     * Defaults to WorkerLane::Interactive.
+     */
+    WorkerLane::Enum workerLane() const;
+    void setWorkerLane(WorkerLane::Enum lane);
+
 Q_SIGNALS:
     void downSampledImageReady();
+    void imageRegionReady(const QRect&);
     void imageRectUpdated(const QRect&);
     void kindDetermined(const QUrl&);
     void metaInfoLoaded(const QUrl&);
@@ -235,13 +297,15 @@ private:
     void setKind(MimeTypeUtils::Kind);
     void setFormat(const QByteArray&);
     void setSize(const QSize&);
+    void setFileInfo(const QDateTime& modificationTime, qint64 size);
     void setExiv2Image(Exiv2::Image::AutoPtr);
     void setDownSampledImage(const QImage&, int invertedZoom);
+    void setImageRegion(const QRect&, const QImage&);
     void switchToImpl(AbstractDocumentImpl* impl);
     void setErrorString(const QString&);
     void setCmsProfile(Cms::Profile::Ptr);
 
-    Document(const QUrl&);
+    Document(const QUrl&, WorkerLane::Enum lane = WorkerLane::Interactive);
     DocumentPrivate * const d;
 };
 
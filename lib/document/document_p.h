@@ -29,8 +29,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include <QUrl>
 
 // Qt
+#include <QCache>
 #include <QImage>
 #include <QQueue>
+#include <QSet>
 #include <QUndoStack>
 #include <QPointer>
 
@@ -44,6 +46,7 @@ struct DocumentPrivate
     AbstractDocumentImpl* mImpl;
     QUrl mUrl;
     bool mKeepRawData;
+    WorkerLane::Enum mWorkerLane;
     QPointer<DocumentJob> mCurrentJob;
     DocumentJobQueue mJobQueue;
 
@@ -52,8 +55,14 @@ struct DocumentPrivate
      * @{
      */
     QSize mSize;
+    QDateTime mFileModificationTime;
+    qint64 mFileSize;
     QImage mImage;
     QMap<int, QImage> mDownSampledImageMap;
+    // Tiles of the full image, decoded before the full image is loaded. Keys
+    // are created with imageRegionTileKey()
+    QCache<quint64, QImage> mImageRegionTiles;
+    QSet<quint64> mPendingImageRegionTiles;
     Exiv2::Image::AutoPtr mExiv2Image;
     MimeTypeUtils::Kind mKind;
     QByteArray mFormat;
@@ -66,6 +75,13 @@ struct DocumentPrivate
     void scheduleImageLoading(int invertedZoom);
     void scheduleImageDownSampling(int invertedZoom);
     void downSampleImage(int invertedZoom);
+
+    QRect imageRegionTileRange(const QRect& rect) const;
+    QRect imageRegionTileRect(int column, int row) const;
+    bool hasImageRegionTiles(const QRect& tileRange) const;
+    void loadImageRegionTiles(const QRect& tileRange);
+    void reserveImageRegionTiles(const QRect& tileRange);
+    void clearImageRegionTiles();
 };
 
 
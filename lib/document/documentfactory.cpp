@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <QDateTime>
 #include <QMap>
 #include <QUndoGroup>
+#include <QUndoStack>
 #include <QUrl>
 #include <QDebug>
 
@@ -31,6 +32,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 // Local
 #include <gvdebug.h>
+#include <lib/memorypressuremonitor.h>
 
 namespace Gwenview
 {
@@ -59,6 +61,22 @@ inline int getMaxUnreferencedImages()
 
 static const int MAX_UNREFERENCED_IMAGES = getMaxUnreferencedImages();
 
+/**
+ * Number of unreferenced images to keep, lowered when memory runs low
+ */
+static int maxUnreferencedImages()
+{
+    switch (MemoryPressureMonitor::instance()->level()) {
+    case MemoryPressureMonitor::NoPressure:
+        break;
+    case MemoryPressureMonitor::ModeratePressure:
+        return qMin(MAX_UNREFERENCED_IMAGES, 1);
+    case MemoryPressureMonitor::CriticalPressure:
+        return 0;
+    }
+    return MAX_UNREFERENCED_IMAGES;
+}
+
 /**
  * This internal structure holds the document and the last time it has been
  * accessed. This access time is used to "garbage collect" the loaded
@@ -103,9 +121,10 @@ struct DocumentFactoryPrivate
 
         // Remove oldest unreferenced images. Since the map is sorted by key,
         // the oldest one is always unreferencedImages.begin().
+        const int maxUnreferenced = maxUnreferencedImages();
         for (
             UnreferencedImages::Iterator unreferencedIt = unreferencedImages.begin();
-            unreferencedImages.count() > MAX_UNREFERENCED_IMAGES;
+            unreferencedImages.count() > maxUnreferenced;
             unreferencedIt = unreferencedImages.erase(unreferencedIt))
         {
             QUrl url = unreferencedIt.value();
@@ -121,6 +140,22 @@ struct DocumentFactoryPrivate
 #endif
     }
 
+    /**
+     * Drops the undo history of documents which have been saved: their
+     * commands may hold full copies of the image
+     */
+    void clearSavedUndoStacks()
+    {
+        for (DocumentInfo* info : qAsConst(mDocumentMap)) {
+            Document::Ptr doc = info->mDocument;
+            QUndoStack* stack = doc->undoStack();
+            if (stack->count() > 0 && stack->isClean() && !doc->isBusy()) {
+                LOG("Clearing undo stack of" << doc->url());
+                stack->clear();
+            }
+        }
+    }
+
     void logDocumentMap(const DocumentMap& map)
     {
         LOG("map:");
@@ -140,6 +175,8 @@ struct DocumentFactoryPrivate
 DocumentFactory::DocumentFactory()
 : d(new DocumentFactoryPrivate)
 {
+    connect(MemoryPressureMonitor::instance(), &MemoryPressureMonitor::levelChanged,
+            this, &DocumentFactory::slotMemoryPressureChanged);
 }
 
 DocumentFactory::~DocumentFactory()
@@ -160,7 +197,7 @@ Document::Ptr DocumentFactory::getCachedDocument(const QUrl &url) const
     return info ? info->mDocument : Document::Ptr();
 }
 
-Document::Ptr DocumentFactory::load(const QUrl &url)
+Document::Ptr DocumentFactory::load(const QUrl &url, WorkerLane::Enum lane)
 {
     GV_RETURN_VALUE_IF_FAIL(!url.isEmpty(), Document::Ptr());
     DocumentInfo* info = nullptr;
@@ -171,6 +208,10 @@ Document::Ptr DocumentFactory::load(const QUrl &url)
         LOG(url.fileName() << "url in mDocumentMap");
         info = it.value();
         info->mLastAccess = QDateTime::currentDateTime();
+        if (lane == WorkerLane::Interactive) {
+            // The user wants to see a document which may have been preloaded
+            info->mDocument->setWorkerLane(lane);
+        }
         return info->mDocument;
     }
 
@@ -178,7 +219,7 @@ Document::Ptr DocumentFactory::load(const QUrl &url)
 
     // Start loading the document
     LOG(url.fileName() << "loading");
-    Document* doc = new Document(url);
+    Document* doc = new Document(url, lane);
     connect(doc, &Document::loaded, this, &DocumentFactory::slotLoaded);
     connect(doc, &Document::saved, this, &DocumentFactory::slotSaved);
     connect(doc, &Document::modified, this, &DocumentFactory::slotModified);
@@ -260,6 +301,17 @@ void DocumentFactory::slotBusyChanged(const QUrl &url, bool busy)
     emit documentBusyStateChanged(url, busy);
 }
 
+void DocumentFactory::slotMemoryPressureChanged(MemoryPressureMonitor::Level level)
+{
+    if (level == MemoryPressureMonitor::NoPressure) {
+        return;
+    }
+    d->garbageCollect(d->mDocumentMap);
+    if (level == MemoryPressureMonitor::CriticalPressure) {
+        d->clearSavedUndoStacks();
+    }
+}
+
 QUndoGroup* DocumentFactory::undoGroup()
 {
     return &d->mUndoGroup;
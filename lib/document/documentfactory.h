@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <QObject>
 
 #include <lib/document/document.h>
+#include <lib/memorypressuremonitor.h>
 
 class QUndoGroup;
 
@@ -52,8 +53,11 @@ public:
      * Loads the document associated with url, or returns an already cached
      * instance of Document::Ptr if there is any.
      * This method updates the last-access timestamp.
+     *
+     * @p lane is the lane the document is loaded in. Loading a cached
+     * document in WorkerLane::Interactive moves its pending work there.
      */
-    Document::Ptr load(const QUrl &url);
+    Document::Ptr load(const QUrl &url, WorkerLane::Enum lane = WorkerLane::Interactive);
 
     /**
      * Returns a document if it has already been loaded once with load().
@@ -85,6 +89,7 @@ private Q_SLOTS:
     void slotSaved(const QUrl&, const QUrl&);
     void slotModified(const QUrl&);
     void slotBusyChanged(const QUrl&, bool);
+    void slotMemoryPressureChanged(MemoryPressureMonitor::Level);
 
 private:
     DocumentFactory();
@@ -24,7 +24,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 // Qt
 #include <QFuture>
 #include <QFutureWatcher>
-#include <QtConcurrentRun>
 #include <QApplication>
 #include <QDebug>
 
@@ -33,6 +32,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include <KLocalizedString>
 
 // Local
+#include "workerpool.h"
 
 namespace Gwenview
 {
@@ -84,7 +84,9 @@ bool DocumentJob::checkDocumentEditor()
 
 void ThreadedDocumentJob::doStart()
 {
-    QFuture<void> future = QtConcurrent::run(this, &ThreadedDocumentJob::threadedStart);
+    QFuture<void> future = WorkerPool::run(document()->workerLane(), [this]() {
+        threadedStart();
+    });
     QFutureWatcher<void>* watcher = new QFutureWatcher<void>(this);
     connect(watcher, SIGNAL(finished()), SLOT(emitResult()));
     watcher->setFuture(future);
@@ -25,7 +25,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 #include <QByteArray>
 #include <QImage>
 #include <QImageWriter>
-#include <QMatrix>
 #include <QDebug>
 #include <QUrl>
 
@@ -108,9 +107,7 @@ void DocumentLoadedImpl::setImage(const QImage& image)
 
 void DocumentLoadedImpl::applyTransformation(Orientation orientation)
 {
-    QImage image = document()->image();
-    QMatrix matrix = ImageUtils::transformMatrix(orientation);
-    image = image.transformed(matrix);
+    const QImage image = ImageUtils::transformed(document()->image(), orientation, document()->workerLane());
     setDocumentImage(image);
     imageRectUpdated(image.rect());
 }
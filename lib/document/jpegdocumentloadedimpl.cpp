@@ -29,6 +29,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 
 // Local
 #include "jpegcontent.h"
+#include "resampler.h"
 
 namespace Gwenview
 {
@@ -56,7 +57,9 @@ bool JpegDocumentLoadedImpl::saveInternal(QIODevice* device, const QByteArray& f
 {
     if (format == "jpeg") {
         if (!d->mJpegContent->thumbnail().isNull()) {
-            QImage thumbnail = document()->image().scaled(128, 128, Qt::KeepAspectRatio);
+            const QImage& image = document()->image();
+            const QSize size = image.size().scaled(128, 128, Qt::KeepAspectRatio);
+            QImage thumbnail = Resampler::scaled(image, size, Resampler::Mitchell, document()->workerLane());
             d->mJpegContent->setThumbnail(thumbnail);
         }
 
@@ -25,15 +25,18 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 #include <memory>
 
 // Qt
+#include <QAtomicInt>
 #include <QBuffer>
 #include <QByteArray>
 #include <QFile>
+#include <QFileInfo>
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QImage>
 #include <QImageReader>
 #include <QPointer>
 #include <QtConcurrent>
+#include <QTimer>
 #include <QUrl>
 #include <QDebug>
 
@@ -49,6 +52,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 
 // Local
 #include "animateddocumentloadedimpl.h"
+#include "animationinfo.h"
 #include "cms/cmsprofile.h"
 #include "document.h"
 #include "documentloadedimpl.h"
@@ -58,10 +62,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 #include "imageutils.h"
 #include "jpegcontent.h"
 #include "jpegdocumentloadedimpl.h"
+#include "jpegregiondecoder.h"
+#include "multiresolutionreader.h"
 #include "orientation.h"
+#include "rawpreviewcache.h"
+#include "streamingdecoder.h"
 #include "svgdocumentloadedimpl.h"
+#include "tracing.h"
 #include "urlutils.h"
 #include "videodocumentloadedimpl.h"
+#include "workerpool.h"
 #include "gwenviewconfig.h"
 
 namespace Gwenview
@@ -76,16 +86,51 @@ namespace Gwenview
 #define LOG(x) ;
 #endif
 
-const int MIN_PREV_SIZE = 1000;
-
 const int HEADER_SIZE = 256;
 
+// Images smaller than this are decoded fast enough as a whole
+const int MIN_IMAGE_REGION_LOADING_PIXELS = 24 * 1000 * 1000;
+
+/**
+ * A read-only buffer whose reads fail as soon as its cancel token is set.
+ * Image decoders read their input in small chunks between scanlines or
+ * tiles, so this makes QImageReader::read() bail out early when the image is
+ * not wanted anymore.
+ */
+class CancellableBuffer : public QBuffer
+{
+public:
+    CancellableBuffer(QByteArray* data, const QAtomicInt* cancelToken)
+    : QBuffer(data)
+    , mCancelToken(cancelToken)
+    {
+        open(QIODevice::ReadOnly);
+    }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
+    {
+        if (mCancelToken->load()) {
+            return -1;
+        }
+        return QBuffer::readData(data, maxSize);
+    }
+
+private:
+    const QAtomicInt* mCancelToken;
+};
+
 struct LoadingDocumentImplPrivate
 {
     LoadingDocumentImpl* q;
+    // Worker threads must use this instead of q->document()->url(): they may
+    // outlive q, see ~LoadingDocumentImpl()
+    QUrl mUrl;
     QPointer<KIO::TransferJob> mTransferJob;
+    WorkerPool::MovableTask<bool> mMetaInfoTask;
     QFuture<bool> mMetaInfoFuture;
     QFutureWatcher<bool> mMetaInfoFutureWatcher;
+    WorkerPool::MovableTask<void> mImageDataTask;
     QFuture<void> mImageDataFuture;
     QFutureWatcher<void> mImageDataFutureWatcher;
 
@@ -93,8 +138,21 @@ struct LoadingDocumentImplPrivate
     // 1/mImageDataInvertedZoom
     int mImageDataInvertedZoom;
 
+    // The inverted zoom mImageDataFuture is decoding
+    int mLoadingImageDataInvertedZoom;
+
+    // Set when the document is not wanted anymore
+    QAtomicInt mCancelled;
+    // Set when the image being decoded is not wanted anymore
+    QAtomicInt mImageDataCancelled;
+    bool mDeleteScheduled;
+
     bool mMetaInfoLoaded;
+    bool mImageRegionLoadingFailed;
     bool mAnimated;
+    // Number of frames found by parsing the container, -1 if unknown. Only
+    // counted up to 2, since we only need to know whether there are several.
+    int mFrameCount;
     bool mDownSampledImageLoaded;
     QByteArray mFormatHint;
     QByteArray mData;
@@ -114,6 +172,7 @@ struct LoadingDocumentImplPrivate
     {
         QString mimeType;
         const QUrl &url = q->document()->url();
+        TraceSpan span("determineKind", url);
         QMimeDatabase db;
         if (KProtocolInfo::determineMimetypeFromExtension(url.scheme())) {
             mimeType = db.mimeTypeForFileNameAndData(url.fileName(), mData).name();
@@ -159,7 +218,9 @@ struct LoadingDocumentImplPrivate
             //
             mFormatHint = q->document()->url().fileName()
                 .section(QLatin1Char('.'), -1).toLocal8Bit().toLower();
-            mMetaInfoFuture = QtConcurrent::run(this, &LoadingDocumentImplPrivate::loadMetaInfo);
+            mMetaInfoFuture = mMetaInfoTask.run(q->document()->workerLane(), [this]() {
+                return loadMetaInfo();
+            });
             mMetaInfoFutureWatcher.setFuture(mMetaInfoFuture);
             break;
 
@@ -182,16 +243,40 @@ struct LoadingDocumentImplPrivate
         Q_ASSERT(mMetaInfoLoaded);
         Q_ASSERT(mImageDataInvertedZoom != 0);
         Q_ASSERT(!mImageDataFuture.isRunning());
-        mImageDataFuture = QtConcurrent::run(this, &LoadingDocumentImplPrivate::loadImageData);
+        mImageDataCancelled.store(0);
+        mLoadingImageDataInvertedZoom = mImageDataInvertedZoom;
+        const int invertedZoom = mLoadingImageDataInvertedZoom;
+        mImageDataFuture = mImageDataTask.run(q->document()->workerLane(), [this, invertedZoom]() {
+            loadImageData(invertedZoom);
+        });
         mImageDataFutureWatcher.setFuture(mImageDataFuture);
     }
 
+    /**
+     * Deletes this object once the worker threads are done with it
+     */
+    void deleteWhenDone()
+    {
+        if (mDeleteScheduled || mMetaInfoFuture.isRunning() || mImageDataFuture.isRunning()) {
+            return;
+        }
+        mDeleteScheduled = true;
+        LoadingDocumentImplPrivate* priv = this;
+        // Do not delete the watchers while they are emitting
+        QTimer::singleShot(0, [priv]() {
+            delete priv;
+        });
+    }
+
     bool loadMetaInfo()
     {
         LOG("mFormatHint" << mFormatHint);
-        QBuffer buffer;
-        buffer.setBuffer(&mData);
-        buffer.open(QIODevice::ReadOnly);
+        if (mCancelled.load()) {
+            return false;
+        }
+        const QUrl url = mUrl;
+        TraceSpan span("loadMetaInfo", url);
+        CancellableBuffer buffer(&mData, &mCancelled);
 
 #ifdef KDCRAW_FOUND
         if (KDcrawIface::KDcraw::rawFilesList().contains(QString::fromLatin1(mFormatHint))) {
@@ -200,19 +285,31 @@ struct LoadingDocumentImplPrivate
             // if the image is in format supported by dcraw, fetch its embedded preview
             mJpegContent.reset(new JpegContent());
 
-            // use KDcraw for getting the embedded preview
-            // KDcraw functionality cloned locally (temp. solution)
-            bool ret = KDcrawIface::KDcraw::loadEmbeddedPreview(previewData, buffer);
-
-            QImage originalImage;
-            if (!ret || !originalImage.loadFromData(previewData) || qMin(originalImage.width(), originalImage.height()) < MIN_PREV_SIZE) {
-                // if the embedded preview loading failed or gets just a small image, load
-                // half preview instead. That's slower but it works even for images containing
-                // small (160x120px) or none embedded preview.
-                if (!KDcrawIface::KDcraw::loadHalfPreview(previewData, buffer)) {
-                    qWarning() << "unable to get half preview for " << q->document()->url().fileName();
+            TraceSpan rawSpan("rawPreview", url);
+            if (url.isLocalFile()) {
+                // Go through the preview cache, the thumbnailer has probably
+                // extracted this preview already
+                RawPreviewCache::Preview preview;
+                if (!RawPreviewCache::loadPreview(url.toLocalFile(), RawPreviewCache::MIN_PREVIEW_SIZE, &preview)) {
+                    qWarning() << "unable to get half preview for " << url.fileName();
                     return false;
                 }
+                previewData = preview.data;
+            } else {
+                // use KDcraw for getting the embedded preview
+                // KDcraw functionality cloned locally (temp. solution)
+                bool ret = KDcrawIface::KDcraw::loadEmbeddedPreview(previewData, buffer);
+
+                QImage originalImage;
+                if (!ret || !originalImage.loadFromData(previewData) || qMin(originalImage.width(), originalImage.height()) < RawPreviewCache::MIN_PREVIEW_SIZE) {
+                    // if the embedded preview loading failed or gets just a small image, load
+                    // half preview instead. That's slower but it works even for images containing
+                    // small (160x120px) or none embedded preview.
+                    if (!KDcrawIface::KDcraw::loadHalfPreview(previewData, buffer)) {
+                        qWarning() << "unable to get half preview for " << url.fileName();
+                        return false;
+                    }
+                }
             }
 
             buffer.close();
@@ -257,9 +354,12 @@ struct LoadingDocumentImplPrivate
         LOG("mFormat" << mFormat);
         GV_RETURN_VALUE_IF_FAIL(!mFormat.isEmpty(), false);
 
-        Exiv2ImageLoader loader;
-        if (loader.load(mData)) {
-            mExiv2Image = loader.popImage();
+        {
+            TraceSpan exiv2Span("exiv2Parse", url);
+            Exiv2ImageLoader loader;
+            if (loader.load(mData)) {
+                mExiv2Image = loader.popImage();
+            }
         }
 
         if (mFormat == "jpeg" && mExiv2Image.get()) {
@@ -269,41 +369,51 @@ struct LoadingDocumentImplPrivate
         if (mJpegContent.get()) {
             if (!mJpegContent->loadFromData(mData, mExiv2Image.get()) &&
                 !mJpegContent->loadFromData(mData)) {
-                qWarning() << "Unable to use preview of " << q->document()->url().fileName();
+                qWarning() << "Unable to use preview of " << url.fileName();
                 return false;
             }
             // Use the size from JpegContent, as its correctly transposed if the
             // image has been rotated
             mImageSize = mJpegContent->size();
-
-            mCmsProfile = Cms::Profile::loadFromExiv2Image(mExiv2Image.get());
-
         }
 
         LOG("mImageSize" << mImageSize);
 
-        if (!mCmsProfile) {
-            mCmsProfile = Cms::Profile::loadFromImageData(mData, mFormat);
+        mFrameCount = AnimationInfo::frameCount(mData, 2);
+        LOG("mFrameCount" << mFrameCount);
+
+        {
+            TraceSpan cmsSpan("cmsProfileLoad", url);
+            if (mJpegContent.get()) {
+                mCmsProfile = Cms::Profile::loadFromExiv2Image(mExiv2Image.get());
+            }
+            if (!mCmsProfile) {
+                mCmsProfile = Cms::Profile::loadFromImageData(mData, mFormat);
+            }
         }
 
         return true;
     }
 
-    void loadImageData()
+    void loadImageData(int invertedZoom)
     {
-        QBuffer buffer;
-        buffer.setBuffer(&mData);
-        buffer.open(QIODevice::ReadOnly);
+        mImage = QImage();
+        mAnimated = false;
+        if (mImageDataCancelled.load()) {
+            return;
+        }
+        TraceSpan span("loadImageData", mUrl);
+        CancellableBuffer buffer(&mData, &mImageDataCancelled);
         QImageReader reader(&buffer, mFormat);
 
-        LOG("mImageDataInvertedZoom=" << mImageDataInvertedZoom);
+        LOG("invertedZoom=" << invertedZoom);
         if (mImageSize.isValid()
-                && mImageDataInvertedZoom != 1
+                && invertedZoom != 1
                 && reader.supportsOption(QImageIOHandler::ScaledSize)
            ) {
             // Do not use mImageSize here: QImageReader needs a non-transposed
             // image size
-            QSize size = reader.size() / mImageDataInvertedZoom;
+            QSize size = reader.size() / invertedZoom;
             if (!size.isEmpty()) {
                 LOG("Setting scaled size to" << size);
                 reader.setScaledSize(size);
@@ -316,17 +426,44 @@ struct LoadingDocumentImplPrivate
             reader.setAutoTransform(true);
         }
 
-        bool ok = reader.read(&mImage);
+        bool ok = false;
+        if (mImageSize.isValid() && invertedZoom != 1) {
+            const QSize size = reader.size() / invertedZoom;
+            if (StreamingDecoder::canReadScaled(mFormat)) {
+                buffer.seek(0);
+                mImage = StreamingDecoder::readScaled(&buffer, mFormat, size);
+                ok = !mImage.isNull();
+                if (!ok) {
+                    // Fall back to a full decode, from the start of the data
+                    buffer.seek(0);
+                    reader.setDevice(&buffer);
+                }
+            } else if (!reader.supportsOption(QImageIOHandler::ScaledSize)) {
+                ok = MultiResolutionReader::readLevel(&reader, size, &mImage);
+            }
+        }
         if (!ok) {
-            LOG("QImageReader::read() failed");
+            ok = reader.read(&mImage);
+        }
+        if (!ok || mImageDataCancelled.load()) {
+            LOG("QImageReader::read() failed or has been cancelled");
+            mImage = QImage();
             return;
         }
 
-        if (reader.supportsAnimation()
-                && reader.nextImageDelay() > 0 // Assume delay == 0 <=> only one frame
-           ) {
+        if (!reader.supportsAnimation()) {
+            return;
+        }
+        if (mFrameCount != -1) {
+            // Frames have been counted from the container in loadMetaInfo()
+            mAnimated = mFrameCount > 1;
+            LOG("Animated from container:" << mAnimated);
+            return;
+        }
+        if (reader.nextImageDelay() > 0) { // Assume delay == 0 <=> only one frame
             /*
-             * QImageReader is not really helpful to detect animated gif:
+             * QImageReader is not really helpful to detect animated images
+             * we cannot parse:
              * - QImageReader::imageCount() returns 0
              * - QImageReader::nextImageDelay() may return something > 0 if the
              *   image consists of only one frame but includes a "Graphic
@@ -334,7 +471,7 @@ struct LoadingDocumentImplPrivate
              *   animation) (Bug #185523)
              *
              * Decoding the next frame is the only reliable way I found to
-             * detect an animated gif
+             * detect an animated image
              */
             LOG("May be an animated image. delay:" << reader.nextImageDelay());
             QImage nextImage;
@@ -342,7 +479,7 @@ struct LoadingDocumentImplPrivate
                 LOG("Really an animated image (more than one frame)");
                 mAnimated = true;
             } else {
-                qWarning() << q->document()->url() << "is not really an animated image (only one frame)";
+                qWarning() << mUrl << "is not really an animated image (only one frame)";
             }
         }
     }
@@ -353,10 +490,15 @@ LoadingDocumentImpl::LoadingDocumentImpl(Document* document)
 , d(new LoadingDocumentImplPrivate)
 {
     d->q = this;
+    d->mUrl = document->url();
     d->mMetaInfoLoaded = false;
+    d->mImageRegionLoadingFailed = false;
     d->mAnimated = false;
+    d->mFrameCount = -1;
     d->mDownSampledImageLoaded = false;
     d->mImageDataInvertedZoom = 0;
+    d->mLoadingImageDataInvertedZoom = 0;
+    d->mDeleteScheduled = false;
 
     connect(&d->mMetaInfoFutureWatcher, SIGNAL(finished()),
             SLOT(slotMetaInfoLoaded()));
@@ -372,13 +514,26 @@ LoadingDocumentImpl::~LoadingDocumentImpl()
     d->mMetaInfoFutureWatcher.disconnect();
     d->mImageDataFutureWatcher.disconnect();
 
-    d->mMetaInfoFutureWatcher.waitForFinished();
-    d->mImageDataFutureWatcher.waitForFinished();
-
     if (d->mTransferJob) {
+        Tracing::endAsync("kioTransfer", document()->url(), this);
         d->mTransferJob->kill();
     }
-    delete d;
+
+    // Do not block the GUI thread until the worker threads are done: ask
+    // them to stop and let them finish on their own. d is deleted once they
+    // are done.
+    d->mCancelled.store(1);
+    d->mImageDataCancelled.store(1);
+    d->q = nullptr;
+    LoadingDocumentImplPrivate* priv = d;
+    connect(&d->mMetaInfoFutureWatcher, &QFutureWatcher<bool>::finished, [priv]() {
+        priv->deleteWhenDone();
+    });
+    connect(&d->mImageDataFutureWatcher, &QFutureWatcher<void>::finished, [priv]() {
+        priv->deleteWhenDone();
+    });
+    // The futures may have finished before the connections were made
+    d->deleteWhenDone();
 }
 
 void LoadingDocumentImpl::init()
@@ -387,6 +542,7 @@ void LoadingDocumentImpl::init()
 
     if (UrlUtils::urlIsFastLocalFile(url)) {
         // Load file content directly
+        TraceSpan span("readFile", url);
         QFile file(url.toLocalFile());
         if (!file.open(QIODevice::ReadOnly)) {
             setDocumentErrorString(i18nc("@info", "Could not open file %1", url.toLocalFile()));
@@ -394,6 +550,10 @@ void LoadingDocumentImpl::init()
             switchToImpl(new EmptyDocumentImpl(document()));
             return;
         }
+        // Before reading: if the file changes while we read it, the document
+        // looks outdated rather than up to date
+        const QFileInfo info(file);
+        setDocumentFileInfo(info.lastModified(), info.size());
         d->mData = file.read(HEADER_SIZE);
         if (d->determineKind()) {
             return;
@@ -402,6 +562,7 @@ void LoadingDocumentImpl::init()
         d->startLoading();
     } else {
         // Transfer file via KIO
+        Tracing::beginAsync("kioTransfer", url, this);
         d->mTransferJob = KIO::get(document()->url(), KIO::NoReload, KIO::HideProgressInfo);
         connect(d->mTransferJob, SIGNAL(data(KIO::Job*,QByteArray)),
                 SLOT(slotDataReceived(KIO::Job*,QByteArray)));
@@ -421,9 +582,17 @@ void LoadingDocumentImpl::loadImage(int invertedZoom)
         LOG("Ignoring request: we are loading a full image");
         return;
     }
-    d->mImageDataFutureWatcher.waitForFinished();
     d->mImageDataInvertedZoom = invertedZoom;
 
+    if (d->mImageDataFuture.isRunning()) {
+        // Do not wait for the current decode to finish, it is not wanted
+        // anymore. slotImageLoaded() starts the new one when the current one
+        // returns.
+        LOG("Cancelling the decode at invertedZoom=" << d->mLoadingImageDataInvertedZoom);
+        d->mImageDataCancelled.store(1);
+        return;
+    }
+
     if (d->mMetaInfoLoaded) {
         // Do not test on mMetaInfoFuture.isRunning() here: it might not have
         // started if we are downloading the image from a remote url
@@ -436,6 +605,7 @@ void LoadingDocumentImpl::slotDataReceived(KIO::Job* job, const QByteArray& chun
     d->mData.append(chunk);
     if (document()->kind() == MimeTypeUtils::KIND_UNKNOWN && d->mData.length() >= HEADER_SIZE) {
         if (d->determineKind()) {
+            Tracing::endAsync("kioTransfer", document()->url(), this);
             job->kill();
             return;
         }
@@ -444,6 +614,7 @@ void LoadingDocumentImpl::slotDataReceived(KIO::Job* job, const QByteArray& chun
 
 void LoadingDocumentImpl::slotTransferFinished(KJob* job)
 {
+    Tracing::endAsync("kioTransfer", document()->url(), this);
     if (job->error()) {
         setDocumentErrorString(job->errorString());
         emit loadingFailed();
@@ -458,6 +629,63 @@ bool LoadingDocumentImpl::isEditable() const
     return d->mDownSampledImageLoaded;
 }
 
+bool LoadingDocumentImpl::canLoadImageRegions() const
+{
+    if (!d->mMetaInfoLoaded || d->mImageRegionLoadingFailed || d->mFormat != "jpeg") {
+        return false;
+    }
+    if (qint64(d->mImageSize.width()) * d->mImageSize.height() < MIN_IMAGE_REGION_LOADING_PIXELS) {
+        return false;
+    }
+    // Regions are decoded in the coordinates of the file, without applying
+    // its orientation
+    if (GwenviewConfig::applyExifOrientation()
+            && d->mJpegContent.get() && d->mJpegContent->orientation() != NORMAL) {
+        return false;
+    }
+    return true;
+}
+
+void LoadingDocumentImpl::loadImageRegion(const QRect& rect)
+{
+    // Do not give the worker thread access to d: the decoding does not need
+    // to be cancelled, the result is simply ignored if this object is gone
+    const QByteArray data = d->mData;
+    QFutureWatcher<QImage>* watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, rect]() {
+        watcher->deleteLater();
+        const QImage image = watcher->result();
+        if (!image.isNull()) {
+            setDocumentImageRegion(rect, image);
+            return;
+        }
+        setDocumentImageRegion(rect, QImage());
+        if (!d->mImageRegionLoadingFailed) {
+            qWarning() << "Could not decode a region of" << document()->url() << ", loading the full image";
+            d->mImageRegionLoadingFailed = true;
+            document()->startLoadingFullImage();
+        }
+    });
+    watcher->setFuture(WorkerPool::run(document()->workerLane(), [data, rect]() {
+        return JpegRegionDecoder::decode(data, rect);
+    }));
+}
+
+void LoadingDocumentImpl::workerLaneChanged()
+{
+    // A preloaded document is being shown: do not let its decoding wait
+    // behind the rest of the preload lane
+    const WorkerLane::Enum lane = document()->workerLane();
+    if (d->mMetaInfoTask.moveTo(lane, &d->mMetaInfoFuture)) {
+        LOG("Moved meta info loading to" << WorkerPool::laneName(lane));
+        d->mMetaInfoFutureWatcher.setFuture(d->mMetaInfoFuture);
+    }
+    if (d->mImageDataTask.moveTo(lane, &d->mImageDataFuture)) {
+        LOG("Moved image data loading to" << WorkerPool::laneName(lane));
+        d->mImageDataFutureWatcher.setFuture(d->mImageDataFuture);
+    }
+}
+
 Document::LoadingState LoadingDocumentImpl::loadingState() const
 {
     if (!document()->image().isNull()) {
@@ -503,6 +731,13 @@ void LoadingDocumentImpl::slotMetaInfoLoaded()
 void LoadingDocumentImpl::slotImageLoaded()
 {
     LOG("");
+    if (d->mImageDataCancelled.load()) {
+        // loadImage() has been called with another zoom while decoding
+        LOG("Decode cancelled, starting again at invertedZoom=" << d->mImageDataInvertedZoom);
+        d->startImageDataLoading();
+        return;
+    }
+
     if (d->mImage.isNull()) {
         setDocumentErrorString(
             i18nc("@info", "Loading image failed.")
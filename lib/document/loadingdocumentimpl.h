@@ -48,6 +48,9 @@ public:
     void init() override;
     Document::LoadingState loadingState() const override;
     bool isEditable() const override;
+    bool canLoadImageRegions() const override;
+    void loadImageRegion(const QRect& rect) override;
+    void workerLaneChanged() override;
 
     void loadImage(int invertedZoom);
 
@@ -25,7 +25,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QScopedPointer>
-#include <QtConcurrentRun>
 #include <QUrl>
 #include <QApplication>
 #include <QTemporaryFile>
@@ -39,6 +38,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 
 // Local
 #include "documentloadedimpl.h"
+#include "workerpool.h"
 
 namespace Gwenview
 {
@@ -112,7 +112,9 @@ void SaveJob::doStart()
         return;
     }
 
-    QFuture<void> future = QtConcurrent::run(this, &SaveJob::saveInternal);
+    QFuture<void> future = WorkerPool::run(WorkerLane::BulkIO, [this]() {
+        saveInternal();
+    });
     d->mInternalSaveWatcher.reset(new QFutureWatcher<void>(this));
     connect(d->mInternalSaveWatcher.data(), SIGNAL(finished()), SLOT(finishSave()));
     d->mInternalSaveWatcher->setFuture(future);
@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include <lib/imagescaler.h>
 #include <lib/cms/cmsprofile.h>
 #include <lib/gvdebug.h>
+#include <lib/tracing.h>
 
 // KDE
 
@@ -34,6 +35,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #include <QPainter>
 #include <QTimer>
 #include <QPointer>
+#include <QVector>
 #include <QDebug>
 
 
@@ -45,6 +47,7 @@ struct RasterImageViewPrivate
     RasterImageView* q;
     ImageScaler* mScaler;
     bool mEmittedCompleted;
+    bool mTracedFirstPaint;
 
     // Config
     AbstractImageView::AlphaBackgroundMode mAlphaBackgroundMode;
@@ -54,64 +57,56 @@ struct RasterImageViewPrivate
     // /Config
 
     bool mBufferIsEmpty;
+    // The buffer wraps around in both directions: the top-left corner of the
+    // viewport is stored at mBufferOrigin and what does not fit on the right
+    // or bottom of the buffer continues on the left or top. Scrolling only
+    // moves the origin and clears the exposed strips, so its cost depends on
+    // the exposed area instead of the size of the viewport.
     QPixmap mCurrentBuffer;
-    // The alternate buffer is useful when scrolling: existing content is copied
-    // to mAlternateBuffer and buffers are swapped. This avoids allocating a new
-    // QPixmap every time the image is scrolled.
-    QPixmap mAlternateBuffer;
+    QPoint mBufferOrigin;
 
     QTimer* mUpdateTimer;
 
     QPointer<AbstractRasterImageViewTool> mTool;
 
     bool mApplyDisplayTransform; // Defaults to true. Can be set to false if there is no need or no way to apply color profile
-    cmsHTRANSFORM mDisplayTransform;
 
-    void updateDisplayTransform(QImage::Format format)
+    /**
+     * Converts @p image to the colors of the monitor. Images keep their
+     * format when possible: they are only converted when they are drawn on
+     * the buffer.
+     */
+    void applyDisplayTransform(QImage* image)
     {
-        GV_RETURN_IF_FAIL(format != QImage::Format_Invalid);
-        mApplyDisplayTransform = false;
-        if (mDisplayTransform) {
-            cmsDeleteTransform(mDisplayTransform);
-        }
-        mDisplayTransform = nullptr;
-
         Cms::Profile::Ptr profile = q->document()->cmsProfile();
         if (!profile) {
             // The assumption that something unmarked is *probably* sRGB is better than failing to apply any transform when one
             // has a wide-gamut screen.
-            profile = Cms::Profile::getSRgbProfile();
+            bool gray = image->format() == QImage::Format_Grayscale8;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+            gray = gray || image->format() == QImage::Format_Grayscale16;
+#endif
+            profile = gray ? Cms::Profile::getGrayProfile() : Cms::Profile::getSRgbProfile();
         }
         Cms::Profile::Ptr monitorProfile = Cms::Profile::getMonitorProfile();
         if (!monitorProfile) {
             qWarning() << "Could not get monitor color profile";
+            mApplyDisplayTransform = false;
             return;
         }
-
-        cmsUInt32Number cmsFormat = 0;
-        switch (format) {
-        case QImage::Format_RGB32:
-        case QImage::Format_ARGB32:
-            cmsFormat = TYPE_BGRA_8;
-            break;
-        case QImage::Format_Grayscale8:
-            cmsFormat = TYPE_GRAY_8;
-            break;
-        default:
-            qWarning() << "Gwenview can only apply color profile on RGB32 or ARGB32 images";
-            return;
+        if (!Cms::transformImage(image, profile, monitorProfile, mRenderingIntent)) {
+            qWarning() << "Gwenview cannot apply color profile on images of format" << image->format();
+            mApplyDisplayTransform = false;
         }
-
-        mDisplayTransform = cmsCreateTransform(profile->handle(), cmsFormat,
-                                               monitorProfile->handle(), cmsFormat,
-                                               mRenderingIntent, cmsFLAGS_BLACKPOINTCOMPENSATION);
-        mApplyDisplayTransform = true;
     }
 
     void setupUpdateTimer()
     {
+        // The scaler shows a fast pass right away and refines it in the
+        // background, so the update only needs to wait until all pending
+        // resize events have been processed
         mUpdateTimer = new QTimer(q);
-        mUpdateTimer->setInterval(500);
+        mUpdateTimer->setInterval(0);
         mUpdateTimer->setSingleShot(true);
         QObject::connect(mUpdateTimer, SIGNAL(timeout()), q, SLOT(updateBuffer()));
     }
@@ -137,6 +132,59 @@ struct RasterImageViewPrivate
         mScaler->setDestinationRegion(QRegion(rect.toRect()));
     }
 
+    /**
+     * A part of the viewport which is stored in one piece in the buffer
+     */
+    struct BufferPiece
+    {
+        QRect mViewportRect;
+        QPoint mBufferPos;
+
+        QRect bufferRect() const
+        {
+            return QRect(mBufferPos, mViewportRect.size());
+        }
+    };
+
+    /**
+     * Splits @p viewportRect in up to four pieces, where it wraps around the
+     * edges of the buffer
+     */
+    QVector<BufferPiece> bufferPieces(const QRect& viewportRect) const
+    {
+        QVector<BufferPiece> pieces;
+        const QSize size = mCurrentBuffer.size();
+        const QRect rect = viewportRect.intersected(QRect(QPoint(0, 0), size));
+        if (rect.isEmpty()) {
+            return pieces;
+        }
+        const int bufferLeft = (rect.left() + mBufferOrigin.x()) % size.width();
+        const int bufferTop = (rect.top() + mBufferOrigin.y()) % size.height();
+        const int leftWidth = qMin(rect.width(), size.width() - bufferLeft);
+        const int topHeight = qMin(rect.height(), size.height() - bufferTop);
+
+        // {viewport start, length, buffer start} in each direction
+        const int columns[2][3] = {
+            {rect.left(), leftWidth, bufferLeft},
+            {rect.left() + leftWidth, rect.width() - leftWidth, 0}
+        };
+        const int rows[2][3] = {
+            {rect.top(), topHeight, bufferTop},
+            {rect.top() + topHeight, rect.height() - topHeight, 0}
+        };
+        for (const auto& row : rows) {
+            for (const auto& column : columns) {
+                if (row[1] > 0 && column[1] > 0) {
+                    BufferPiece piece;
+                    piece.mViewportRect = QRect(column[0], row[0], column[1], row[1]);
+                    piece.mBufferPos = QPoint(column[2], row[2]);
+                    pieces << piece;
+                }
+            }
+        }
+        return pieces;
+    }
+
     void resizeBuffer()
     {
         QSize size = q->visibleImageSize().toSize();
@@ -144,20 +192,24 @@ struct RasterImageViewPrivate
             return;
         }
         if (!size.isValid()) {
-            mAlternateBuffer = QPixmap();
             mCurrentBuffer = QPixmap();
+            mBufferOrigin = QPoint();
             return;
         }
 
-        mAlternateBuffer = QPixmap(size);
-        mAlternateBuffer.fill(Qt::transparent);
+        QPixmap buffer(size);
+        buffer.fill(Qt::transparent);
         {
-            QPainter painter(&mAlternateBuffer);
-            painter.drawPixmap(0, 0, mCurrentBuffer);
+            // Unwrap the content: the new buffer starts at the top-left
+            // corner of the viewport
+            QPainter painter(&buffer);
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+            for (const BufferPiece& piece : bufferPieces(mCurrentBuffer.rect())) {
+                painter.drawPixmap(piece.mViewportRect.topLeft(), mCurrentBuffer, piece.bufferRect());
+            }
         }
-        qSwap(mAlternateBuffer, mCurrentBuffer);
-
-        mAlternateBuffer = QPixmap();
+        mCurrentBuffer = buffer;
+        mBufferOrigin = QPoint();
     }
 
     void drawAlphaBackground(QPainter* painter, const QRect& viewportRect, const QPoint& zoomedImageTopLeft, QPixmap texture)
@@ -192,8 +244,8 @@ RasterImageView::RasterImageView(QGraphicsItem* parent)
 {
     d->q = this;
     d->mEmittedCompleted = false;
+    d->mTracedFirstPaint = false;
     d->mApplyDisplayTransform = true;
-    d->mDisplayTransform = nullptr;
 
     d->mAlphaBackgroundMode = AlphaBackgroundNone;
     d->mAlphaBackgroundColor = Qt::black;
@@ -212,9 +264,6 @@ RasterImageView::~RasterImageView()
     if (d->mTool) {
         d->mTool.data()->toolDeactivated();
     }
-    if (d->mDisplayTransform) {
-        cmsDeleteTransform(d->mDisplayTransform);
-    }
     delete d;
 }
 
@@ -327,33 +376,37 @@ void RasterImageView::slotDocumentIsAnimatedUpdated()
     d->startAnimationIfNecessary();
 }
 
-void RasterImageView::updateFromScaler(int zoomedImageLeft, int zoomedImageTop, const QImage& image)
+void RasterImageView::updateFromScaler(int zoomedImageLeft, int zoomedImageTop, const QImage& scaledImage)
 {
+    QImage image = scaledImage;
     if (d->mApplyDisplayTransform) {
-        d->updateDisplayTransform(image.format());
-        if (d->mDisplayTransform) {
-            quint8 *bytes = const_cast<quint8*>(image.bits());
-            cmsDoTransform(d->mDisplayTransform, bytes, bytes, image.width() * image.height());
-        }
+        TraceSpan span("displayTransform", document()->url());
+        d->applyDisplayTransform(&image);
     }
 
     d->resizeBuffer();
-    int viewportLeft = zoomedImageLeft - scrollPos().x();
-    int viewportTop = zoomedImageTop - scrollPos().y();
+    const QPoint scrollPoint = scrollPos().toPoint();
+    const QRect viewportRect(zoomedImageLeft - scrollPoint.x(), zoomedImageTop - scrollPoint.y(), image.width(), image.height());
     d->mBufferIsEmpty = false;
     {
         QPainter painter(&d->mCurrentBuffer);
-        painter.setCompositionMode(QPainter::CompositionMode_Source);
-        if (document()->hasAlphaChannel()) {
-            d->drawAlphaBackground(
-                &painter, QRect(viewportLeft, viewportTop, image.width(), image.height()),
-                QPoint(zoomedImageLeft, zoomedImageTop),
-                alphaBackgroundTexture()
-            );
-            // This is required so transparent pixels don't replace our background
-            painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        for (const RasterImageViewPrivate::BufferPiece& piece : d->bufferPieces(viewportRect)) {
+            // Draw in viewport coordinates, clipped to the piece
+            painter.resetTransform();
+            painter.setClipRect(piece.bufferRect());
+            painter.translate(piece.mBufferPos - piece.mViewportRect.topLeft());
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+            if (document()->hasAlphaChannel()) {
+                d->drawAlphaBackground(
+                    &painter, viewportRect,
+                    QPoint(zoomedImageLeft, zoomedImageTop),
+                    alphaBackgroundTexture()
+                );
+                // This is required so transparent pixels don't replace our background
+                painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+            }
+            painter.drawImage(viewportRect.topLeft(), image);
         }
-        painter.drawImage(viewportLeft, viewportTop, image);
     }
     update();
 
@@ -378,38 +431,73 @@ void RasterImageView::onImageOffsetChanged()
 
 void RasterImageView::onScrollPosChanged(const QPointF& oldPos)
 {
-    QPointF delta = scrollPos() - oldPos;
+    const QPoint delta = scrollPos().toPoint() - oldPos.toPoint();
+    if (delta.isNull()) {
+        return;
+    }
+    const QSize size = d->mCurrentBuffer.size();
+    if (d->mCurrentBuffer.isNull() || qAbs(delta.x()) >= size.width() || qAbs(delta.y()) >= size.height()) {
+        // Nothing can be reused
+        d->mCurrentBuffer.fill(Qt::transparent);
+        d->mBufferOrigin = QPoint();
+        updateBuffer();
+        update();
+        return;
+    }
 
     // Scroll existing
+    d->mBufferOrigin = QPoint(
+        (d->mBufferOrigin.x() + delta.x() + size.width()) % size.width(),
+        (d->mBufferOrigin.y() + delta.y() + size.height()) % size.height());
+
+    // Clear exposed strips, they still contain what has just been scrolled
+    // out on the opposite side
+    const QRect viewportRect(QPoint(0, 0), size);
+    const QRegion exposedRegion = QRegion(viewportRect) - QRegion(viewportRect.translated(-delta));
     {
-        if (d->mAlternateBuffer.size() != d->mCurrentBuffer.size()) {
-            d->mAlternateBuffer = QPixmap(d->mCurrentBuffer.size());
+        QPainter painter(&d->mCurrentBuffer);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        for (const QRect& rect : exposedRegion) {
+            for (const RasterImageViewPrivate::BufferPiece& piece : d->bufferPieces(rect)) {
+                painter.fillRect(piece.bufferRect(), Qt::transparent);
+            }
         }
-        d->mAlternateBuffer.fill(Qt::transparent);
-        QPainter painter(&d->mAlternateBuffer);
-        painter.drawPixmap(-delta, d->mCurrentBuffer);
     }
-    qSwap(d->mCurrentBuffer, d->mAlternateBuffer);
 
     // Scale missing parts
-    QRegion bufferRegion = QRegion(d->mCurrentBuffer.rect().translated(scrollPos().toPoint()));
-    QRegion updateRegion = bufferRegion - bufferRegion.translated(-delta.toPoint());
-    updateBuffer(updateRegion);
+    updateBuffer(exposedRegion.translated(scrollPos().toPoint()));
     update();
 }
 
 void RasterImageView::paint(QPainter* painter, const QStyleOptionGraphicsItem* /*option*/, QWidget* /*widget*/)
 {
     QPointF topLeft = imageOffset();
+    const QVector<RasterImageViewPrivate::BufferPiece> pieces = d->bufferPieces(d->mCurrentBuffer.rect());
     if (zoomToFit()) {
         // In zoomToFit mode, scale crudely the buffer to fit the screen. This
         // provide an approximate rendered which will be replaced when the scheduled
         // proper scale is ready.
         // Round point and size independently, to keep consistency with the below (non zoomToFit) painting
         const QRect rect = QRect(topLeft.toPoint(), (documentSize() * zoom()).toSize());
-        painter->drawPixmap(rect, d->mCurrentBuffer);
+        for (const RasterImageViewPrivate::BufferPiece& piece : pieces) {
+            const qreal xScale = qreal(rect.width()) / d->mCurrentBuffer.width();
+            const qreal yScale = qreal(rect.height()) / d->mCurrentBuffer.height();
+            const QRectF target(
+                rect.left() + piece.mViewportRect.left() * xScale,
+                rect.top() + piece.mViewportRect.top() * yScale,
+                piece.mViewportRect.width() * xScale,
+                piece.mViewportRect.height() * yScale);
+            painter->drawPixmap(target, d->mCurrentBuffer, QRectF(piece.bufferRect()));
+        }
     } else {
-        painter->drawPixmap(topLeft.toPoint(), d->mCurrentBuffer);
+        for (const RasterImageViewPrivate::BufferPiece& piece : pieces) {
+            painter->drawPixmap(topLeft.toPoint() + piece.mViewportRect.topLeft(), d->mCurrentBuffer, piece.bufferRect());
+        }
+    }
+
+    if (!d->mTracedFirstPaint && !d->mBufferIsEmpty) {
+        d->mTracedFirstPaint = true;
+        Tracing::instant("firstPaint", document()->url());
     }
 
     if (d->mTool) {
@@ -430,9 +518,9 @@ void RasterImageView::paint(QPainter* painter, const QStyleOptionGraphicsItem* /
 void RasterImageView::resizeEvent(QGraphicsSceneResizeEvent* event)
 {
     // If we are in zoomToFit mode and have something in our buffer, delay the
-    // update: paint() will paint a scaled version of the buffer until resizing
-    // is done. This is much faster than rescaling the whole image for each
-    // resize event we receive.
+    // update until pending resize events have been processed: paint() paints
+    // a scaled version of the buffer meanwhile. This avoids rescaling the
+    // image for each resize event of a batch.
     // mUpdateTimer must be started before calling AbstractImageView::resizeEvent()
     // because AbstractImageView::resizeEvent() will call onZoomChanged(), which
     // will trigger an immediate update unless the mUpdateTimer is active.
@@ -29,14 +29,261 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 // KDE
 
 // Exiv2
+#include <exiv2/basicio.hpp>
 #include <exiv2/error.hpp>
 #include <exiv2/types.hpp>
+#include <exiv2/version.hpp>
 
 // Local
 
 namespace Gwenview
 {
 
+/**
+ * How many bytes are read when Exiv2 reads right after the previous read,
+ * as when it goes through JPEG markers
+ */
+static const qint64 SEQUENTIAL_READ_AHEAD = 4096;
+
+/**
+ * How many bytes are read after a seek, as when Exiv2 skips a PNG chunk:
+ * only the next chunk header is needed
+ */
+static const qint64 SEEK_READ_AHEAD = 512;
+
+/**
+ * Read-only Exiv2 IO which only reads the bytes Exiv2 asks for. Exiv2
+ * parsers seek over the image data, and TIFF based formats map the file,
+ * so only the pages holding the IFDs get read. Reading the metadata of a
+ * file on a network file system thus transfers a few kilobytes instead of
+ * the whole file.
+ */
+class HeaderFileIo : public Exiv2::BasicIo
+{
+public:
+#ifdef _MSC_VER
+    typedef int64_t SeekOffset;
+#else
+    typedef long SeekOffset;
+#endif
+
+    explicit HeaderFileIo(const QString& path)
+    : mFile(path)
+    , mSize(0)
+    , mPos(0)
+    , mWindowStart(0)
+    , mMap(nullptr)
+    , mError(0)
+    , mEof(false)
+    {}
+
+    ~HeaderFileIo() override
+    {
+        close();
+    }
+
+    int open() override
+    {
+        close();
+        // Unbuffered, so that QFile does not read more than asked
+        if (!mFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+            return 1;
+        }
+        mSize = mFile.size();
+        mPos = 0;
+        mError = 0;
+        mEof = false;
+        return 0;
+    }
+
+    int close() override
+    {
+        munmap();
+        mFile.close();
+        mWindow.clear();
+        mWindowStart = 0;
+        return 0;
+    }
+
+    long write(const Exiv2::byte*, long) override
+    {
+        return 0;
+    }
+
+    long write(Exiv2::BasicIo&) override
+    {
+        return 0;
+    }
+
+    int putb(Exiv2::byte) override
+    {
+        return EOF;
+    }
+
+    void transfer(Exiv2::BasicIo&) override
+    {
+        // Read-only, metadata is never written through this IO
+    }
+
+    Exiv2::DataBuf read(long count) override
+    {
+        Exiv2::DataBuf buf(count);
+        buf.size_ = read(buf.pData_, count);
+        return buf;
+    }
+
+    long read(Exiv2::byte* buf, long count) override
+    {
+        if (count <= 0 || !mFile.isOpen()) {
+            return 0;
+        }
+        if (count > mSize - mPos) {
+            mEof = true;
+            count = long(qMax(mSize - mPos, qint64(0)));
+            if (count == 0) {
+                return 0;
+            }
+        }
+        const qint64 windowEnd = mWindowStart + mWindow.size();
+        if (mPos < mWindowStart || mPos + count > windowEnd) {
+            const qint64 readAhead = mPos == windowEnd ? SEQUENTIAL_READ_AHEAD : SEEK_READ_AHEAD;
+            fillWindow(qMax(qint64(count), readAhead));
+        }
+        count = long(qMin(qint64(count), mWindowStart + mWindow.size() - mPos));
+        memcpy(buf, mWindow.constData() + (mPos - mWindowStart), count);
+        mPos += count;
+        return count;
+    }
+
+    int getb() override
+    {
+        Exiv2::byte value;
+        return read(&value, 1) == 1 ? value : EOF;
+    }
+
+    int seek(SeekOffset offset, Position position) override
+    {
+        qint64 pos = offset;
+        if (position == cur) {
+            pos += mPos;
+        } else if (position == end) {
+            pos += mSize;
+        }
+        if (pos < 0) {
+            return 1;
+        }
+        if (pos > mSize) {
+            mEof = true;
+            return 1;
+        }
+        mPos = pos;
+        mEof = false;
+        return 0;
+    }
+
+    Exiv2::byte* mmap(bool isWriteable) override
+    {
+        if (isWriteable) {
+            return nullptr;
+        }
+        munmap();
+        mMap = mFile.map(0, mSize);
+        if (mMap) {
+            return mMap;
+        }
+        // Some file systems cannot map files
+        mFile.seek(0);
+        mMapFallback = mFile.readAll();
+        if (mMapFallback.size() != mSize) {
+            mError = 1;
+        }
+        return reinterpret_cast<Exiv2::byte*>(mMapFallback.data());
+    }
+
+    int munmap() override
+    {
+        if (mMap) {
+            mFile.unmap(mMap);
+            mMap = nullptr;
+        }
+        mMapFallback.clear();
+        return 0;
+    }
+
+    long tell() const override
+    {
+        return long(mPos);
+    }
+
+    size_t size() const override
+    {
+        return size_t(mSize);
+    }
+
+    bool isopen() const override
+    {
+        return mFile.isOpen();
+    }
+
+    int error() const override
+    {
+        return mError;
+    }
+
+    bool eof() const override
+    {
+        return mEof;
+    }
+
+    std::string path() const override
+    {
+        return QFile::encodeName(mFile.fileName()).toStdString();
+    }
+
+#ifdef EXV_UNICODE_PATH
+    std::wstring wpath() const override
+    {
+        return mFile.fileName().toStdWString();
+    }
+#endif
+
+#if EXIV2_TEST_VERSION(0, 27, 0)
+    void populateFakeData() override
+    {
+    }
+#endif
+
+private:
+    QFile mFile;
+    qint64 mSize;
+    qint64 mPos;
+
+    // Last bytes read from the file, small reads of Exiv2 are served from
+    // there
+    QByteArray mWindow;
+    qint64 mWindowStart;
+
+    uchar* mMap;
+    QByteArray mMapFallback;
+    int mError;
+    bool mEof;
+
+    void fillWindow(qint64 length)
+    {
+        length = qMin(length, mSize - mPos);
+        mWindowStart = mPos;
+        mWindow.resize(int(length));
+        qint64 readSize = -1;
+        if (mFile.seek(mPos)) {
+            readSize = mFile.read(mWindow.data(), length);
+        }
+        if (readSize < length) {
+            mError = 1;
+            mWindow.resize(int(qMax(readSize, qint64(0))));
+        }
+    }
+};
+
 struct Exiv2ImageLoaderPrivate
 {
     Exiv2::Image::AutoPtr mImage;
@@ -55,9 +302,13 @@ Exiv2ImageLoader::~Exiv2ImageLoader()
 
 bool Exiv2ImageLoader::load(const QString& filePath)
 {
-    QByteArray filePathByteArray = QFile::encodeName(filePath);
     try {
-        d->mImage = Exiv2::ImageFactory::open(filePathByteArray.constData());
+        Exiv2::BasicIo::AutoPtr io(new HeaderFileIo(filePath));
+        d->mImage = Exiv2::ImageFactory::open(io);
+        if (!d->mImage.get()) {
+            d->mErrorMessage = QStringLiteral("Unknown image type");
+            return false;
+        }
         d->mImage->readMetadata();
     } catch (const Exiv2::Error& error) {
         d->mErrorMessage = QString::fromUtf8(error.what());
@@ -24,6 +24,8 @@ Gwenview: an image viewer
 
 #include "bayer.h"
 
+#include <lib/gwenviewlib_export.h>
+
 typedef enum { FITS_NORMAL, FITS_FOCUS, FITS_GUIDE, FITS_CALIBRATE, FITS_ALIGN } FITSMode;
 
 #ifdef WIN32
@@ -39,7 +41,7 @@ typedef enum { FITS_NORMAL, FITS_FOCUS, FITS_GUIDE, FITS_CALIBRATE, FITS_ALIGN }
 #include <QRectF>
 
 
-class FITSData
+class GWENVIEWLIB_EXPORT FITSData
 {
   public:
     FITSData();
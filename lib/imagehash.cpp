@@ -0,0 +1,70 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "imagehash.h"
+
+// Qt
+#include <QtAlgorithms>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+namespace ImageHash
+{
+
+static const int HASH_WIDTH = 8;
+static const int HASH_HEIGHT = 8;
+
+quint64 differenceHash(const QImage& image)
+{
+    if (image.isNull()) {
+        return 0;
+    }
+    // Smooth scaling averages the source pixels, which is what makes the
+    // hash insensitive to resizing and compression artifacts
+    const QImage small = image.convertToFormat(QImage::Format_RGB32)
+        .scaled(HASH_WIDTH + 1, HASH_HEIGHT, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    quint64 hash = 0;
+    for (int y = 0; y < HASH_HEIGHT; ++y) {
+        const QRgb* line = reinterpret_cast<const QRgb*>(small.constScanLine(y));
+        for (int x = 0; x < HASH_WIDTH; ++x) {
+            hash <<= 1;
+            if (qGray(line[x]) < qGray(line[x + 1])) {
+                hash |= 1;
+            }
+        }
+    }
+    return hash;
+}
+
+int distance(quint64 hash1, quint64 hash2)
+{
+    return qPopulationCount(hash1 ^ hash2);
+}
+
+} // namespace
+
+} // namespace
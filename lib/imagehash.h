@@ -0,0 +1,61 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef IMAGEHASH_H
+#define IMAGEHASH_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QImage>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+/**
+ * Perceptual hashes of images. Two images which look alike have hashes
+ * differing by a few bits only, even if they have been resized, recompressed
+ * or slightly retouched, which makes it possible to find duplicates and
+ * near-duplicates.
+ */
+namespace ImageHash
+{
+
+/**
+ * Returns the difference hash (dHash) of @p image: the image is reduced to
+ * 9x8 gray pixels, each bit tells whether a pixel is brighter than its left
+ * neighbor. It is cheap enough to be computed on thumbnails.
+ */
+GWENVIEWLIB_EXPORT quint64 differenceHash(const QImage& image);
+
+/**
+ * Returns the number of bits differing between @p hash1 and @p hash2
+ */
+GWENVIEWLIB_EXPORT int distance(quint64 hash1, quint64 hash2);
+
+} // namespace
+
+} // namespace
+
+#endif /* IMAGEHASH_H */
@@ -0,0 +1,749 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "imagehashindex.h"
+
+// STL
+#include <algorithm>
+
+// Qt
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFuture>
+#include <QHash>
+#include <QLockFile>
+#include <QMutex>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QVector>
+
+// KDE
+
+// Local
+#include "cachedirs.h"
+#include "imagehash.h"
+#include "workerpool.h"
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+static const quint32 INDEX_MAGIC = 0x47564948; // "GVIH"
+static const quint32 INDEX_VERSION = 3;
+
+/**
+ * How long to wait for another process (for example gwenview_prewarm) to
+ * release the index, in milliseconds
+ */
+static const int LOCK_TIMEOUT = 10000;
+
+/**
+ * Number of records kept in memory before they are appended to the log
+ */
+static const int FLUSH_THRESHOLD = 256;
+
+/**
+ * The log is compacted when it contains more stale records than this and
+ * than up to date ones
+ */
+static const qint64 MIN_STALE_RECORDS = 10000;
+
+/**
+ * Modification time of the records of removed urls
+ */
+static const qint64 REMOVED_MODIFICATION_TIME = -1;
+
+static QString urlString(const QUrl& url)
+{
+    return url.adjusted(QUrl::RemovePassword | QUrl::NormalizePathSegments).url();
+}
+
+/**
+ * Entries are keyed by the first 64 bits of the MD5 of their url, so that
+ * urls do not have to be kept in memory
+ */
+static quint64 keyForUrl(const QString& url)
+{
+    const QByteArray md5 = QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Md5);
+    return qFromBigEndian<quint64>(reinterpret_cast<const uchar*>(md5.constData()));
+}
+
+static QString indexPath()
+{
+    return ImageHashIndex::cacheDir() + QStringLiteral("index");
+}
+
+static QString lockPath()
+{
+    return indexPath() + QStringLiteral(".lock");
+}
+
+/**
+ * The log is shared with other processes: it must be locked while it is
+ * read or written
+ */
+static bool lockLog(QLockFile* lock)
+{
+    QDir().mkpath(ImageHashIndex::cacheDir());
+    if (!lock->tryLock(LOCK_TIMEOUT)) {
+        qWarning() << "Could not lock image hash index" << indexPath() << lock->error();
+        return false;
+    }
+    return true;
+}
+
+static quint64 createLogId()
+{
+    return (quint64(QDateTime::currentMSecsSinceEpoch()) << 20) ^ quint64(QCoreApplication::applicationPid());
+}
+
+/**
+ * Opens the log, if it is still the one identified by @p logId. Urls can
+ * then be read at the offsets found when it was read, even if another
+ * process replaces it in the meantime.
+ */
+static bool openLog(QFile* file, quint64 logId)
+{
+    if (!file->open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(file);
+    quint32 magic, version;
+    quint64 fileLogId;
+    stream >> magic >> version >> fileLogId;
+    if (stream.status() != QDataStream::Ok || magic != INDEX_MAGIC || version != INDEX_VERSION || fileLogId != logId) {
+        file->close();
+        return false;
+    }
+    return true;
+}
+
+static QString readUrl(QFile* file, qint64 offset)
+{
+    QByteArray url;
+    if (file->seek(offset)) {
+        QDataStream stream(file);
+        stream >> url;
+    }
+    return QString::fromUtf8(url);
+}
+
+struct IndexEntry
+{
+    qint64 mModificationTime;
+    quint64 mHash;
+    // Position of the url in the log, -1 if it has not been written yet
+    qint64 mUrlOffset;
+};
+
+/**
+ * Urls of the records which have not been written yet. Removed urls are
+ * recorded with an empty url.
+ */
+typedef QHash<quint64, QString> PendingUrls;
+
+/**
+ * A node of the BK-tree: children are indexed by their distance to the
+ * node, so that a query only has to visit the children whose distance is
+ * within maxDistance of the distance between the query and the node
+ */
+struct BkNode
+{
+    quint64 mHash;
+    // Keys of the urls which had this hash when they were inserted. Some of
+    // them may have changed since then, they are checked against mEntries.
+    QVector<quint64> mKeys;
+    QVector<QPair<int, int> > mChildren; // distance, node index
+};
+
+/**
+ * The entries of the index and what is known of the log they come from
+ */
+struct IndexData
+{
+    QHash<quint64, IndexEntry> mEntries;
+    QVector<BkNode> mNodes;
+    QHash<quint64, int> mNodeForHash;
+    qint64 mRecordCountOnDisk;
+    // Identifies the log we have read, a new one is created each time the
+    // log is compacted
+    quint64 mLogId;
+    // Position of the first record we have not read yet
+    qint64 mLogOffset;
+
+    IndexData()
+    : mRecordCountOnDisk(0)
+    , mLogId(0)
+    , mLogOffset(0)
+    {}
+
+    void clear()
+    {
+        *this = IndexData();
+    }
+
+    void rebuildTree()
+    {
+        mNodes.clear();
+        mNodeForHash.clear();
+        for (auto it = mEntries.constBegin(), end = mEntries.constEnd(); it != end; ++it) {
+            addToTree(it.key(), it.value().mHash);
+        }
+    }
+
+    void addToTree(quint64 key, quint64 hash)
+    {
+        auto it = mNodeForHash.constFind(hash);
+        if (it != mNodeForHash.constEnd()) {
+            QVector<quint64>& keys = mNodes[it.value()].mKeys;
+            if (!keys.contains(key)) {
+                keys << key;
+            }
+            return;
+        }
+
+        const int newIndex = mNodes.size();
+        int current = 0;
+        while (current < newIndex) {
+            BkNode& node = mNodes[current];
+            const int dist = ImageHash::distance(node.mHash, hash);
+            int child = -1;
+            for (const auto& pair : qAsConst(node.mChildren)) {
+                if (pair.first == dist) {
+                    child = pair.second;
+                    break;
+                }
+            }
+            if (child == -1) {
+                node.mChildren.append(qMakePair(dist, newIndex));
+                break;
+            }
+            current = child;
+        }
+
+        BkNode node;
+        node.mHash = hash;
+        node.mKeys << key;
+        mNodes.append(node);
+        mNodeForHash.insert(hash, newIndex);
+    }
+
+    bool needsCompaction(int pendingCount) const
+    {
+        const qint64 staleCount = mRecordCountOnDisk + pendingCount - mEntries.size();
+        return staleCount > qMax(MIN_STALE_RECORDS, qint64(mEntries.size()));
+    }
+
+    /**
+     * Reads the records appended to the log by other processes since we last
+     * read it, or the whole log if it has been compacted in the meantime.
+     * Records of @p pendingUrls are skipped, ours are more recent.
+     * Must be called with the log locked.
+     *
+     * @return false if the log is broken and must be rewritten
+     */
+    bool readLog(const PendingUrls& pendingUrls)
+    {
+        QFile file(indexPath());
+        if (!file.open(QIODevice::ReadOnly)) {
+            mLogId = 0;
+            mLogOffset = 0;
+            mRecordCountOnDisk = 0;
+            return true;
+        }
+        QDataStream stream(&file);
+        quint32 magic, version;
+        quint64 logId;
+        stream >> magic >> version >> logId;
+        if (stream.status() != QDataStream::Ok || magic != INDEX_MAGIC || version != INDEX_VERSION) {
+            LOG("Discarding index with unknown format");
+            return false;
+        }
+
+        bool fullRead = false;
+        QHash<quint64, IndexEntry> pendingEntries;
+        if (logId != mLogId || file.size() < mLogOffset) {
+            // Another process compacted the log: read it from scratch, but
+            // keep what we have not written yet
+            LOG("Log has been replaced, reading it again");
+            for (auto it = pendingUrls.constBegin(), end = pendingUrls.constEnd(); it != end; ++it) {
+                auto entryIt = mEntries.constFind(it.key());
+                if (entryIt != mEntries.constEnd()) {
+                    pendingEntries.insert(it.key(), entryIt.value());
+                }
+            }
+            clear();
+            mLogId = logId;
+            mLogOffset = file.pos();
+            fullRead = true;
+        } else {
+            file.seek(mLogOffset);
+        }
+
+        bool ok = true;
+        while (!stream.atEnd()) {
+            quint64 key;
+            IndexEntry entry;
+            quint32 urlSize;
+            stream >> key >> entry.mModificationTime >> entry.mHash;
+            entry.mUrlOffset = file.pos();
+            // Skip the url, it is only read when it is returned
+            stream >> urlSize;
+            if (stream.status() != QDataStream::Ok
+                || (urlSize != 0xffffffff && stream.skipRawData(urlSize) != int(urlSize))) {
+                // A process probably crashed while appending records
+                ok = false;
+                break;
+            }
+            mLogOffset = file.pos();
+            ++mRecordCountOnDisk;
+            if (pendingUrls.contains(key)) {
+                continue;
+            }
+            if (entry.mModificationTime == REMOVED_MODIFICATION_TIME) {
+                mEntries.remove(key);
+            } else {
+                mEntries.insert(key, entry);
+                if (!fullRead) {
+                    addToTree(key, entry.mHash);
+                }
+            }
+        }
+        if (fullRead) {
+            for (auto it = pendingEntries.constBegin(), end = pendingEntries.constEnd(); it != end; ++it) {
+                mEntries.insert(it.key(), it.value());
+            }
+            rebuildTree();
+        }
+        LOG("Read log up to" << mLogOffset << "," << mEntries.size() << "hashes from" << mRecordCountOnDisk << "records");
+        return ok;
+    }
+
+    /**
+     * Rewrites the log with the up to date entries only, including those of
+     * @p pendingUrls. Must be called with the log locked, after readLog().
+     */
+    bool compact(const PendingUrls& pendingUrls)
+    {
+        LOG("Compacting" << mRecordCountOnDisk << "records into" << mEntries.size());
+        // Urls which have been written are copied from the current log, in
+        // the order they appear in it
+        QFile oldFile(indexPath());
+        const bool hasOldLog = mLogId != 0 && openLog(&oldFile, mLogId);
+        QVector<QPair<qint64, quint64> > urlOffsets; // url offset, key
+        urlOffsets.reserve(mEntries.size());
+        for (auto it = mEntries.constBegin(), end = mEntries.constEnd(); it != end; ++it) {
+            urlOffsets << qMakePair(it.value().mUrlOffset, it.key());
+        }
+        std::sort(urlOffsets.begin(), urlOffsets.end());
+
+        QSaveFile file(indexPath());
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "Could not write image hash index" << indexPath();
+            return false;
+        }
+        const quint64 logId = createLogId();
+        QDataStream stream(&file);
+        stream << INDEX_MAGIC << INDEX_VERSION << logId;
+        QHash<quint64, qint64> newUrlOffsets;
+        newUrlOffsets.reserve(urlOffsets.size());
+        for (const auto& pair : qAsConst(urlOffsets)) {
+            const quint64 key = pair.second;
+            QString url = pendingUrls.value(key);
+            if (url.isEmpty() && hasOldLog && pair.first >= 0) {
+                url = readUrl(&oldFile, pair.first);
+            }
+            if (url.isEmpty()) {
+                continue;
+            }
+            const IndexEntry& entry = mEntries[key];
+            stream << key << entry.mModificationTime << entry.mHash;
+            newUrlOffsets.insert(key, file.pos());
+            stream << url.toUtf8();
+        }
+        const qint64 size = file.pos();
+        if (!file.commit()) {
+            qWarning() << "Could not write image hash index" << indexPath();
+            return false;
+        }
+        for (auto it = mEntries.begin(); it != mEntries.end();) {
+            auto offsetIt = newUrlOffsets.constFind(it.key());
+            if (offsetIt == newUrlOffsets.constEnd()) {
+                // Its url could not be read
+                it = mEntries.erase(it);
+            } else {
+                it->mUrlOffset = offsetIt.value();
+                ++it;
+            }
+        }
+        mLogId = logId;
+        mLogOffset = size;
+        mRecordCountOnDisk = mEntries.size();
+        return true;
+    }
+};
+
+struct ImageHashIndexPrivate
+{
+    mutable QMutex mMutex;
+    IndexData mData;
+    PendingUrls mPendingUrls;
+    bool mLoaded;
+    // Incremented by each load, so that an outdated one is ignored
+    int mLoadGeneration;
+    QFuture<void> mLoadFuture;
+    bool mFlushScheduled;
+
+    ImageHashIndexPrivate()
+    : mLoaded(false)
+    , mLoadGeneration(0)
+    , mFlushScheduled(false)
+    {}
+
+    /**
+     * Must be called with mMutex locked
+     */
+    void startLoading()
+    {
+        mLoaded = false;
+        const int generation = ++mLoadGeneration;
+        mLoadFuture = WorkerPool::run(WorkerLane::BulkIO, [this, generation]() {
+            load(generation);
+        });
+    }
+
+    /**
+     * Reads, and compacts if needed, the log without holding mMutex, so that
+     * findHash() does not block, then merges it with the records inserted
+     * in the meantime
+     */
+    void load(int generation)
+    {
+        IndexData data;
+        {
+            QLockFile lock(lockPath());
+            if (lockLog(&lock)) {
+                const PendingUrls noPendingUrls;
+                // If the log is broken, records appended after the broken
+                // one could not be read
+                if (!data.readLog(noPendingUrls) || data.needsCompaction(0)) {
+                    data.compact(noPendingUrls);
+                }
+            }
+        }
+
+        QMutexLocker locker(&mMutex);
+        if (generation != mLoadGeneration) {
+            return;
+        }
+        for (auto it = mPendingUrls.constBegin(), end = mPendingUrls.constEnd(); it != end; ++it) {
+            auto entryIt = mData.mEntries.constFind(it.key());
+            if (entryIt == mData.mEntries.constEnd()) {
+                data.mEntries.remove(it.key());
+            } else {
+                data.mEntries.insert(it.key(), entryIt.value());
+                data.addToTree(it.key(), entryIt.value().mHash);
+            }
+        }
+        mData = data;
+        mLoaded = true;
+        LOG("Loaded" << mData.mEntries.size() << "hashes");
+        if (mPendingUrls.size() >= FLUSH_THRESHOLD) {
+            flush();
+        }
+    }
+
+    /**
+     * Must be called without mMutex locked
+     */
+    void waitUntilLoaded()
+    {
+        while (true) {
+            QFuture<void> future;
+            {
+                QMutexLocker locker(&mMutex);
+                if (mLoaded) {
+                    return;
+                }
+                future = mLoadFuture;
+            }
+            future.waitForFinished();
+        }
+    }
+
+    /**
+     * Writes pending records in a worker thread once there are enough of
+     * them. Must be called with mMutex locked.
+     */
+    void scheduleFlush()
+    {
+        if (!mLoaded || mFlushScheduled || mPendingUrls.size() < FLUSH_THRESHOLD) {
+            return;
+        }
+        mFlushScheduled = true;
+        WorkerPool::run(WorkerLane::BulkIO, [this]() {
+            QMutexLocker locker(&mMutex);
+            mFlushScheduled = false;
+            // If the index is being reloaded, load() flushes it
+            if (mLoaded) {
+                flush();
+            }
+        });
+    }
+
+    /**
+     * Must be called with mMutex locked, once the index is loaded
+     */
+    void flush()
+    {
+        if (mPendingUrls.isEmpty()) {
+            return;
+        }
+        QLockFile lock(lockPath());
+        if (!lockLog(&lock)) {
+            // Try again with the next batch
+            return;
+        }
+        // Catch up with other processes first, compacting must not drop
+        // their records
+        if (!mData.readLog(mPendingUrls) || mData.needsCompaction(mPendingUrls.size())) {
+            if (mData.compact(mPendingUrls)) {
+                mPendingUrls.clear();
+            }
+            return;
+        }
+
+        QFile file(indexPath());
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qWarning() << "Could not write image hash index" << indexPath();
+            return;
+        }
+        QDataStream stream(&file);
+        if (file.size() == 0) {
+            mData.mLogId = createLogId();
+            stream << INDEX_MAGIC << INDEX_VERSION << mData.mLogId;
+        }
+        for (auto it = mPendingUrls.constBegin(), end = mPendingUrls.constEnd(); it != end; ++it) {
+            auto entryIt = mData.mEntries.find(it.key());
+            if (entryIt == mData.mEntries.end()) {
+                stream << it.key() << REMOVED_MODIFICATION_TIME << quint64(0) << QByteArray();
+            } else {
+                stream << it.key() << entryIt->mModificationTime << entryIt->mHash;
+                entryIt->mUrlOffset = file.pos();
+                stream << it.value().toUtf8();
+            }
+        }
+        mData.mLogOffset = file.pos();
+        mData.mRecordCountOnDisk += mPendingUrls.size();
+        mPendingUrls.clear();
+    }
+
+    /**
+     * Returns the urls of @p keys, reading those which have been written
+     * from the log. Must be called with mMutex locked.
+     */
+    QList<QUrl> urlsForKeys(const QVector<quint64>& keys)
+    {
+        QList<QUrl> list;
+        list.reserve(keys.size());
+        QFile file(indexPath());
+        bool hasLog = mData.mLogId != 0 && openLog(&file, mData.mLogId);
+        if (!hasLog && mData.mLogId != 0) {
+            // Another process compacted the log since we read it
+            QLockFile lock(lockPath());
+            if (lockLog(&lock) && mData.readLog(mPendingUrls)) {
+                hasLog = openLog(&file, mData.mLogId);
+            }
+        }
+        for (quint64 key : keys) {
+            auto pendingIt = mPendingUrls.constFind(key);
+            if (pendingIt != mPendingUrls.constEnd()) {
+                list << QUrl(pendingIt.value());
+                continue;
+            }
+            auto it = mData.mEntries.constFind(key);
+            if (hasLog && it != mData.mEntries.constEnd() && it.value().mUrlOffset >= 0) {
+                list << QUrl(readUrl(&file, it.value().mUrlOffset));
+            }
+        }
+        return list;
+    }
+};
+
+ImageHashIndex* ImageHashIndex::instance()
+{
+    static ImageHashIndex index;
+    return &index;
+}
+
+ImageHashIndex::ImageHashIndex()
+: d(new ImageHashIndexPrivate)
+{
+    QMutexLocker locker(&d->mMutex);
+    d->startLoading();
+}
+
+ImageHashIndex::~ImageHashIndex()
+{
+    flush();
+    delete d;
+}
+
+QString ImageHashIndex::cacheDir()
+{
+    return CacheDirs::path(QStringLiteral("imagehashes"));
+}
+
+void ImageHashIndex::setCacheDir(const QString& dir)
+{
+    CacheDirs::setPath(QStringLiteral("imagehashes"), dir);
+}
+
+void ImageHashIndex::insert(const QUrl& url, time_t modificationTime, quint64 hash)
+{
+    const QString string = urlString(url);
+    const quint64 key = keyForUrl(string);
+    {
+        QMutexLocker locker(&d->mMutex);
+        auto it = d->mData.mEntries.constFind(key);
+        if (it != d->mData.mEntries.constEnd() && it.value().mModificationTime == modificationTime && it.value().mHash == hash) {
+            return;
+        }
+        IndexEntry entry;
+        entry.mModificationTime = modificationTime;
+        entry.mHash = hash;
+        entry.mUrlOffset = -1;
+        d->mData.mEntries.insert(key, entry);
+        d->mData.addToTree(key, hash);
+        d->mPendingUrls.insert(key, string);
+        d->scheduleFlush();
+    }
+    emit hashAdded(url);
+}
+
+bool ImageHashIndex::findHash(const QUrl& url, time_t modificationTime, quint64* hash) const
+{
+    const quint64 key = keyForUrl(urlString(url));
+    QMutexLocker locker(&d->mMutex);
+    auto it = d->mData.mEntries.constFind(key);
+    if (it == d->mData.mEntries.constEnd() || it.value().mModificationTime != modificationTime) {
+        return false;
+    }
+    if (hash) {
+        *hash = it.value().mHash;
+    }
+    return true;
+}
+
+QList<QUrl> ImageHashIndex::similarUrls(quint64 hash, int maxDistance) const
+{
+    d->waitUntilLoaded();
+    QMutexLocker locker(&d->mMutex);
+    const IndexData& data = d->mData;
+    if (data.mNodes.isEmpty()) {
+        return QList<QUrl>();
+    }
+    QVector<quint64> keys;
+    QVector<int> stack;
+    stack << 0;
+    while (!stack.isEmpty()) {
+        const BkNode& node = data.mNodes.at(stack.takeLast());
+        const int dist = ImageHash::distance(node.mHash, hash);
+        if (dist <= maxDistance) {
+            for (quint64 key : node.mKeys) {
+                auto it = data.mEntries.constFind(key);
+                if (it != data.mEntries.constEnd() && it.value().mHash == node.mHash) {
+                    keys << key;
+                }
+            }
+        }
+        for (const auto& pair : node.mChildren) {
+            if (qAbs(pair.first - dist) <= maxDistance) {
+                stack << pair.second;
+            }
+        }
+    }
+    return d->urlsForKeys(keys);
+}
+
+void ImageHashIndex::remove(const QUrl& url)
+{
+    const quint64 key = keyForUrl(urlString(url));
+    QMutexLocker locker(&d->mMutex);
+    // The BK-tree keeps the key, similarUrls() skips keys which are not in
+    // mEntries anymore. Until the index is loaded, we do not know if the
+    // url is in the log, so the removal is always recorded.
+    if (d->mData.mEntries.remove(key) == 0 && d->mLoaded) {
+        return;
+    }
+    d->mPendingUrls.insert(key, QString());
+    d->scheduleFlush();
+}
+
+QList<QUrl> ImageHashIndex::urls() const
+{
+    d->waitUntilLoaded();
+    QMutexLocker locker(&d->mMutex);
+    return d->urlsForKeys(d->mData.mEntries.keys().toVector());
+}
+
+int ImageHashIndex::count() const
+{
+    d->waitUntilLoaded();
+    QMutexLocker locker(&d->mMutex);
+    return d->mData.mEntries.size();
+}
+
+void ImageHashIndex::flush()
+{
+    {
+        QMutexLocker locker(&d->mMutex);
+        if (d->mPendingUrls.isEmpty()) {
+            return;
+        }
+    }
+    d->waitUntilLoaded();
+    QMutexLocker locker(&d->mMutex);
+    d->flush();
+}
+
+void ImageHashIndex::reload()
+{
+    QMutexLocker locker(&d->mMutex);
+    d->mData.clear();
+    d->mPendingUrls.clear();
+    d->startLoading();
+}
+
+} // namespace
@@ -0,0 +1,131 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef IMAGEHASHINDEX_H
+#define IMAGEHASHINDEX_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QList>
+#include <QObject>
+#include <QUrl>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+struct ImageHashIndexPrivate;
+
+/**
+ * A persistent index of the perceptual hashes of images (see ImageHash).
+ *
+ * Hashes are computed by the thumbnail pipeline from the thumbnails it
+ * generates or finds in the cache, so that images are never decoded just to
+ * be hashed. Entries are keyed by a hash of their url and are stale as soon
+ * as the modification time of the file changes. Urls are not kept in memory,
+ * they are read from disk when similarUrls() or urls() return them.
+ *
+ * The index is stored as an append-only log in cacheDir(), compacted when
+ * it contains too many stale records. Removed urls are recorded with a
+ * negative modification time. Similar images are looked up with a
+ * BK-tree, so a query only compares the hash with a small part of the index.
+ *
+ * The log is loaded, and compacted if needed, in a worker thread. Until it
+ * is loaded, findHash() only knows the hashes inserted since then, while
+ * similarUrls(), urls(), count() and flush() wait for it.
+ *
+ * All methods are thread-safe.
+ */
+class GWENVIEWLIB_EXPORT ImageHashIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static ImageHashIndex* instance();
+    ~ImageHashIndex() override;
+
+    /**
+     * Returns the directory where the index is stored
+     */
+    static QString cacheDir();
+
+    /**
+     * Sets the cache dir, useful for unit-testing. Call reload() afterwards.
+     */
+    static void setCacheDir(const QString&);
+
+    void insert(const QUrl& url, time_t modificationTime, quint64 hash);
+
+    /**
+     * Returns true if the index contains an up to date hash for @p url. If
+     * @p hash is not null, it is set to the hash. Does not wait for the
+     * index to be loaded.
+     */
+    bool findHash(const QUrl& url, time_t modificationTime, quint64* hash = nullptr) const;
+
+    /**
+     * Returns the urls of the images whose hash differs from @p hash by at
+     * most @p maxDistance bits
+     */
+    QList<QUrl> similarUrls(quint64 hash, int maxDistance) const;
+
+    /**
+     * Forgets the hash of @p url, for example because the file has been
+     * deleted
+     */
+    void remove(const QUrl& url);
+
+    /**
+     * Returns the urls of all the images of the index
+     */
+    QList<QUrl> urls() const;
+
+    int count() const;
+
+    /**
+     * Writes pending records to disk. Records are written in batches, and
+     * when the index is destroyed.
+     */
+    void flush();
+
+    /**
+     * Forgets the content of the index, including records which have not
+     * been written yet, and starts reading it again from disk
+     */
+    void reload();
+
+Q_SIGNALS:
+    /**
+     * Emitted when the hash of @p url has been added or updated. May be
+     * emitted from any thread.
+     */
+    void hashAdded(const QUrl& url);
+
+private:
+    ImageHashIndex();
+    ImageHashIndexPrivate* const d;
+};
+
+} // namespace
+
+#endif /* IMAGEHASHINDEX_H */
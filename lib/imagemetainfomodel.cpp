@@ -32,6 +32,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 #include <KLocalizedString>
 #include <KFormat>
 
+// STL
+#include <memory>
+
 // Exiv2
 #include <exiv2/exif.hpp>
 #include <exiv2/image.hpp>
@@ -203,6 +206,18 @@ struct ImageMetaInfoModelPrivate
     QVector<MetaInfoGroup*> mMetaInfoGroupVector;
     ImageMetaInfoModel* q;
 
+    // Formatting every Exiv2 value is expensive and most models are never
+    // shown, so setExiv2Image() only keeps a copy of the data. Rows of a
+    // group are created when a view expands it.
+    Exiv2::ExifData mExifData;
+    Exiv2::IptcData mIptcData;
+    Exiv2::XmpData mXmpData;
+    // Groups with data which has not been turned into rows yet
+    QVector<bool> mPendingGroups;
+    // Groups a view asked to fetch: they are filled as soon as new data is
+    // set
+    QVector<bool> mShownGroups;
+
     void clearGroup(MetaInfoGroup* group, const QModelIndex& parent)
     {
         if (group->size() > 0) {
@@ -258,6 +273,30 @@ struct ImageMetaInfoModelPrivate
         group->addEntry(QStringLiteral("General.Comment"), i18nc("@item:intable", "Comment"), QString());
     }
 
+    /**
+     * Reads the key, label and formatted value of @p datum. Returns false if
+     * it should not be shown.
+     */
+    template <class Datum>
+    static bool readExivDatum(const Datum& datum, QString* key, QString* label, QString* value)
+    {
+        try {
+            // Skip metadatum if its tag is an hex number
+            if (datum.tagName().substr(0, 2) == "0x") {
+                return false;
+            }
+            *key = QString::fromUtf8(datum.key().c_str());
+            *label = QString::fromLocal8Bit(datum.tagLabel().c_str());
+            std::ostringstream stream;
+            stream << datum;
+            *value = QString::fromLocal8Bit(stream.str().c_str());
+            return true;
+        } catch (const Exiv2::Error& error) {
+            qWarning() << "Failed to read some meta info:" << error.what();
+            return false;
+        }
+    }
+
     template <class Container, class Iterator>
     void fillExivGroup(const QModelIndex& parent, MetaInfoGroup* group, const Container& container)
     {
@@ -273,25 +312,15 @@ struct ImageMetaInfoModelPrivate
         end = container.end();
 
         for (; it != end; ++it) {
-            try {
-                // Skip metadatum if its tag is an hex number
-                if (it->tagName().substr(0, 2) == "0x") {
-                    continue;
-                }
-                QString key = QString::fromUtf8(it->key().c_str());
-                QString label = QString::fromLocal8Bit(it->tagLabel().c_str());
-                std::ostringstream stream;
-                stream << *it;
-                QString value = QString::fromLocal8Bit(stream.str().c_str());
-
-                EntryHash::iterator hashIt = hash.find(key);
-                if (hashIt != hash.end()) {
-                    hashIt.value()->appendValue(value);
-                } else {
-                    hash.insert(key, new MetaInfoGroup::Entry(key, label, value));
-                }
-            } catch (const Exiv2::Error& error) {
-                qWarning() << "Failed to read some meta info:" << error.what();
+            QString key, label, value;
+            if (!readExivDatum(*it, &key, &label, &value)) {
+                continue;
+            }
+            EntryHash::iterator hashIt = hash.find(key);
+            if (hashIt != hash.end()) {
+                hashIt.value()->appendValue(value);
+            } else {
+                hash.insert(key, new MetaInfoGroup::Entry(key, label, value));
             }
         }
 
@@ -304,6 +333,86 @@ struct ImageMetaInfoModelPrivate
         }
         q->endInsertRows();
     }
+
+    /**
+     * Looks for @p key in @p container without creating any row. Values of
+     * repeated keys are joined, like in fillExivGroup().
+     */
+    template <class Container, class Iterator>
+    static void getExivInfoForKey(const Container& container, const QString& key, QString* label, QString* value)
+    {
+        const std::string exivKey = key.toStdString();
+        Iterator
+        it = container.begin(),
+        end = container.end();
+
+        std::unique_ptr<MetaInfoGroup::Entry> entry;
+        for (; it != end; ++it) {
+            if (it->key() != exivKey) {
+                continue;
+            }
+            QString datumKey, datumLabel, datumValue;
+            if (!readExivDatum(*it, &datumKey, &datumLabel, &datumValue)) {
+                continue;
+            }
+            if (entry) {
+                entry->appendValue(datumValue);
+            } else {
+                entry.reset(new MetaInfoGroup::Entry(datumKey, datumLabel, datumValue));
+            }
+        }
+        if (entry) {
+            *label = entry->label();
+            *value = entry->value();
+        }
+    }
+
+    void getPendingInfoForKey(GroupRow groupRow, const QString& key, QString* label, QString* value) const
+    {
+        switch (groupRow) {
+        case ExifGroup:
+            getExivInfoForKey<Exiv2::ExifData, Exiv2::ExifData::const_iterator>(mExifData, key, label, value);
+            break;
+        case IptcGroup:
+            getExivInfoForKey<Exiv2::IptcData, Exiv2::IptcData::const_iterator>(mIptcData, key, label, value);
+            break;
+        case XmpGroup:
+            getExivInfoForKey<Exiv2::XmpData, Exiv2::XmpData::const_iterator>(mXmpData, key, label, value);
+            break;
+        default:
+            break;
+        }
+    }
+
+    /**
+     * Creates the rows of an Exiv2 group from the data kept by
+     * setExiv2Image(), then drops the data
+     */
+    void fetchGroup(GroupRow groupRow)
+    {
+        if (!mPendingGroups[groupRow]) {
+            return;
+        }
+        mPendingGroups[groupRow] = false;
+        const QModelIndex parent = q->index(groupRow, 0);
+        MetaInfoGroup* group = mMetaInfoGroupVector[groupRow];
+        switch (groupRow) {
+        case ExifGroup:
+            fillExivGroup<Exiv2::ExifData, Exiv2::ExifData::const_iterator>(parent, group, mExifData);
+            mExifData.clear();
+            break;
+        case IptcGroup:
+            fillExivGroup<Exiv2::IptcData, Exiv2::IptcData::const_iterator>(parent, group, mIptcData);
+            mIptcData.clear();
+            break;
+        case XmpGroup:
+            fillExivGroup<Exiv2::XmpData, Exiv2::XmpData::const_iterator>(parent, group, mXmpData);
+            mXmpData.clear();
+            break;
+        default:
+            break;
+        }
+    }
 };
 
 ImageMetaInfoModel::ImageMetaInfoModel()
@@ -322,6 +431,8 @@ ImageMetaInfoModel::ImageMetaInfoModel()
 #endif
     d->mMetaInfoGroupVector[IptcGroup] = new MetaInfoGroup(QStringLiteral("IPTC"));
     d->mMetaInfoGroupVector[XmpGroup]  = new MetaInfoGroup(QStringLiteral("XMP"));
+    d->mPendingGroups.fill(false, d->mMetaInfoGroupVector.size());
+    d->mShownGroups.fill(false, d->mMetaInfoGroupVector.size());
     d->initGeneralGroup();
 }
 
@@ -432,6 +543,12 @@ void ImageMetaInfoModel::setExiv2Image(const Exiv2::Image* image)
     d->clearGroup(exifGroup, exifIndex);
     d->clearGroup(iptcGroup, iptcIndex);
     d->clearGroup(xmpGroup,  xmpIndex);
+    d->mExifData.clear();
+    d->mIptcData.clear();
+    d->mXmpData.clear();
+    d->mPendingGroups[ExifGroup] = false;
+    d->mPendingGroups[IptcGroup] = false;
+    d->mPendingGroups[XmpGroup] = false;
 
     if (!image) {
         return;
@@ -440,41 +557,51 @@ void ImageMetaInfoModel::setExiv2Image(const Exiv2::Image* image)
     d->setGroupEntryValue(GeneralGroup, QStringLiteral("General.Comment"), QString::fromUtf8(image->comment().c_str()));
 
     if (image->checkMode(Exiv2::mdExif) & Exiv2::amRead) {
-        const Exiv2::ExifData& exifData = image->exifData();
-        d->fillExivGroup<Exiv2::ExifData, Exiv2::ExifData::const_iterator>(exifIndex, exifGroup, exifData);
+        d->mExifData = image->exifData();
+        d->mPendingGroups[ExifGroup] = !d->mExifData.empty();
     }
 
     if (image->checkMode(Exiv2::mdIptc) & Exiv2::amRead) {
-        const Exiv2::IptcData& iptcData = image->iptcData();
-        d->fillExivGroup<Exiv2::IptcData, Exiv2::IptcData::const_iterator>(iptcIndex, iptcGroup, iptcData);
+        d->mIptcData = image->iptcData();
+        d->mPendingGroups[IptcGroup] = !d->mIptcData.empty();
     }
 
     if (image->checkMode(Exiv2::mdXmp) & Exiv2::amRead) {
-        const Exiv2::XmpData& xmpData = image->xmpData();
-        d->fillExivGroup<Exiv2::XmpData, Exiv2::XmpData::const_iterator>(xmpIndex, xmpGroup, xmpData);
+        d->mXmpData = image->xmpData();
+        d->mPendingGroups[XmpGroup] = !d->mXmpData.empty();
+    }
+
+    for (GroupRow groupRow : {ExifGroup, IptcGroup, XmpGroup}) {
+        if (d->mShownGroups[groupRow]) {
+            d->fetchGroup(groupRow);
+        }
     }
 }
 
 void ImageMetaInfoModel::getInfoForKey(const QString& key, QString* label, QString* value) const
 {
-    MetaInfoGroup* group;
+    GroupRow groupRow;
     if (key.startsWith(QLatin1String("General"))) {
-        group = d->mMetaInfoGroupVector[GeneralGroup];
+        groupRow = GeneralGroup;
     } else if (key.startsWith(QLatin1String("Exif"))) {
-        group = d->mMetaInfoGroupVector[ExifGroup];
+        groupRow = ExifGroup;
 #ifdef HAVE_FITS
     } else if (key.startsWith(QLatin1String("Fits"))) {
-        group = d->mMetaInfoGroupVector[FitsGroup];
+        groupRow = FitsGroup;
 #endif
     } else if (key.startsWith(QLatin1String("Iptc"))) {
-        group = d->mMetaInfoGroupVector[IptcGroup];
+        groupRow = IptcGroup;
     } else if (key.startsWith(QLatin1String("Xmp"))) {
-        group = d->mMetaInfoGroupVector[XmpGroup];
+        groupRow = XmpGroup;
     } else {
         qWarning() << "Unknown metainfo key" << key;
         return;
     }
-    group->getInfoForKey(key, label, value);
+    if (d->mPendingGroups[groupRow]) {
+        d->getPendingInfoForKey(groupRow, key, label, value);
+    } else {
+        d->mMetaInfoGroupVector[groupRow]->getInfoForKey(key, label, value);
+    }
 }
 
 QString ImageMetaInfoModel::getValueForKey(const QString& key) const
@@ -526,6 +653,28 @@ QModelIndex ImageMetaInfoModel::parent(const QModelIndex& index) const
     }
 }
 
+bool ImageMetaInfoModel::hasChildren(const QModelIndex& parent) const
+{
+    if (parent.isValid() && parent.internalId() == NoGroup && d->mPendingGroups[parent.row()]) {
+        return true;
+    }
+    return QAbstractItemModel::hasChildren(parent);
+}
+
+bool ImageMetaInfoModel::canFetchMore(const QModelIndex& parent) const
+{
+    return parent.isValid() && parent.internalId() == NoGroup && d->mPendingGroups[parent.row()];
+}
+
+void ImageMetaInfoModel::fetchMore(const QModelIndex& parent)
+{
+    if (!parent.isValid() || parent.internalId() != NoGroup) {
+        return;
+    }
+    d->mShownGroups[parent.row()] = true;
+    d->fetchGroup(GroupRow(parent.row()));
+}
+
 int ImageMetaInfoModel::rowCount(const QModelIndex& parent) const
 {
     if (!parent.isValid()) {
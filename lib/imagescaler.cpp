@@ -20,8 +20,11 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "imagescaler.h"
 
 // Qt
+#include <QAtomicInt>
+#include <QFutureWatcher>
 #include <QImage>
 #include <QRegion>
+#include <QSharedPointer>
 #include <QDebug>
 
 // KDE
@@ -29,6 +32,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 // Local
 #include <lib/document/document.h>
 #include <lib/paintutils.h>
+#include <lib/resampler.h>
+#include <lib/tracing.h>
+#include <lib/workerpool.h>
 
 #undef ENABLE_LOG
 #undef LOG
@@ -45,12 +51,214 @@ namespace Gwenview
 // Amount of pixels to keep so that smooth scale is correct
 static const int SMOOTH_MARGIN = 3;
 
+// Size of the parts in which the region is scaled when the full image is not
+// loaded, so that they appear as soon as their pixels are decoded
+static const int IMAGE_REGION_CHUNK_SIZE = 256;
+
+// Rects smaller than this are scaled smoothly right away: it is fast enough,
+// and showing a fast pass first would make them flicker
+static const int MAX_SYNC_SMOOTH_PIXELS = 256 * 256;
+
+// Strips up to this thickness are scaled smoothly right away whatever their
+// length: scrolling exposes strips as long as the viewport, and on large
+// screens those would otherwise flicker through a fast pass while panning
+static const int MAX_SYNC_SMOOTH_STRIP_THICKNESS = 256;
+
+// Size of the tiles in which larger rects are scaled smoothly in the
+// background, each of them replacing the fast pass as soon as it is ready
+static const int SMOOTH_TILE_SIZE = 256;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+/**
+ * Smooth scaling of 16 bit grayscale images, which Resampler would scale
+ * with QImage::scaled(), converting them to 64 bits per pixel. Pixels are
+ * averaged when down scaling and interpolated when up scaling.
+ */
+template <typename T>
+static void smoothScaleSingleChannel(const QImage& src, QImage* dst)
+{
+    const int srcWidth = src.width();
+    const int srcHeight = src.height();
+    const int dstWidth = dst->width();
+    const int dstHeight = dst->height();
+    const qreal xRatio = qreal(srcWidth) / dstWidth;
+    const qreal yRatio = qreal(srcHeight) / dstHeight;
+
+    if (xRatio >= 1 && yRatio >= 1) {
+        for (int y = 0; y < dstHeight; ++y) {
+            const int sy0 = int(y * yRatio);
+            const int sy1 = qBound(sy0 + 1, int((y + 1) * yRatio), srcHeight);
+            T* dstLine = reinterpret_cast<T*>(dst->scanLine(y));
+            for (int x = 0; x < dstWidth; ++x) {
+                const int sx0 = int(x * xRatio);
+                const int sx1 = qBound(sx0 + 1, int((x + 1) * xRatio), srcWidth);
+                quint64 sum = 0;
+                for (int sy = sy0; sy < sy1; ++sy) {
+                    const T* srcLine = reinterpret_cast<const T*>(src.constScanLine(sy));
+                    for (int sx = sx0; sx < sx1; ++sx) {
+                        sum += srcLine[sx];
+                    }
+                }
+                dstLine[x] = T(sum / quint64((sy1 - sy0) * (sx1 - sx0)));
+            }
+        }
+        return;
+    }
+
+    for (int y = 0; y < dstHeight; ++y) {
+        const qreal fy = qBound(qreal(0), (y + 0.5) * yRatio - 0.5, qreal(srcHeight - 1));
+        const int sy0 = int(fy);
+        const int sy1 = qMin(sy0 + 1, srcHeight - 1);
+        const qreal wy = fy - sy0;
+        const T* srcLine0 = reinterpret_cast<const T*>(src.constScanLine(sy0));
+        const T* srcLine1 = reinterpret_cast<const T*>(src.constScanLine(sy1));
+        T* dstLine = reinterpret_cast<T*>(dst->scanLine(y));
+        for (int x = 0; x < dstWidth; ++x) {
+            const qreal fx = qBound(qreal(0), (x + 0.5) * xRatio - 0.5, qreal(srcWidth - 1));
+            const int sx0 = int(fx);
+            const int sx1 = qMin(sx0 + 1, srcWidth - 1);
+            const qreal wx = fx - sx0;
+            const qreal top = srcLine0[sx0] + (srcLine0[sx1] - srcLine0[sx0]) * wx;
+            const qreal bottom = srcLine1[sx0] + (srcLine1[sx1] - srcLine1[sx0]) * wx;
+            dstLine[x] = T(qRound(top + (bottom - top) * wy));
+        }
+    }
+}
+#endif
+
+/**
+ * Scales @p image, keeping grayscale images in their original format
+ */
+static QImage scaledImage(const QImage& image, const QSize& size, Qt::TransformationMode mode)
+{
+    if (mode == Qt::FastTransformation || size.isEmpty()) {
+        // Fast scaling keeps the format of the image
+        return image.scaled(size, Qt::IgnoreAspectRatio, mode);
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    if (image.format() == QImage::Format_Grayscale16) {
+        QImage dst(size, image.format());
+        smoothScaleSingleChannel<quint16>(image, &dst);
+        return dst;
+    }
+#endif
+    // The bilinear filter reads 1 / zoom source pixels around each
+    // destination pixel: SMOOTH_MARGIN is enough because down sampled images
+    // keep the zoom above 1/2. Large rects are scaled in parallel.
+    return Resampler::scaled(image, size, Resampler::Bilinear);
+}
+
+/**
+ * Source pixels of a destination rect, with everything needed to scale them
+ * outside of the GUI thread
+ */
+struct ScaleJob
+{
+    QImage mSource;
+    QSize mScaledSize;
+    // Part of the scaled image to keep, without the smooth margins
+    QRect mCropRect;
+    // Position of mCropRect in the zoomed image
+    QPoint mDestPos;
+};
+
+static QImage runScaleJob(const ScaleJob& job, Qt::TransformationMode mode)
+{
+    // Do not keep the aspect ratio, it can lead to skipped rows or columns
+    QImage image = scaledImage(job.mSource, job.mScaledSize, mode);
+    if (job.mCropRect != image.rect()) {
+        image = image.copy(job.mCropRect);
+    }
+    return image;
+}
+
 struct ImageScalerPrivate
 {
     Qt::TransformationMode mTransformationMode;
     Document::Ptr mDocument;
     qreal mZoom;
     QRegion mRegion;
+    // Parts of the region waiting for image regions of the document
+    QRegion mPendingRegion;
+    // Incremented when smooth tiles being scaled in the background become
+    // obsolete. Shared with the tasks, which may outlive the scaler.
+    QSharedPointer<QAtomicInt> mGeneration;
+
+    bool prepareScaleJob(const QRect& rect, bool smoothMargins, ScaleJob* job) const
+    {
+        // If image is null, pixels come from Document::imageRegion(), which is
+        // either the full image or parts of it decoded on their own
+        QImage image;
+        QRect imageRect;
+        qreal zoom;
+        if (mZoom < Document::maxDownSampledZoom()) {
+            image = mDocument->downSampledImageForZoom(mZoom);
+            Q_ASSERT(!image.isNull());
+            imageRect = image.rect();
+            qreal zoom1 = qreal(image.width()) / mDocument->width();
+            zoom = mZoom / zoom1;
+        } else {
+            imageRect = QRect(QPoint(0, 0), mDocument->size());
+            zoom = mZoom;
+        }
+        // If rect contains "half" pixels, make sure sourceRect includes them
+        QRectF sourceRectF(
+            rect.left() / zoom,
+            rect.top() / zoom,
+            rect.width() / zoom,
+            rect.height() / zoom);
+
+        sourceRectF = sourceRectF.intersected(imageRect);
+        QRect sourceRect = PaintUtils::containingRect(sourceRectF);
+        if (sourceRect.isEmpty()) {
+            return false;
+        }
+
+        // Compute smooth margin
+        int sourceLeftMargin, sourceRightMargin, sourceTopMargin, sourceBottomMargin;
+        int destLeftMargin, destRightMargin, destTopMargin, destBottomMargin;
+        if (smoothMargins) {
+            sourceLeftMargin = qMin(sourceRect.left(), SMOOTH_MARGIN);
+            sourceTopMargin = qMin(sourceRect.top(), SMOOTH_MARGIN);
+            sourceRightMargin = qMin(imageRect.right() - sourceRect.right(), SMOOTH_MARGIN);
+            sourceBottomMargin = qMin(imageRect.bottom() - sourceRect.bottom(), SMOOTH_MARGIN);
+            sourceRect.adjust(
+                -sourceLeftMargin,
+                -sourceTopMargin,
+                sourceRightMargin,
+                sourceBottomMargin);
+            destLeftMargin = int(sourceLeftMargin * zoom);
+            destTopMargin = int(sourceTopMargin * zoom);
+            destRightMargin = int(sourceRightMargin * zoom);
+            destBottomMargin = int(sourceBottomMargin * zoom);
+        } else {
+            sourceLeftMargin = sourceRightMargin = sourceTopMargin = sourceBottomMargin = 0;
+            destLeftMargin = destRightMargin = destTopMargin = destBottomMargin = 0;
+        }
+
+        // destRect is almost like rect, but it contains only "full" pixels
+        QRectF destRectF = QRectF(
+                               sourceRect.left() * zoom,
+                               sourceRect.top() * zoom,
+                               sourceRect.width() * zoom,
+                               sourceRect.height() * zoom
+                           );
+        QRect destRect = PaintUtils::containingRect(destRectF);
+
+        job->mSource = image.isNull() ? mDocument->imageRegion(sourceRect) : image.copy(sourceRect);
+        if (job->mSource.isNull()) {
+            return false;
+        }
+        job->mScaledSize = destRect.size();
+        job->mCropRect = QRect(
+                             destLeftMargin, destTopMargin,
+                             destRect.width() - (destLeftMargin + destRightMargin),
+                             destRect.height() - (destTopMargin + destBottomMargin)
+                         );
+        job->mDestPos = QPoint(destRect.left() + destLeftMargin, destRect.top() + destTopMargin);
+        return true;
+    }
 };
 
 ImageScaler::ImageScaler(QObject* parent)
@@ -59,10 +267,13 @@ ImageScaler::ImageScaler(QObject* parent)
 {
     d->mTransformationMode = Qt::FastTransformation;
     d->mZoom = 0;
+    d->mGeneration.reset(new QAtomicInt(0));
 }
 
 ImageScaler::~ImageScaler()
 {
+    // Pending tasks do not need to scale their tile anymore
+    cancelSmoothScale();
     delete d;
 }
 
@@ -72,12 +283,20 @@ void ImageScaler::setDocument(Document::Ptr document)
         disconnect(d->mDocument.data(), nullptr, this, nullptr);
     }
     d->mDocument = document;
+    d->mPendingRegion = QRegion();
+    cancelSmoothScale();
     // Used when scaler asked for a down-sampled image
     connect(d->mDocument.data(), SIGNAL(downSampledImageReady()),
             SLOT(doScale()));
     // Used when scaler asked for a full image
     connect(d->mDocument.data(), SIGNAL(loaded(QUrl)),
             SLOT(doScale()));
+    // Used when scaler asked for image regions
+    connect(d->mDocument.data(), SIGNAL(imageRegionReady(QRect)),
+            SLOT(doScale()));
+    // Smooth tiles being scaled contain the pixels from before the change
+    connect(d->mDocument.data(), SIGNAL(imageRectUpdated(QRect)),
+            SLOT(cancelSmoothScale()));
 }
 
 void ImageScaler::setZoom(qreal zoom)
@@ -88,6 +307,8 @@ void ImageScaler::setZoom(qreal zoom)
                                        : Qt::FastTransformation;
 
     d->mZoom = zoom;
+    d->mPendingRegion = QRegion();
+    cancelSmoothScale();
 }
 
 void ImageScaler::setDestinationRegion(const QRegion& region)
@@ -111,102 +332,137 @@ void ImageScaler::doScale()
             return;
         }
     } else if (d->mDocument->image().isNull()) {
+        if (d->mDocument->canLoadImageRegions()) {
+            scaleImageRegions();
+            return;
+        }
         LOG("Asked for the full image");
         d->mDocument->startLoadingFullImage();
         return;
     }
 
     LOG("Starting");
-    Q_FOREACH(const QRect & rect, d->mRegion.rects()) {
+    // Also scale what scaleImageRegions() could not scale before the full
+    // image got loaded
+    const QRegion region = d->mRegion | d->mPendingRegion;
+    d->mPendingRegion = QRegion();
+    Q_FOREACH(const QRect & rect, region.rects()) {
         LOG(rect);
         scaleRect(rect);
     }
     LOG("Done");
 }
 
+void ImageScaler::scaleImageRegions()
+{
+    // Regions are consumed: what has been scaled does not need to be scaled
+    // again when more parts of the image are decoded
+    d->mPendingRegion |= d->mRegion;
+    d->mRegion = QRegion();
+    if (d->mPendingRegion.isEmpty()) {
+        return;
+    }
+
+    // Prepare the whole region first, so that the document keeps all of its
+    // tiles until every chunk has been scaled
+    const QRect pendingRect = d->mPendingRegion.boundingRect();
+    d->mDocument->prepareImageRegion(PaintUtils::containingRect(QRectF(
+        pendingRect.left() / d->mZoom,
+        pendingRect.top() / d->mZoom,
+        pendingRect.width() / d->mZoom,
+        pendingRect.height() / d->mZoom)
+    ).adjusted(-SMOOTH_MARGIN, -SMOOTH_MARGIN, SMOOTH_MARGIN, SMOOTH_MARGIN));
+
+    Q_FOREACH(const QRect & rect, d->mPendingRegion.rects()) {
+        for (int y = rect.top(); y <= rect.bottom(); y += IMAGE_REGION_CHUNK_SIZE) {
+            for (int x = rect.left(); x <= rect.right(); x += IMAGE_REGION_CHUNK_SIZE) {
+                const QRect chunk = QRect(x, y, IMAGE_REGION_CHUNK_SIZE, IMAGE_REGION_CHUNK_SIZE).intersected(rect);
+                const QRect sourceRect = PaintUtils::containingRect(QRectF(
+                    chunk.left() / d->mZoom,
+                    chunk.top() / d->mZoom,
+                    chunk.width() / d->mZoom,
+                    chunk.height() / d->mZoom)
+                ).adjusted(-SMOOTH_MARGIN, -SMOOTH_MARGIN, SMOOTH_MARGIN, SMOOTH_MARGIN);
+                if (d->mDocument->prepareImageRegion(sourceRect)) {
+                    LOG(chunk);
+                    scaleRect(chunk);
+                    d->mPendingRegion -= chunk;
+                }
+            }
+        }
+    }
+}
+
 void ImageScaler::scaleRect(const QRect& rect)
 {
+    TraceSpan span("imageScalerPass", d->mDocument->url());
     const qreal REAL_DELTA = 0.001;
     if (qAbs(d->mZoom - 1.0) < REAL_DELTA) {
-        QImage tmp = d->mDocument->image().copy(rect);
+        QImage tmp = d->mDocument->imageRegion(rect);
         scaledRect(rect.left(), rect.top(), tmp);
         return;
     }
 
-    QImage image;
-    qreal zoom;
-    if (d->mZoom < Document::maxDownSampledZoom()) {
-        image = d->mDocument->downSampledImageForZoom(d->mZoom);
-        Q_ASSERT(!image.isNull());
-        qreal zoom1 = qreal(image.width()) / d->mDocument->width();
-        zoom = d->mZoom / zoom1;
-    } else {
-        image = d->mDocument->image();
-        zoom = d->mZoom;
-    }
-    // If rect contains "half" pixels, make sure sourceRect includes them
-    QRectF sourceRectF(
-        rect.left() / zoom,
-        rect.top() / zoom,
-        rect.width() / zoom,
-        rect.height() / zoom);
-
-    sourceRectF = sourceRectF.intersected(image.rect());
-    QRect sourceRect = PaintUtils::containingRect(sourceRectF);
-    if (sourceRect.isEmpty()) {
+    ScaleJob job;
+    if (d->mTransformationMode == Qt::SmoothTransformation
+            && rect.width() * rect.height() > MAX_SYNC_SMOOTH_PIXELS
+            && qMin(rect.width(), rect.height()) > MAX_SYNC_SMOOTH_STRIP_THICKNESS) {
+        // Show a fast pass right away, so that zooming never waits for
+        // smooth scaling, then replace it tile by tile
+        if (d->prepareScaleJob(rect, false, &job)) {
+            const QImage image = runScaleJob(job, Qt::FastTransformation);
+            emit scaledRect(job.mDestPos.x(), job.mDestPos.y(), image);
+        }
+        for (int y = rect.top(); y <= rect.bottom(); y += SMOOTH_TILE_SIZE) {
+            for (int x = rect.left(); x <= rect.right(); x += SMOOTH_TILE_SIZE) {
+                startSmoothScale(QRect(x, y, SMOOTH_TILE_SIZE, SMOOTH_TILE_SIZE).intersected(rect));
+            }
+        }
         return;
     }
 
-    // Compute smooth margin
-    bool needsSmoothMargins = d->mTransformationMode == Qt::SmoothTransformation;
-
-    int sourceLeftMargin, sourceRightMargin, sourceTopMargin, sourceBottomMargin;
-    int destLeftMargin, destRightMargin, destTopMargin, destBottomMargin;
-    if (needsSmoothMargins) {
-        sourceLeftMargin = qMin(sourceRect.left(), SMOOTH_MARGIN);
-        sourceTopMargin = qMin(sourceRect.top(), SMOOTH_MARGIN);
-        sourceRightMargin = qMin(image.rect().right() - sourceRect.right(), SMOOTH_MARGIN);
-        sourceBottomMargin = qMin(image.rect().bottom() - sourceRect.bottom(), SMOOTH_MARGIN);
-        sourceRect.adjust(
-            -sourceLeftMargin,
-            -sourceTopMargin,
-            sourceRightMargin,
-            sourceBottomMargin);
-        destLeftMargin = int(sourceLeftMargin * zoom);
-        destTopMargin = int(sourceTopMargin * zoom);
-        destRightMargin = int(sourceRightMargin * zoom);
-        destBottomMargin = int(sourceBottomMargin * zoom);
-    } else {
-        sourceLeftMargin = sourceRightMargin = sourceTopMargin = sourceBottomMargin = 0;
-        destLeftMargin = destRightMargin = destTopMargin = destBottomMargin = 0;
-    }
-
-    // destRect is almost like rect, but it contains only "full" pixels
-    QRectF destRectF = QRectF(
-                           sourceRect.left() * zoom,
-                           sourceRect.top() * zoom,
-                           sourceRect.width() * zoom,
-                           sourceRect.height() * zoom
-                       );
-    QRect destRect = PaintUtils::containingRect(destRectF);
-
-    QImage tmp;
-    tmp = image.copy(sourceRect);
-    tmp = tmp.scaled(
-              destRect.width(),
-              destRect.height(),
-              Qt::IgnoreAspectRatio, // Do not use KeepAspectRatio, it can lead to skipped rows or columns
-              d->mTransformationMode);
-
-    if (needsSmoothMargins) {
-        tmp = tmp.copy(
-                  destLeftMargin, destTopMargin,
-                  destRect.width() - (destLeftMargin + destRightMargin),
-                  destRect.height() - (destTopMargin + destBottomMargin)
-              );
-    }
-
-    emit scaledRect(destRect.left() + destLeftMargin, destRect.top() + destTopMargin, tmp);
+    if (!d->prepareScaleJob(rect, d->mTransformationMode == Qt::SmoothTransformation, &job)) {
+        return;
+    }
+    const QImage image = runScaleJob(job, d->mTransformationMode);
+    emit scaledRect(job.mDestPos.x(), job.mDestPos.y(), image);
+}
+
+void ImageScaler::startSmoothScale(const QRect& rect)
+{
+    ScaleJob job;
+    if (!d->prepareScaleJob(rect, true, &job)) {
+        return;
+    }
+    const QSharedPointer<QAtomicInt> generation = d->mGeneration;
+    const int jobGeneration = generation->load();
+    const QPoint destPos = job.mDestPos;
+    const QUrl url = d->mDocument->url();
+
+    QFutureWatcher<QImage>* watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation, jobGeneration, destPos]() {
+        watcher->deleteLater();
+        if (generation->load() != jobGeneration) {
+            LOG("Dropping obsolete tile at" << destPos);
+            return;
+        }
+        const QImage image = watcher->result();
+        if (!image.isNull()) {
+            emit scaledRect(destPos.x(), destPos.y(), image);
+        }
+    });
+    watcher->setFuture(WorkerPool::run(WorkerLane::Interactive, [job, generation, jobGeneration, url]() {
+        if (generation->load() != jobGeneration) {
+            return QImage();
+        }
+        TraceSpan span("imageScalerSmoothTile", url);
+        return runScaleJob(job, Qt::SmoothTransformation);
+    }));
+}
+
+void ImageScaler::cancelSmoothScale()
+{
+    d->mGeneration->ref();
 }
 
 } // namespace
@@ -39,6 +39,14 @@ namespace Gwenview
 class Document;
 
 struct ImageScalerPrivate;
+/**
+ * Scales regions of the image of a document for a zoom level.
+ *
+ * When scaling smoothly, large rects are first scaled quickly and emitted
+ * right away, then scaled smoothly in tiles by worker threads. Tiles are
+ * emitted as they are ready, unless the zoom, the document or its image
+ * changed in the meantime.
+ */
 class GWENVIEWLIB_EXPORT ImageScaler : public QObject
 {
     Q_OBJECT
@@ -55,9 +63,12 @@ Q_SIGNALS:
 private:
     ImageScalerPrivate * const d;
     void scaleRect(const QRect&);
+    void scaleImageRegions();
+    void startSmoothScale(const QRect&);
 
 private Q_SLOTS:
     void doScale();
+    void cancelSmoothScale();
 };
 
 } // namespace
@@ -20,14 +20,125 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 */
 #include "imageutils.h"
 
+#include <algorithm>
+#include <string.h>
+
 // Qt
+#include <QImage>
 #include <QMatrix>
 
+// Local
+#include "tracing.h"
+#include "workerpool.h"
+
 namespace Gwenview
 {
 namespace ImageUtils
 {
 
+/**
+ * Rotations read the source one column at a time: working on square tiles
+ * of this size keeps the source rows of a tile in cache
+ */
+static const int TILE_SIZE = 64;
+
+/**
+ * A transformation is not split in ranges of less pixels than this
+ */
+static const int MIN_PIXELS_PER_RANGE = 256 * 1024;
+
+/**
+ * 24 bits pixels
+ */
+struct Pixel24
+{
+    uchar mBytes[3];
+};
+
+static bool swapsAxes(Orientation orientation)
+{
+    return orientation == TRANSPOSE || orientation == ROT_90
+        || orientation == TRANSVERSE || orientation == ROT_270;
+}
+
+/**
+ * Flips rows [start, end[ of the destination, for orientations which do not
+ * swap axes
+ */
+template <typename Pixel>
+static void flipRows(const uchar* srcBits, int srcStride, uchar* dstBits, int dstStride, int width, int height, Orientation orientation, int start, int end)
+{
+    const bool hflip = orientation == HFLIP || orientation == ROT_180;
+    const bool vflip = orientation == VFLIP || orientation == ROT_180;
+    for (int y = start; y < end; ++y) {
+        const int srcY = vflip ? height - 1 - y : y;
+        const Pixel* src = reinterpret_cast<const Pixel*>(srcBits + qptrdiff(srcY) * srcStride);
+        Pixel* dst = reinterpret_cast<Pixel*>(dstBits + qptrdiff(y) * dstStride);
+        if (hflip) {
+            std::reverse_copy(src, src + width, dst);
+        } else {
+            memcpy(dst, src, width * sizeof(Pixel));
+        }
+    }
+}
+
+/**
+ * Fills the rows of tiles [start, end[ of the destination, for orientations
+ * which swap axes. @p width and @p height are the size of the source.
+ */
+template <typename Pixel>
+static void rotateTiles(const uchar* srcBits, int srcStride, uchar* dstBits, int dstStride, int width, int height, Orientation orientation, int start, int end)
+{
+    // Destination pixel (dx, dy) comes from source column dy or width-1-dy,
+    // and source row dx or height-1-dx
+    const bool reverseX = orientation == TRANSVERSE || orientation == ROT_270;
+    const bool reverseY = orientation == ROT_90 || orientation == TRANSVERSE;
+    const qptrdiff srcStep = reverseY ? -srcStride : srcStride;
+    const int dstWidth = height;
+    const int dstHeight = width;
+
+    for (int tileY = start * TILE_SIZE; tileY < qMin(end * TILE_SIZE, dstHeight); tileY += TILE_SIZE) {
+        const int tileBottom = qMin(tileY + TILE_SIZE, dstHeight);
+        for (int tileX = 0; tileX < dstWidth; tileX += TILE_SIZE) {
+            const int tileRight = qMin(tileX + TILE_SIZE, dstWidth);
+            const int srcFirstY = reverseY ? height - 1 - tileX : tileX;
+            for (int dy = tileY; dy < tileBottom; ++dy) {
+                const int srcX = reverseX ? width - 1 - dy : dy;
+                const uchar* src = srcBits + qptrdiff(srcFirstY) * srcStride + srcX * qptrdiff(sizeof(Pixel));
+                Pixel* dst = reinterpret_cast<Pixel*>(dstBits + qptrdiff(dy) * dstStride);
+                for (int dx = tileX; dx < tileRight; ++dx, src += srcStep) {
+                    dst[dx] = *reinterpret_cast<const Pixel*>(src);
+                }
+            }
+        }
+    }
+}
+
+template <typename Pixel>
+static void transformPixels(const QImage& src, QImage* dst, Orientation orientation, WorkerLane::Enum lane)
+{
+    const uchar* srcBits = src.constBits();
+    const int srcStride = src.bytesPerLine();
+    // Get the bits before starting the threads, bits() may detach
+    uchar* dstBits = dst->bits();
+    const int dstStride = dst->bytesPerLine();
+    const int width = src.width();
+    const int height = src.height();
+
+    if (swapsAxes(orientation)) {
+        const int tileRows = (width + TILE_SIZE - 1) / TILE_SIZE;
+        const int minTileRows = qMax(1, MIN_PIXELS_PER_RANGE / (TILE_SIZE * height));
+        WorkerPool::runInRanges(lane, tileRows, minTileRows, [=](int start, int end) {
+            rotateTiles<Pixel>(srcBits, srcStride, dstBits, dstStride, width, height, orientation, start, end);
+        });
+    } else {
+        const int minRows = qMax(1, MIN_PIXELS_PER_RANGE / width);
+        WorkerPool::runInRanges(lane, height, minRows, [=](int start, int end) {
+            flipRows<Pixel>(srcBits, srcStride, dstBits, dstStride, width, height, orientation, start, end);
+        });
+    }
+}
+
 QMatrix transformMatrix(Orientation orientation)
 {
     QMatrix matrix;
@@ -70,5 +181,47 @@ QMatrix transformMatrix(Orientation orientation)
     return matrix;
 }
 
+QImage transformed(const QImage& image, Orientation orientation, WorkerLane::Enum lane)
+{
+    if (image.isNull() || orientation == NOT_AVAILABLE || orientation == NORMAL) {
+        return image;
+    }
+    const int depth = image.depth();
+    if (depth != 8 && depth != 16 && depth != 24 && depth != 32 && depth != 64) {
+        // Pixels smaller than a byte, not worth a dedicated path
+        return image.transformed(transformMatrix(orientation));
+    }
+
+    TraceSpan span("transformImage");
+    const bool swap = swapsAxes(orientation);
+    QImage result(swap ? image.height() : image.width(), swap ? image.width() : image.height(), image.format());
+    if (result.isNull()) {
+        return QImage();
+    }
+    result.setColorTable(image.colorTable());
+    result.setDotsPerMeterX(swap ? image.dotsPerMeterY() : image.dotsPerMeterX());
+    result.setDotsPerMeterY(swap ? image.dotsPerMeterX() : image.dotsPerMeterY());
+    result.setDevicePixelRatio(image.devicePixelRatio());
+
+    switch (depth) {
+    case 8:
+        transformPixels<quint8>(image, &result, orientation, lane);
+        break;
+    case 16:
+        transformPixels<quint16>(image, &result, orientation, lane);
+        break;
+    case 24:
+        transformPixels<Pixel24>(image, &result, orientation, lane);
+        break;
+    case 32:
+        transformPixels<quint32>(image, &result, orientation, lane);
+        break;
+    case 64:
+        transformPixels<quint64>(image, &result, orientation, lane);
+        break;
+    }
+    return result;
+}
+
 } // namespace
 } // namespace
@@ -23,7 +23,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 
 #include <lib/gwenviewlib_export.h>
 #include <lib/orientation.h>
+#include <lib/workerlane.h>
 
+class QImage;
 class QMatrix;
 
 namespace Gwenview
@@ -33,6 +35,15 @@ namespace ImageUtils
 
 GWENVIEWLIB_EXPORT QMatrix transformMatrix(Orientation);
 
+/**
+ * Returns @p image with @p orientation applied, like
+ * QImage::transformed(transformMatrix(orientation)) but without
+ * interpolation. Rotations are done in tiles, so that both the source and
+ * the destination stay in cache, and large images are split between the
+ * threads of @p lane.
+ */
+GWENVIEWLIB_EXPORT QImage transformed(const QImage& image, Orientation orientation, WorkerLane::Enum lane = WorkerLane::Interactive);
+
 } // namespace
 } // namespace
 
@@ -214,6 +214,71 @@ bool JpegContent::load(const QString& path)
     return loadFromData(file.readAll());
 }
 
+/**
+ * Returns the beginning of the JPEG file read from @p device, up to and
+ * including the first SOS segment. Returns an empty array if the file is
+ * not a valid JPEG file.
+ */
+static QByteArray readJpegHeader(QIODevice* device)
+{
+    QByteArray header = device->read(2);
+    if (header != QByteArray("\xff\xd8", 2)) {
+        return QByteArray();
+    }
+    forever {
+        char byte;
+        if (!device->getChar(&byte) || uchar(byte) != 0xff) {
+            return QByteArray();
+        }
+        // Markers may be preceded by fill bytes
+        do {
+            if (!device->getChar(&byte)) {
+                return QByteArray();
+            }
+        } while (uchar(byte) == 0xff);
+        const uchar marker = byte;
+        if (marker == 0xd9) {
+            // EOI before any image data
+            return QByteArray();
+        }
+
+        const QByteArray length = device->read(2);
+        if (length.size() != 2) {
+            return QByteArray();
+        }
+        const int dataSize = ((uchar(length[0]) << 8) | uchar(length[1])) - 2;
+        if (dataSize < 0) {
+            return QByteArray();
+        }
+        const QByteArray data = device->read(dataSize);
+        if (data.size() != dataSize) {
+            return QByteArray();
+        }
+        header += '\xff';
+        header += byte;
+        header += length;
+        header += data;
+        if (marker == 0xda) {
+            // SOS: compressed data follows
+            return header;
+        }
+    }
+}
+
+bool JpegContent::loadHeader(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Could not open '" << path << "' for reading\n";
+        return false;
+    }
+    const QByteArray header = readJpegHeader(&file);
+    if (header.isEmpty()) {
+        return false;
+    }
+    return loadFromData(header);
+}
+
 bool JpegContent::loadFromData(const QByteArray& data)
 {
     Exiv2::Image::AutoPtr image;
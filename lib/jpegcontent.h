@@ -65,6 +65,13 @@ public:
     void setImage(const QImage& image);
 
     bool load(const QString& file);
+    /**
+     * Only reads the JPEG segments up to the image data: enough to know the
+     * size, the Exif data and the thumbnail, without reading the whole file.
+     * rawData() then only contains these segments, so the content cannot be
+     * transformed or saved.
+     */
+    bool loadHeader(const QString& file);
     bool loadFromData(const QByteArray& rawData);
     /**
      * Use this version of loadFromData if you already have an Exiv2::Image*
@@ -0,0 +1,156 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "jpegregiondecoder.h"
+
+// System
+#include <stdio.h>
+#include <string.h>
+
+// Qt
+#include <QBuffer>
+#include <QDebug>
+
+// KDE
+
+// Local
+#include "iodevicejpegsourcemanager.h"
+#include "jpegerrormanager.h"
+#include "tracing.h"
+#include <config-gwenview.h>
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+namespace JpegRegionDecoder
+{
+
+QImage decode(const QByteArray& data, const QRect& requestedRect)
+{
+    TraceSpan span("jpegRegionDecode");
+    // QBuffer needs a non-const array, this does not copy the data
+    QByteArray rawData = data;
+    QBuffer buffer(&rawData);
+    buffer.open(QIODevice::ReadOnly);
+
+    struct jpeg_decompress_struct cinfo;
+    JPEGErrorManager errorManager;
+    cinfo.err = &errorManager;
+    jpeg_create_decompress(&cinfo);
+    if (setjmp(errorManager.jmp_buffer)) {
+        jpeg_destroy_decompress(&cinfo);
+        return QImage();
+    }
+
+    IODeviceJpegSourceManager::setup(&cinfo, &buffer);
+    if (jpeg_read_header(&cinfo, true) != JPEG_HEADER_OK) {
+        jpeg_destroy_decompress(&cinfo);
+        return QImage();
+    }
+
+    bool grayscale;
+    switch (cinfo.jpeg_color_space) {
+    case JCS_GRAYSCALE:
+        grayscale = true;
+        cinfo.out_color_space = JCS_GRAYSCALE;
+        break;
+    case JCS_YCbCr:
+    case JCS_RGB:
+        grayscale = false;
+        cinfo.out_color_space = JCS_RGB;
+        break;
+    default:
+        // CMYK images need the Adobe inversion handling of Qt decoder
+        LOG("Unsupported color space" << cinfo.jpeg_color_space);
+        jpeg_destroy_decompress(&cinfo);
+        return QImage();
+    }
+
+    const QRect rect = requestedRect.intersected(QRect(0, 0, cinfo.image_width, cinfo.image_height));
+    if (rect.isEmpty()) {
+        jpeg_destroy_decompress(&cinfo);
+        return QImage();
+    }
+
+    // Allocate the image before setting the jump point again, so that it is
+    // in a consistent state if libjpeg fails while decoding
+    QImage image(rect.size(), grayscale ? QImage::Format_Grayscale8 : QImage::Format_RGB32);
+    if (image.isNull()) {
+        jpeg_destroy_decompress(&cinfo);
+        return QImage();
+    }
+    if (setjmp(errorManager.jmp_buffer)) {
+        jpeg_destroy_decompress(&cinfo);
+        return QImage();
+    }
+
+    jpeg_start_decompress(&cinfo);
+
+#ifdef HAVE_JPEG_CROP_SCANLINE
+    // libjpeg-turbo aligns the crop on iMCU boundaries, so the decoded rows
+    // may start left of the region
+    JDIMENSION xOffset = rect.x();
+    JDIMENSION width = rect.width();
+    jpeg_crop_scanline(&cinfo, &xOffset, &width);
+    const int skippedColumns = rect.x() - int(xOffset);
+    const int rowSize = cinfo.output_width * cinfo.output_components;
+    JSAMPARRAY row = (*cinfo.mem->alloc_sarray)(reinterpret_cast<j_common_ptr>(&cinfo), JPOOL_IMAGE, rowSize, 1);
+    jpeg_skip_scanlines(&cinfo, rect.y());
+#else
+    const int skippedColumns = rect.x();
+    const int rowSize = cinfo.output_width * cinfo.output_components;
+    JSAMPARRAY row = (*cinfo.mem->alloc_sarray)(reinterpret_cast<j_common_ptr>(&cinfo), JPOOL_IMAGE, rowSize, 1);
+    while (int(cinfo.output_scanline) < rect.y()) {
+        jpeg_read_scanlines(&cinfo, row, 1);
+    }
+#endif
+
+    for (int y = 0; y < rect.height(); ++y) {
+        jpeg_read_scanlines(&cinfo, row, 1);
+        const JSAMPLE* src = row[0] + skippedColumns * cinfo.output_components;
+        if (grayscale) {
+            memcpy(image.scanLine(y), src, rect.width());
+        } else {
+            QRgb* dst = reinterpret_cast<QRgb*>(image.scanLine(y));
+            for (int x = 0; x < rect.width(); ++x, src += 3) {
+                dst[x] = qRgb(src[0], src[1], src[2]);
+            }
+        }
+    }
+
+    // Do not call jpeg_finish_decompress(): it would decode the rows below
+    // the region
+    jpeg_destroy_decompress(&cinfo);
+    return image;
+}
+
+} // namespace
+
+} // namespace
@@ -0,0 +1,61 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef JPEGREGIONDECODER_H
+#define JPEGREGIONDECODER_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QByteArray>
+#include <QImage>
+#include <QRect>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+/**
+ * Decodes a part of a JPEG image without decoding the whole image. Rows
+ * below the region are not decoded at all. With libjpeg-turbo, rows above
+ * the region are skipped without running the IDCT on them, and only the
+ * iMCU columns intersecting the region are decoded.
+ */
+namespace JpegRegionDecoder
+{
+
+/**
+ * Returns the pixels of @p rect from the JPEG image stored in @p data.
+ * Grayscale images are returned as Format_Grayscale8, other images as
+ * Format_RGB32. Exif orientation is not applied.
+ *
+ * Returns a null image if @p data cannot be decoded this way, for example
+ * because it is a CMYK image.
+ */
+GWENVIEWLIB_EXPORT QImage decode(const QByteArray& data, const QRect& rect);
+
+} // namespace
+
+} // namespace
+
+#endif /* JPEGREGIONDECODER_H */
@@ -0,0 +1,282 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "memorypressuremonitor.h"
+
+// Qt
+#include <QDebug>
+#include <QFile>
+#include <QTimer>
+
+// KDE
+
+// Local
+#include "memoryutils.h"
+#include "tracing.h"
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+static const int POLL_INTERVAL = 2000;
+
+// Thresholds, in percentage of stalled time over the last 10 seconds
+static const qreal MODERATE_SOME_AVG10 = 10;
+static const qreal CRITICAL_SOME_AVG10 = 40;
+static const qreal CRITICAL_FULL_AVG10 = 10;
+
+// Thresholds, in percentage of the cgroup memory limit
+static const int MODERATE_CGROUP_USAGE = 80;
+static const int CRITICAL_CGROUP_USAGE = 90;
+
+static QByteArray readFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+struct MemoryPressureMonitorPrivate
+{
+    QTimer mTimer;
+    MemoryPressureMonitor::Level mLevel;
+    QString mPressurePath;
+    QString mCgroupCurrentPath;
+    QString mCgroupMaxPath;
+    QString mCgroupStatPath;
+
+    void findFiles()
+    {
+#ifdef Q_OS_LINUX
+        bool unified = false;
+        const QString path = MemoryPressureMonitor::cgroupPath(readFile(QStringLiteral("/proc/self/cgroup")), &unified);
+        if (!path.isEmpty()) {
+            if (unified) {
+                const QString dir = QStringLiteral("/sys/fs/cgroup") + path;
+                // The pressure of our cgroup is more relevant than the
+                // pressure of the whole system
+                if (QFile::exists(dir + QStringLiteral("/memory.pressure"))) {
+                    mPressurePath = dir + QStringLiteral("/memory.pressure");
+                }
+                mCgroupCurrentPath = dir + QStringLiteral("/memory.current");
+                mCgroupMaxPath = dir + QStringLiteral("/memory.max");
+                mCgroupStatPath = dir + QStringLiteral("/memory.stat");
+            } else {
+                const QString dir = QStringLiteral("/sys/fs/cgroup/memory") + path;
+                mCgroupCurrentPath = dir + QStringLiteral("/memory.usage_in_bytes");
+                mCgroupMaxPath = dir + QStringLiteral("/memory.limit_in_bytes");
+                mCgroupStatPath = dir + QStringLiteral("/memory.stat");
+            }
+            if (!QFile::exists(mCgroupMaxPath)) {
+                mCgroupCurrentPath.clear();
+                mCgroupMaxPath.clear();
+                mCgroupStatPath.clear();
+            }
+        }
+        if (mPressurePath.isEmpty() && QFile::exists(QStringLiteral("/proc/pressure/memory"))) {
+            mPressurePath = QStringLiteral("/proc/pressure/memory");
+        }
+        LOG("Pressure:" << mPressurePath << "cgroup:" << mCgroupCurrentPath << mCgroupMaxPath << mCgroupStatPath);
+#endif
+    }
+
+    MemoryPressureMonitor::Sample readSample() const
+    {
+        MemoryPressureMonitor::Sample sample;
+        if (!mPressurePath.isEmpty()) {
+            MemoryPressureMonitor::parsePressure(readFile(mPressurePath), &sample);
+        }
+        if (!mCgroupMaxPath.isEmpty()) {
+            bool ok;
+            const qulonglong max = readFile(mCgroupMaxPath).trimmed().toULongLong(&ok);
+            // memory.max contains "max" and memory.limit_in_bytes contains a
+            // huge value when there is no limit
+            if (ok && max < MemoryUtils::getTotalMemory()) {
+                sample.cgroupMax = max;
+                sample.cgroupCurrent = readFile(mCgroupCurrentPath).trimmed().toULongLong();
+                MemoryPressureMonitor::parseMemoryStat(readFile(mCgroupStatPath), &sample);
+            }
+        }
+        return sample;
+    }
+};
+
+MemoryPressureMonitor::Sample::Sample()
+: someAvg10(-1)
+, fullAvg10(-1)
+, cgroupCurrent(0)
+, cgroupInactiveFile(0)
+, cgroupMax(0)
+{
+}
+
+MemoryPressureMonitor* MemoryPressureMonitor::instance()
+{
+    static MemoryPressureMonitor monitor;
+    return &monitor;
+}
+
+MemoryPressureMonitor::MemoryPressureMonitor()
+: d(new MemoryPressureMonitorPrivate)
+{
+    d->mLevel = NoPressure;
+    d->findFiles();
+    if (d->mPressurePath.isEmpty() && d->mCgroupMaxPath.isEmpty()) {
+        LOG("No way to monitor memory pressure");
+        return;
+    }
+    d->mTimer.setInterval(POLL_INTERVAL);
+    connect(&d->mTimer, &QTimer::timeout, this, &MemoryPressureMonitor::poll);
+    d->mTimer.start();
+}
+
+MemoryPressureMonitor::~MemoryPressureMonitor()
+{
+    delete d;
+}
+
+MemoryPressureMonitor::Level MemoryPressureMonitor::level() const
+{
+    return d->mLevel;
+}
+
+bool MemoryPressureMonitor::parsePressure(const QByteArray& content, Sample* sample)
+{
+    // Lines look like this:
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    bool found = false;
+    const QList<QByteArray> lines = content.split('\n');
+    for (const QByteArray& line : lines) {
+        const QList<QByteArray> tokens = line.simplified().split(' ');
+        if (tokens.count() < 2 || !tokens[1].startsWith("avg10=")) {
+            continue;
+        }
+        bool ok;
+        const qreal value = tokens[1].mid(6).toDouble(&ok);
+        if (!ok) {
+            continue;
+        }
+        if (tokens[0] == "some") {
+            sample->someAvg10 = value;
+            found = true;
+        } else if (tokens[0] == "full") {
+            sample->fullAvg10 = value;
+            found = true;
+        }
+    }
+    return found;
+}
+
+QString MemoryPressureMonitor::cgroupPath(const QByteArray& content, bool* unified)
+{
+    // Lines look like this: "hierarchy-ID:controller-list:path". The cgroup
+    // v2 line has an empty controller list.
+    QString unifiedPath;
+    const QList<QByteArray> lines = content.split('\n');
+    for (const QByteArray& line : lines) {
+        const int first = line.indexOf(':');
+        const int second = line.indexOf(':', first + 1);
+        if (first == -1 || second == -1) {
+            continue;
+        }
+        const QByteArray controllers = line.mid(first + 1, second - first - 1);
+        const QString path = QString::fromLocal8Bit(line.mid(second + 1));
+        if (controllers.split(',').contains("memory")) {
+            *unified = false;
+            return path;
+        }
+        if (controllers.isEmpty()) {
+            unifiedPath = path;
+        }
+    }
+    *unified = !unifiedPath.isEmpty();
+    return unifiedPath;
+}
+
+bool MemoryPressureMonitor::parseMemoryStat(const QByteArray& content, Sample* sample)
+{
+    // Lines look like this: "inactive_file 123456". cgroup v1 also has
+    // total_* lines, which include the descendants of the cgroup like
+    // memory.usage_in_bytes does, and must be preferred.
+    bool found = false;
+    const QList<QByteArray> lines = content.split('\n');
+    for (const QByteArray& line : lines) {
+        const QList<QByteArray> tokens = line.simplified().split(' ');
+        if (tokens.count() != 2) {
+            continue;
+        }
+        const bool total = tokens[0] == "total_inactive_file";
+        if (!total && tokens[0] != "inactive_file") {
+            continue;
+        }
+        bool ok;
+        const qulonglong value = tokens[1].toULongLong(&ok);
+        if (!ok) {
+            continue;
+        }
+        sample->cgroupInactiveFile = value;
+        found = true;
+        if (total) {
+            break;
+        }
+    }
+    return found;
+}
+
+MemoryPressureMonitor::Level MemoryPressureMonitor::levelForSample(const Sample& sample)
+{
+    const qulonglong workingSet = sample.cgroupCurrent - qMin(sample.cgroupInactiveFile, sample.cgroupCurrent);
+    const int cgroupUsage = sample.cgroupMax > 0 ? int(workingSet * 100 / sample.cgroupMax) : 0;
+    if (sample.someAvg10 >= CRITICAL_SOME_AVG10 || sample.fullAvg10 >= CRITICAL_FULL_AVG10
+            || cgroupUsage >= CRITICAL_CGROUP_USAGE) {
+        return CriticalPressure;
+    }
+    if (sample.someAvg10 >= MODERATE_SOME_AVG10 || cgroupUsage >= MODERATE_CGROUP_USAGE) {
+        return ModeratePressure;
+    }
+    return NoPressure;
+}
+
+void MemoryPressureMonitor::poll()
+{
+    const Sample sample = d->readSample();
+    const Level level = levelForSample(sample);
+    if (level == d->mLevel) {
+        return;
+    }
+    LOG("Memory pressure level:" << level << "some:" << sample.someAvg10 << "full:" << sample.fullAvg10
+        << "cgroup:" << sample.cgroupCurrent << "-" << sample.cgroupInactiveFile << "/" << sample.cgroupMax);
+    d->mLevel = level;
+    Tracing::counter("memoryPressure", level);
+    emit levelChanged(level);
+}
+
+} // namespace
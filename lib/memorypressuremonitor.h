@@ -0,0 +1,122 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef MEMORYPRESSUREMONITOR_H
+#define MEMORYPRESSUREMONITOR_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QObject>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+struct MemoryPressureMonitorPrivate;
+
+/**
+ * Watches the memory pressure of the process, using the pressure stall
+ * information of the kernel (/proc/pressure/memory, or memory.pressure of
+ * our cgroup) and the memory limit of our cgroup, so that caches can be
+ * shed before the process gets OOM-killed.
+ *
+ * The usage of the cgroup does not count the inactive page cache: the
+ * kernel only reclaims it when getting close to the limit, so reading
+ * files would otherwise keep the usage close to the limit.
+ *
+ * Memory is shed in this order, from cheapest to most expensive to get back:
+ * - ModeratePressure: scaled thumbnails of hidden items, unreferenced
+ *   documents but the most recent one
+ * - CriticalPressure: thumbnails of hidden items, thumbnails waiting to be
+ *   written to disk, all unreferenced documents, undo history of saved
+ *   documents
+ *
+ * Only implemented on Linux, the level is always NoPressure elsewhere.
+ */
+class GWENVIEWLIB_EXPORT MemoryPressureMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    enum Level {
+        NoPressure,
+        ModeratePressure,
+        CriticalPressure
+    };
+    Q_ENUM(Level)
+
+    struct Sample
+    {
+        Sample();
+        /// Percentage of time some tasks were stalled on memory, -1 if unknown
+        qreal someAvg10;
+        /// Percentage of time all tasks were stalled on memory, -1 if unknown
+        qreal fullAvg10;
+        /// Memory used by our cgroup, in bytes
+        qulonglong cgroupCurrent;
+        /// Part of cgroupCurrent used by inactive page cache, in bytes
+        qulonglong cgroupInactiveFile;
+        /// Memory limit of our cgroup, in bytes, 0 if there is no limit
+        qulonglong cgroupMax;
+    };
+
+    static MemoryPressureMonitor* instance();
+    ~MemoryPressureMonitor() override;
+
+    Level level() const;
+
+    /**
+     * Parses the content of a pressure stall information file into the
+     * someAvg10 and fullAvg10 fields of @p sample
+     */
+    static bool parsePressure(const QByteArray& content, Sample* sample);
+
+    /**
+     * Returns the path of our memory cgroup, relative to its hierarchy, from
+     * the content of /proc/self/cgroup. Sets @p unified to true if it is a
+     * cgroup v2 path.
+     */
+    static QString cgroupPath(const QByteArray& content, bool* unified);
+
+    /**
+     * Parses the content of the memory.stat file of our cgroup into the
+     * cgroupInactiveFile field of @p sample
+     */
+    static bool parseMemoryStat(const QByteArray& content, Sample* sample);
+
+    static Level levelForSample(const Sample& sample);
+
+Q_SIGNALS:
+    void levelChanged(MemoryPressureMonitor::Level level);
+
+private Q_SLOTS:
+    void poll();
+
+private:
+    MemoryPressureMonitor();
+    MemoryPressureMonitorPrivate* const d;
+};
+
+} // namespace
+
+#endif /* MEMORYPRESSUREMONITOR_H */
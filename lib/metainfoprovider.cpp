@@ -0,0 +1,173 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "metainfoprovider.h"
+
+// Qt
+#include <QCache>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QtConcurrent>
+
+// KDE
+
+// Local
+#include "exiv2imageloader.h"
+#include "gwenviewconfig.h"
+#include "imagemetainfomodel.h"
+#include "tracing.h"
+#include "workerpool.h"
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+static const int MAX_CACHED_ENTRIES = 50;
+
+struct MetaInfoCacheEntry
+{
+    QDateTime mModificationTime;
+    MetaInfoProvider::ModelPtr mModel;
+};
+
+struct MetaInfoProviderPrivate
+{
+    QCache<QUrl, MetaInfoCacheEntry> mCache;
+    QFutureWatcher<MetaInfoProvider::ModelPtr> mWatcher;
+
+    // Url and modification time of the file being read
+    QUrl mCurrentUrl;
+    QDateTime mCurrentModificationTime;
+
+    // Last url requested while mCurrentUrl was being read
+    QUrl mPendingUrl;
+    QDateTime mPendingModificationTime;
+
+    void startLoading(const QUrl& url, const QDateTime& modificationTime)
+    {
+        LOG("Reading meta info of" << url);
+        mCurrentUrl = url;
+        mCurrentModificationTime = modificationTime;
+        mWatcher.setFuture(WorkerPool::run(WorkerLane::Interactive, [url]() {
+            return MetaInfoProvider::loadMetaInfo(url);
+        }));
+    }
+};
+
+MetaInfoProvider* MetaInfoProvider::instance()
+{
+    static MetaInfoProvider provider;
+    return &provider;
+}
+
+MetaInfoProvider::MetaInfoProvider()
+: d(new MetaInfoProviderPrivate)
+{
+    d->mCache.setMaxCost(MAX_CACHED_ENTRIES);
+    connect(&d->mWatcher, SIGNAL(finished()), SLOT(slotLoaded()));
+}
+
+MetaInfoProvider::~MetaInfoProvider()
+{
+    d->mWatcher.disconnect();
+    d->mWatcher.waitForFinished();
+    delete d;
+}
+
+MetaInfoProvider::ModelPtr MetaInfoProvider::metaInfo(const QUrl& url, const QDateTime& modificationTime)
+{
+    MetaInfoCacheEntry* entry = d->mCache.object(url);
+    if (entry) {
+        if (entry->mModificationTime == modificationTime) {
+            return entry->mModel;
+        }
+        LOG("Stale entry for" << url);
+        d->mCache.remove(url);
+    }
+
+    if (d->mWatcher.isRunning()) {
+        if (d->mCurrentUrl != url || d->mCurrentModificationTime != modificationTime) {
+            d->mPendingUrl = url;
+            d->mPendingModificationTime = modificationTime;
+        } else {
+            d->mPendingUrl.clear();
+        }
+    } else {
+        d->startLoading(url, modificationTime);
+    }
+    return ModelPtr();
+}
+
+MetaInfoProvider::ModelPtr MetaInfoProvider::loadMetaInfo(const QUrl& url)
+{
+    TraceSpan span("metaInfoProvider", url);
+    ModelPtr model(new ImageMetaInfoModel);
+    model->setUrl(url);
+
+    const QString path = url.toLocalFile();
+    QImageReader reader(path);
+    QSize size = reader.size();
+    if (size.isValid() && GwenviewConfig::applyExifOrientation()
+            && (reader.transformation() & QImageIOHandler::TransformationRotate90)) {
+        size.transpose();
+    }
+    model->setImageSize(size);
+
+    Exiv2ImageLoader loader;
+    if (loader.load(path)) {
+        Exiv2::Image::AutoPtr image = loader.popImage();
+        model->setExiv2Image(image.get());
+    } else {
+        LOG("Could not read Exiv2 metadata:" << loader.errorMessage());
+    }
+
+    if (QCoreApplication::instance()) {
+        model->moveToThread(QCoreApplication::instance()->thread());
+    }
+    return model;
+}
+
+void MetaInfoProvider::slotLoaded()
+{
+    MetaInfoCacheEntry* entry = new MetaInfoCacheEntry;
+    entry->mModificationTime = d->mCurrentModificationTime;
+    entry->mModel = d->mWatcher.result();
+    d->mCache.insert(d->mCurrentUrl, entry);
+
+    const QUrl url = d->mCurrentUrl;
+    if (!d->mPendingUrl.isEmpty()) {
+        d->startLoading(d->mPendingUrl, d->mPendingModificationTime);
+        d->mPendingUrl.clear();
+    }
+    emit metaInfoLoaded(url);
+}
+
+} // namespace
@@ -0,0 +1,91 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef METAINFOPROVIDER_H
+#define METAINFOPROVIDER_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QDateTime>
+#include <QObject>
+#include <QSharedPointer>
+#include <QUrl>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+class ImageMetaInfoModel;
+
+struct MetaInfoProviderPrivate;
+
+/**
+ * Provides the meta information of local files without loading them as a
+ * Document: only the image header is read to get the size, and Exiv2 only
+ * reads the metadata. Reading is done on a worker thread.
+ *
+ * Results are cached, entries are considered stale when the modification
+ * time of the file changes.
+ */
+class GWENVIEWLIB_EXPORT MetaInfoProvider : public QObject
+{
+    Q_OBJECT
+public:
+    typedef QSharedPointer<ImageMetaInfoModel> ModelPtr;
+
+    static MetaInfoProvider* instance();
+    ~MetaInfoProvider() override;
+
+    /**
+     * Returns the meta information of the local file @p url, whose
+     * modification time is @p modificationTime.
+     *
+     * If it is not in the cache yet, returns a null pointer and starts
+     * reading the file. metaInfoLoaded() is emitted when done. Only the last
+     * requested url is read if several requests are made while a file is
+     * being read.
+     */
+    ModelPtr metaInfo(const QUrl& url, const QDateTime& modificationTime);
+
+    /**
+     * Reads the meta information of @p url synchronously, without going
+     * through the cache. Can be called from any thread, the returned model
+     * belongs to the thread of the application instance.
+     */
+    static ModelPtr loadMetaInfo(const QUrl& url);
+
+Q_SIGNALS:
+    void metaInfoLoaded(const QUrl& url);
+
+private Q_SLOTS:
+    void slotLoaded();
+
+private:
+    MetaInfoProvider();
+    MetaInfoProviderPrivate* const d;
+};
+
+} // namespace
+
+#endif /* METAINFOPROVIDER_H */
@@ -0,0 +1,126 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "multiresolutionreader.h"
+
+// STL
+#include <algorithm>
+
+// Qt
+#include <QDebug>
+#include <QImageReader>
+
+// KDE
+
+// Local
+#include "tracing.h"
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+namespace MultiResolutionReader
+{
+
+/**
+ * Returns true if @p size has the aspect ratio of @p mainSize, allowing for
+ * the rounding done when the level was created
+ */
+static bool hasSameAspectRatio(const QSize& size, const QSize& mainSize)
+{
+    const qreal expectedHeight = qreal(size.width()) * mainSize.height() / mainSize.width();
+    return qAbs(size.height() - expectedHeight) <= qMax(1., expectedHeight / 100);
+}
+
+QVector<Level> levels(QImageReader* reader)
+{
+    QVector<Level> list;
+    // Handlers which can scale while decoding do not need levels, and frames
+    // of animations are not levels
+    if (reader->supportsOption(QImageIOHandler::ScaledSize) || reader->supportsAnimation()) {
+        return list;
+    }
+    const int count = reader->imageCount();
+    if (count < 2) {
+        return list;
+    }
+    const QSize mainSize = reader->size();
+    if (!mainSize.isValid()) {
+        return list;
+    }
+
+    for (int index = 1; index < count; ++index) {
+        if (!reader->jumpToImage(index)) {
+            break;
+        }
+        const QSize size = reader->size();
+        LOG("Image" << index << "size" << size);
+        if (!size.isValid() || size.width() >= mainSize.width() || !hasSameAspectRatio(size, mainSize)) {
+            continue;
+        }
+        list << Level {index, size};
+    }
+    reader->jumpToImage(0);
+
+    std::sort(list.begin(), list.end(), [](const Level& level1, const Level& level2) {
+        return level1.size.width() > level2.size.width();
+    });
+    return list;
+}
+
+bool readLevel(QImageReader* reader, const QSize& minimumSize, QImage* image)
+{
+    const QVector<Level> list = levels(reader);
+    // Levels are sorted biggest first, look for the last one which is big
+    // enough
+    int index = -1;
+    for (const Level& level : list) {
+        if (level.size.width() < minimumSize.width() || level.size.height() < minimumSize.height()) {
+            break;
+        }
+        index = level.index;
+    }
+    if (index == -1) {
+        return false;
+    }
+
+    LOG("Reading level" << index);
+    TraceSpan span("readMultiResolutionLevel");
+    if (!reader->jumpToImage(index) || !reader->read(image)) {
+        qWarning() << "Could not read level" << index << ":" << reader->errorString();
+        *image = QImage();
+        reader->jumpToImage(0);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+} // namespace
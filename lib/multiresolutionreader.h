@@ -0,0 +1,79 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef MULTIRESOLUTIONREADER_H
+#define MULTIRESOLUTIONREADER_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QImage>
+#include <QSize>
+#include <QVector>
+
+// KDE
+
+// Local
+
+class QImageReader;
+
+namespace Gwenview
+{
+
+/**
+ * Reads the reduced-resolution versions of an image stored in the same file,
+ * such as the levels of pyramidal TIFF images. Reading a level is much faster
+ * than decoding the main image and scaling it down, and it works with formats
+ * which do not support QImageIOHandler::ScaledSize.
+ */
+namespace MultiResolutionReader
+{
+
+struct Level
+{
+    /// Index of the level, to use with QImageReader::jumpToImage()
+    int index;
+    QSize size;
+};
+
+/**
+ * Returns the reduced-resolution levels of the image read by @p reader,
+ * biggest first. Images which are not a smaller version of the first one,
+ * for example the other pages of a multi-page document, are ignored.
+ *
+ * The reader is left on the first image.
+ */
+GWENVIEWLIB_EXPORT QVector<Level> levels(QImageReader* reader);
+
+/**
+ * Reads in @p image the smallest level of @p reader which is at least as big
+ * as @p minimumSize. Sizes are in the coordinates of the file, before any
+ * transformation is applied.
+ *
+ * Returns false if there is no such level, in which case the reader is left
+ * on the first image.
+ */
+GWENVIEWLIB_EXPORT bool readLevel(QImageReader* reader, const QSize& minimumSize, QImage* image);
+
+} // namespace
+
+} // namespace
+
+#endif /* MULTIRESOLUTIONREADER_H */
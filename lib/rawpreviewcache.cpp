@@ -0,0 +1,382 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "rawpreviewcache.h"
+
+#include <sys/types.h>
+#include <utime.h>
+
+// Qt
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QStringList>
+#include <QWaitCondition>
+
+// KDE
+#ifdef KDCRAW_FOUND
+#include <kdcraw/kdcraw.h>
+#endif
+
+// Local
+#include "cachedirs.h"
+#include "workerpool.h"
+
+namespace Gwenview
+{
+
+namespace RawPreviewCache
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+static const quint32 CACHE_MAGIC = 0x47565250; // "GVRP"
+static const quint32 CACHE_VERSION = 1;
+
+inline qint64 getMaxCacheSize()
+{
+    qint64 defaultValue = 256;
+    QByteArray ba = qgetenv("GV_MAX_RAW_PREVIEW_CACHE_MB");
+    if (ba.isEmpty()) {
+        return defaultValue << 20;
+    }
+    LOG("Custom value for max raw preview cache size:" << ba);
+    bool ok;
+    qint64 value = ba.toLongLong(&ok);
+    return (ok ? value : defaultValue) << 20;
+}
+
+static const qint64 MAX_CACHE_SIZE = getMaxCacheSize();
+
+/**
+ * Maximum number of half previews waiting to be generated in the background
+ */
+static const int MAX_QUEUED_HALF_PREVIEWS = 16;
+
+/**
+ * Keeps track of the previews currently being extracted, so that a second
+ * extraction of the same file waits for the first one instead of doing the
+ * work again, and of the half previews waiting to be generated in the
+ * background.
+ */
+struct ExtractionRegistry
+{
+    ExtractionRegistry()
+    : mQueueScheduled(false)
+    , mShuttingDown(false)
+    {
+        if (qApp) {
+            // Do not keep the application from quitting while we extract
+            // previews nobody is going to look at
+            QObject::connect(qApp, &QCoreApplication::aboutToQuit, qApp, [this]() {
+                QMutexLocker locker(&mMutex);
+                mShuttingDown = true;
+                mQueue.clear();
+            });
+        }
+    }
+
+    QMutex mMutex;
+    QWaitCondition mCond;
+    QSet<QString> mRunning;
+    QStringList mQueue;
+    bool mQueueScheduled;
+    bool mShuttingDown;
+};
+
+Q_GLOBAL_STATIC(ExtractionRegistry, sRegistry)
+
+QString cacheDir()
+{
+    return CacheDirs::path(QStringLiteral("rawpreviews"));
+}
+
+void setCacheDir(const QString& dir)
+{
+    CacheDirs::setPath(QStringLiteral("rawpreviews"), dir);
+}
+
+bool isRawFile(const QString& fileName)
+{
+#ifdef KDCRAW_FOUND
+    const QString extension = fileName.section(QLatin1Char('.'), -1).toLower();
+    return KDcrawIface::KDcraw::rawFilesList().contains(extension);
+#else
+    Q_UNUSED(fileName);
+    return false;
+#endif
+}
+
+static QString entryPath(const QString& filePath)
+{
+    QCryptographicHash md5(QCryptographicHash::Md5);
+    md5.addData(QFile::encodeName(filePath));
+    return cacheDir() + QString::fromLatin1(md5.result().toHex()) + QStringLiteral(".preview");
+}
+
+static int previewMinSide(const QByteArray& data)
+{
+    QByteArray copy = data;
+    QBuffer buffer(&copy);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    const QSize size = reader.size();
+    return size.isValid() ? qMin(size.width(), size.height()) : 0;
+}
+
+/**
+ * Removes the least recently used entries until the cache is smaller than
+ * MAX_CACHE_SIZE
+ */
+static void evictEntries()
+{
+    QDir dir(cacheDir());
+    const QFileInfoList list = dir.entryInfoList(QStringList() << QStringLiteral("*.preview"), QDir::Files, QDir::Time | QDir::Reversed);
+    qint64 total = 0;
+    Q_FOREACH(const QFileInfo& info, list) {
+        total += info.size();
+    }
+    for (int idx = 0; idx < list.size() && total > MAX_CACHE_SIZE; ++idx) {
+        LOG("Evicting" << list.at(idx).fileName());
+        total -= list.at(idx).size();
+        QFile::remove(list.at(idx).absoluteFilePath());
+    }
+}
+
+bool findPreview(const QString& filePath, int minSize, Preview* preview)
+{
+    const QFileInfo sourceInfo(filePath);
+    const QString path = entryPath(filePath);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 magic, version;
+    qint64 sourceMTime, sourceSize;
+    qint32 ratio, minSide;
+    QByteArray data;
+    stream >> magic >> version;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        return false;
+    }
+    stream >> sourceMTime >> sourceSize;
+    if (sourceMTime != sourceInfo.lastModified().toMSecsSinceEpoch() || sourceSize != sourceInfo.size()) {
+        LOG("Stale entry for" << filePath);
+        file.close();
+        QFile::remove(path);
+        return false;
+    }
+    stream >> ratio >> minSide;
+    if (minSide < minSize) {
+        return false;
+    }
+    stream >> data;
+    if (stream.status() != QDataStream::Ok || data.isEmpty()) {
+        return false;
+    }
+    file.close();
+
+    // Touch the entry so that eviction works on a least-recently-used basis
+    utime(QFile::encodeName(path).constData(), nullptr);
+
+    preview->data = data;
+    preview->ratio = ratio;
+    return true;
+}
+
+void storePreview(const QString& filePath, const Preview& preview)
+{
+    const QFileInfo sourceInfo(filePath);
+    if (!QDir().mkpath(cacheDir())) {
+        qWarning() << "Could not create RAW preview cache dir" << cacheDir();
+        return;
+    }
+    QSaveFile file(entryPath(filePath));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not store RAW preview for" << filePath;
+        return;
+    }
+    QDataStream stream(&file);
+    stream << CACHE_MAGIC << CACHE_VERSION
+           << qint64(sourceInfo.lastModified().toMSecsSinceEpoch())
+           << qint64(sourceInfo.size())
+           << qint32(preview.ratio)
+           << qint32(previewMinSide(preview.data))
+           << preview.data;
+    if (!file.commit()) {
+        qWarning() << "Could not store RAW preview for" << filePath;
+        return;
+    }
+    evictEntries();
+}
+
+#ifdef KDCRAW_FOUND
+/**
+ * Extracts the half-size preview of @p filePath, unless another thread is
+ * already doing it, in which case we wait for it and use its result.
+ */
+static bool extractHalfPreview(const QString& filePath, Preview* preview)
+{
+    ExtractionRegistry* registry = sRegistry;
+    {
+        QMutexLocker locker(&registry->mMutex);
+        while (registry->mRunning.contains(filePath)) {
+            registry->mCond.wait(&registry->mMutex);
+        }
+        if (findPreview(filePath, MIN_PREVIEW_SIZE, preview)) {
+            return true;
+        }
+        registry->mRunning.insert(filePath);
+    }
+
+    LOG("Extracting half preview of" << filePath);
+    bool ok = KDcrawIface::KDcraw::loadHalfPreview(preview->data, filePath);
+    if (ok) {
+        preview->ratio = 2;
+        storePreview(filePath, *preview);
+    } else {
+        qWarning() << "unable to get half preview for" << filePath;
+    }
+
+    QMutexLocker locker(&registry->mMutex);
+    registry->mRunning.remove(filePath);
+    registry->mCond.wakeAll();
+    return ok;
+}
+
+static void processHalfPreviewQueue()
+{
+    ExtractionRegistry* registry = sRegistry;
+    while (true) {
+        QString filePath;
+        {
+            QMutexLocker locker(&registry->mMutex);
+            if (registry->mQueue.isEmpty()) {
+                registry->mQueueScheduled = false;
+                return;
+            }
+            // Most recent request first, it is the one the user is looking at
+            filePath = registry->mQueue.takeLast();
+        }
+        Preview halfPreview;
+        extractHalfPreview(filePath, &halfPreview);
+    }
+}
+
+/**
+ * Generates the half preview of @p filePath in the background. The queue
+ * is processed by a single task, so that it never holds more than one
+ * thread of the lane.
+ */
+static void scheduleHalfPreview(const QString& filePath)
+{
+    ExtractionRegistry* registry = sRegistry;
+    QMutexLocker locker(&registry->mMutex);
+    if (registry->mShuttingDown
+            || registry->mRunning.contains(filePath)
+            || registry->mQueue.contains(filePath)) {
+        return;
+    }
+    if (registry->mQueue.size() >= MAX_QUEUED_HALF_PREVIEWS) {
+        // The oldest requests are the least likely to be useful
+        registry->mQueue.removeFirst();
+    }
+    LOG("Scheduling half preview of" << filePath);
+    registry->mQueue << filePath;
+    if (!registry->mQueueScheduled) {
+        registry->mQueueScheduled = true;
+        WorkerPool::run(WorkerLane::Background, processHalfPreviewQueue);
+    }
+}
+#endif
+
+bool loadPreview(const QString& filePath, int minSize, Preview* preview)
+{
+#ifdef KDCRAW_FOUND
+    if (findPreview(filePath, minSize, preview)) {
+        LOG("Cache hit for" << filePath);
+        return true;
+    }
+
+    {
+        // If a half preview is being extracted, wait for it rather than
+        // starting a second extraction
+        ExtractionRegistry* registry = sRegistry;
+        QMutexLocker locker(&registry->mMutex);
+        while (registry->mRunning.contains(filePath)) {
+            registry->mCond.wait(&registry->mMutex);
+        }
+    }
+    if (findPreview(filePath, minSize, preview)) {
+        return true;
+    }
+
+    QByteArray data;
+    if (KDcrawIface::KDcraw::loadEmbeddedPreview(data, filePath)) {
+        const int minSide = previewMinSide(data);
+        if (minSide >= MIN_PREVIEW_SIZE) {
+            preview->data = data;
+            preview->ratio = 1;
+            storePreview(filePath, *preview);
+            return true;
+        }
+        if (minSide >= minSize) {
+            // Good enough for the caller, generate the better preview in the
+            // background so that it does not delay the caller
+            scheduleHalfPreview(filePath);
+            preview->data = data;
+            preview->ratio = 1;
+            return true;
+        }
+    }
+
+    // The embedded preview is missing or too small, we have no choice but to
+    // extract the half preview now
+    return extractHalfPreview(filePath, preview);
+#else
+    Q_UNUSED(filePath);
+    Q_UNUSED(minSize);
+    Q_UNUSED(preview);
+    return false;
+#endif
+}
+
+} // namespace
+
+} // namespace
@@ -0,0 +1,113 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef RAWPREVIEWCACHE_H
+#define RAWPREVIEWCACHE_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QByteArray>
+#include <QString>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+/**
+ * Extracting a preview from a RAW file is expensive, especially when the
+ * embedded preview is too small and we have to fall back to demosaicing a
+ * half-size preview. This namespace keeps the extracted JPEG data in a
+ * bounded on-disk cache, so that the thumbnailer and the document loader do
+ * not extract the same preview twice.
+ *
+ * Entries are keyed by file path and are considered stale as soon as the
+ * modification time or the size of the RAW file changes.
+ */
+namespace RawPreviewCache
+{
+
+/**
+ * The minimum size of the smaller side of a preview to be considered good
+ * enough to be displayed in the view.
+ */
+const int MIN_PREVIEW_SIZE = 1000;
+
+struct Preview
+{
+    Preview()
+    : ratio(1)
+    {}
+
+    QByteArray data;
+    /// 1 for an embedded preview, 2 for a half-size preview
+    int ratio;
+};
+
+/**
+ * Returns the directory where previews are stored
+ */
+GWENVIEWLIB_EXPORT QString cacheDir();
+
+/**
+ * Sets the cache dir, useful for unit-testing
+ */
+GWENVIEWLIB_EXPORT void setCacheDir(const QString&);
+
+/**
+ * Returns true if @p fileName has an extension supported by KDcraw
+ */
+GWENVIEWLIB_EXPORT bool isRawFile(const QString& fileName);
+
+/**
+ * Returns the cached preview for @p filePath if there is one and it is not
+ * stale and its smaller side is at least @p minSize pixels.
+ */
+GWENVIEWLIB_EXPORT bool findPreview(const QString& filePath, int minSize, Preview* preview);
+
+/**
+ * Stores @p preview for @p filePath, evicting the least recently used
+ * entries if the cache grows over its maximum size.
+ */
+GWENVIEWLIB_EXPORT void storePreview(const QString& filePath, const Preview& preview);
+
+/**
+ * Returns a preview for the RAW file @p filePath whose smaller side is at
+ * least @p minSize pixels, extracting it if it is not in the cache yet.
+ *
+ * If the embedded preview is big enough for @p minSize but too small to be
+ * displayed in the view, it is returned immediately and a half-size preview
+ * is generated on a low-priority worker thread so that the next document
+ * load finds it in the cache. Only the most recent of these requests are
+ * kept, and they are dropped when the application quits.
+ *
+ * This method is thread-safe and blocks while the preview is being
+ * extracted. It should never be called from the GUI thread.
+ */
+GWENVIEWLIB_EXPORT bool loadPreview(const QString& filePath, int minSize, Preview* preview);
+
+} // namespace
+
+} // namespace
+
+#endif /* RAWPREVIEWCACHE_H */
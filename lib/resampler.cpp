@@ -0,0 +1,334 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "resampler.h"
+
+#include <algorithm>
+
+// Qt
+#include <QDebug>
+#include <QPixelFormat>
+#include <QVector>
+#include <QtMath>
+
+// KDE
+
+// Local
+#include "tracing.h"
+#include "workerpool.h"
+
+namespace Gwenview
+{
+
+namespace Resampler
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+/**
+ * A pass is not split in strips of less pixels than this: starting the
+ * strips would cost more than it saves
+ */
+static const int MIN_PIXELS_PER_STRIP = 128 * 1024;
+
+static qreal boxKernel(qreal x)
+{
+    return (x >= -0.5 && x < 0.5) ? 1 : 0;
+}
+
+static qreal bilinearKernel(qreal x)
+{
+    x = qAbs(x);
+    return x < 1 ? 1 - x : 0;
+}
+
+static qreal mitchellKernel(qreal x)
+{
+    // Mitchell-Netravali, with the B = C = 1/3 recommended by the authors
+    const qreal B = 1. / 3;
+    const qreal C = 1. / 3;
+    x = qAbs(x);
+    if (x < 1) {
+        return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6;
+    }
+    if (x < 2) {
+        return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6;
+    }
+    return 0;
+}
+
+static qreal sinc(qreal x)
+{
+    if (x == 0) {
+        return 1;
+    }
+    x *= M_PI;
+    return qSin(x) / x;
+}
+
+static qreal lanczos3Kernel(qreal x)
+{
+    return (x > -3 && x < 3) ? sinc(x) * sinc(x / 3) : 0;
+}
+
+struct FilterInfo
+{
+    qreal (*kernel)(qreal);
+    qreal support;
+};
+
+static FilterInfo filterInfo(Filter filter)
+{
+    switch (filter) {
+    case Box:
+        return {boxKernel, 0.5};
+    case Bilinear:
+        return {bilinearKernel, 1};
+    case Mitchell:
+        return {mitchellKernel, 2};
+    case Lanczos3:
+        break;
+    }
+    return {lanczos3Kernel, 3};
+}
+
+/**
+ * For each destination pixel of a row or a column, the range of source
+ * pixels it depends on and their normalized weights
+ */
+struct Contributions
+{
+    QVector<int> mFirst;
+    QVector<int> mCount;
+    // mMaxCount weights per destination pixel
+    QVector<float> mWeights;
+    int mMaxCount;
+
+    const float* weights(int idx) const
+    {
+        return mWeights.constData() + idx * mMaxCount;
+    }
+};
+
+static Contributions computeContributions(int srcSize, int dstSize, Filter filter)
+{
+    const FilterInfo info = filterInfo(filter);
+    const qreal scale = qreal(srcSize) / dstSize;
+    // Stretch the filter when down scaling, so that all source pixels
+    // contribute to the result
+    const qreal filterScale = qMax(scale, qreal(1));
+    const qreal support = info.support * filterScale;
+
+    Contributions contribs;
+    contribs.mMaxCount = int(qCeil(support * 2)) + 2;
+    contribs.mFirst.resize(dstSize);
+    contribs.mCount.resize(dstSize);
+    contribs.mWeights.fill(0, dstSize * contribs.mMaxCount);
+
+    for (int idx = 0; idx < dstSize; ++idx) {
+        const qreal center = (idx + 0.5) * scale;
+        const int first = qBound(0, int(qFloor(center - support)), srcSize - 1);
+        const int last = qBound(first + 1, int(qCeil(center + support)), srcSize);
+        float* weights = contribs.mWeights.data() + idx * contribs.mMaxCount;
+        qreal total = 0;
+        int count = 0;
+        for (int pos = first; pos < last && count < contribs.mMaxCount; ++pos, ++count) {
+            const qreal weight = info.kernel((pos + 0.5 - center) / filterScale);
+            weights[count] = weight;
+            total += weight;
+        }
+        if (total != 0) {
+            for (int k = 0; k < count; ++k) {
+                weights[k] /= total;
+            }
+        } else {
+            weights[0] = 1;
+        }
+        contribs.mFirst[idx] = first;
+        contribs.mCount[idx] = count;
+    }
+    return contribs;
+}
+
+static inline uchar clampToByte(float value)
+{
+    return uchar(qBound(0, int(value + 0.5f), 255));
+}
+
+/**
+ * Horizontal pass: resamples rows [startY, endY[ of the destination, row y
+ * being computed from row firstRow + y of @p src
+ */
+template <int Channels>
+static void resampleRows(const QImage& src, uchar* dstBits, int dstStride, int dstWidth, const Contributions& contribs, int firstRow, int startY, int endY)
+{
+    for (int y = startY; y < endY; ++y) {
+        const uchar* srcLine = src.constScanLine(firstRow + y);
+        uchar* dstLine = dstBits + qptrdiff(y) * dstStride;
+        for (int x = 0; x < dstWidth; ++x) {
+            const uchar* srcPixel = srcLine + contribs.mFirst[x] * Channels;
+            const float* weights = contribs.weights(x);
+            const int count = contribs.mCount[x];
+            float sum[Channels] = {};
+            for (int k = 0; k < count; ++k) {
+                for (int c = 0; c < Channels; ++c) {
+                    sum[c] += srcPixel[k * Channels + c] * weights[k];
+                }
+            }
+            for (int c = 0; c < Channels; ++c) {
+                dstLine[x * Channels + c] = clampToByte(sum[c]);
+            }
+        }
+    }
+}
+
+/**
+ * Vertical pass: resamples rows [startY, endY[ of the destination. Whole
+ * source rows are accumulated, so that memory is read sequentially and the
+ * inner loop can be vectorized by the compiler.
+ */
+static void resampleColumns(const QImage& src, uchar* dstBits, int dstStride, int dstWidth, QImage::Format format, const Contributions& contribs, int firstRow, int startY, int endY)
+{
+    const bool premultiplied = format == QImage::Format_ARGB32_Premultiplied;
+    const bool opaque = format == QImage::Format_RGB32;
+    const int rowBytes = format == QImage::Format_Grayscale8 ? dstWidth : dstWidth * 4;
+    QVector<float> sumVector(rowBytes);
+    float* sum = sumVector.data();
+    for (int y = startY; y < endY; ++y) {
+        std::fill(sum, sum + rowBytes, 0.f);
+        const float* weights = contribs.weights(y);
+        const int first = contribs.mFirst[y] - firstRow;
+        const int count = contribs.mCount[y];
+        for (int k = 0; k < count; ++k) {
+            const uchar* srcLine = src.constScanLine(first + k);
+            const float weight = weights[k];
+            for (int i = 0; i < rowBytes; ++i) {
+                sum[i] += srcLine[i] * weight;
+            }
+        }
+
+        uchar* dstLine = dstBits + qptrdiff(y) * dstStride;
+        for (int i = 0; i < rowBytes; ++i) {
+            dstLine[i] = clampToByte(sum[i]);
+        }
+        if (premultiplied) {
+            // Negative lobes can produce colors brighter than the alpha
+            QRgb* pixels = reinterpret_cast<QRgb*>(dstLine);
+            for (int x = 0; x < dstWidth; ++x) {
+                const QRgb pixel = pixels[x];
+                const int alpha = qAlpha(pixel);
+                pixels[x] = qRgba(qMin(qRed(pixel), alpha), qMin(qGreen(pixel), alpha), qMin(qBlue(pixel), alpha), alpha);
+            }
+        } else if (opaque) {
+            QRgb* pixels = reinterpret_cast<QRgb*>(dstLine);
+            for (int x = 0; x < dstWidth; ++x) {
+                pixels[x] |= 0xff000000;
+            }
+        }
+    }
+}
+
+static bool hasDeepChannels(const QImage& image)
+{
+    const QPixelFormat format = image.pixelFormat();
+    return format.redSize() > 8 || format.greenSize() > 8 || format.blueSize() > 8 || format.alphaSize() > 8;
+}
+
+QImage scaled(const QImage& image, const QSize& size, Filter filter, WorkerLane::Enum lane)
+{
+    if (image.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+    if (size == image.size()) {
+        return image;
+    }
+
+    QImage src;
+    switch (image.format()) {
+    case QImage::Format_Grayscale8:
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        src = image;
+        break;
+    default:
+        if (hasDeepChannels(image)) {
+            LOG("Keeping the depth of" << image.format());
+            return image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+        if (image.format() == QImage::Format_Indexed8 && image.isGrayscale()) {
+            src = image.convertToFormat(QImage::Format_Grayscale8);
+        } else {
+            src = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+        }
+        break;
+    }
+
+    TraceSpan span("resample");
+    const bool grayscale = src.format() == QImage::Format_Grayscale8;
+    const Contributions horizontal = computeContributions(src.width(), size.width(), filter);
+    const Contributions vertical = computeContributions(src.height(), size.height(), filter);
+
+    // Only resample the rows used by the vertical pass
+    const int firstRow = vertical.mFirst.first();
+    const int lastRow = vertical.mFirst.last() + vertical.mCount.last();
+    QImage tmp(size.width(), lastRow - firstRow, src.format());
+    QImage dst(size, src.format());
+    if (tmp.isNull() || dst.isNull()) {
+        qWarning() << "Could not allocate images to scale to" << size;
+        return QImage();
+    }
+
+    // Get the pointers before starting the strips: QImage::scanLine() is
+    // not meant to be called from several threads
+    uchar* tmpBits = tmp.bits();
+    uchar* dstBits = dst.bits();
+    const int tmpStride = tmp.bytesPerLine();
+    const int dstStride = dst.bytesPerLine();
+    const int width = size.width();
+    const QImage::Format format = src.format();
+
+    const int minRowsPerStrip = qMax(1, MIN_PIXELS_PER_STRIP / width);
+    WorkerPool::runInRanges(lane, tmp.height(), minRowsPerStrip, [&](int start, int end) {
+        if (grayscale) {
+            resampleRows<1>(src, tmpBits, tmpStride, width, horizontal, firstRow, start, end);
+        } else {
+            resampleRows<4>(src, tmpBits, tmpStride, width, horizontal, firstRow, start, end);
+        }
+    });
+    WorkerPool::runInRanges(lane, size.height(), minRowsPerStrip, [&](int start, int end) {
+        resampleColumns(tmp, dstBits, dstStride, width, format, vertical, firstRow, start, end);
+    });
+
+    dst.setDotsPerMeterX(image.dotsPerMeterX());
+    dst.setDotsPerMeterY(image.dotsPerMeterY());
+    return dst;
+}
+
+} // namespace
+
+} // namespace
@@ -0,0 +1,74 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QImage>
+#include <QSize>
+
+// KDE
+
+// Local
+#include <lib/workerlane.h>
+
+namespace Gwenview
+{
+
+/**
+ * High quality image scaling. Scaling is separable: rows are resampled
+ * first, then columns. Each pass is split into strips of rows which are
+ * resampled in parallel, and the column pass accumulates whole source rows
+ * so that memory is always read sequentially.
+ *
+ * Unlike QImage::scaled(), the filter is stretched when down scaling, so
+ * large reductions do not alias.
+ */
+namespace Resampler
+{
+
+enum Filter {
+    Box,      ///< Averages the pixels, sharpest for integer down scaling
+    Bilinear, ///< Same quality as QImage::scaled() for small factors
+    Mitchell, ///< Smooth, almost no ringing
+    Lanczos3  ///< Sharpest, may add slight halos around edges
+};
+
+/**
+ * Returns @p image scaled to @p size, without keeping the aspect ratio.
+ *
+ * Grayscale8, RGB32 and ARGB32_Premultiplied images are resampled
+ * directly, other formats with up to 8 bits per channel are converted to
+ * one of them first. Images with more than 8 bits per channel are scaled
+ * with QImage::scaled() to preserve their depth.
+ *
+ * Strips are run on the threads of @p lane. It is safe to call this from a
+ * thread of @p lane.
+ */
+GWENVIEWLIB_EXPORT QImage scaled(const QImage& image, const QSize& size, Filter filter, WorkerLane::Enum lane = WorkerLane::Interactive);
+
+} // namespace
+
+} // namespace
+
+#endif /* RESAMPLER_H */
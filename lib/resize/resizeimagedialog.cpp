@@ -69,6 +69,11 @@ ResizeImageDialog::ResizeImageDialog(QWidget* parent)
     setWindowTitle(content->windowTitle());
     d->mWidthSpinBox->setFocus();
 
+    d->mFilterComboBox->addItem(i18nc("@item:inlistbox resize quality", "Sharpest (Lanczos)"), Resampler::Lanczos3);
+    d->mFilterComboBox->addItem(i18nc("@item:inlistbox resize quality", "Smooth (Mitchell)"), Resampler::Mitchell);
+    d->mFilterComboBox->addItem(i18nc("@item:inlistbox resize quality", "Bilinear"), Resampler::Bilinear);
+    d->mFilterComboBox->addItem(i18nc("@item:inlistbox resize quality", "Pixel average (Box)"), Resampler::Box);
+
     connect(d->mWidthSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &ResizeImageDialog::slotWidthChanged);
     connect(d->mHeightSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &ResizeImageDialog::slotHeightChanged);
     connect(d->mWidthPercentSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &ResizeImageDialog::slotWidthPercentChanged);
@@ -98,6 +103,11 @@ QSize ResizeImageDialog::size() const
            );
 }
 
+Resampler::Filter ResizeImageDialog::filter() const
+{
+    return Resampler::Filter(d->mFilterComboBox->currentData().toInt());
+}
+
 void ResizeImageDialog::slotWidthChanged(int width)
 {
     // Update width percentage to match width, only if this was a manual adjustment
@@ -39,14 +39,16 @@ namespace Gwenview
 struct ResizeImageOperationPrivate
 {
     QSize mSize;
+    Resampler::Filter mFilter;
     QImage mOriginalImage;
 };
 
 class ResizeJob : public ThreadedDocumentJob
 {
 public:
-    ResizeJob(const QSize& size)
+    ResizeJob(const QSize& size, Resampler::Filter filter)
         : mSize(size)
+        , mFilter(filter)
     {}
 
     void threadedStart() override
@@ -55,19 +57,26 @@ public:
             return;
         }
         QImage image = document()->image();
-        image = image.scaled(mSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        image = Resampler::scaled(image, mSize, mFilter, document()->workerLane());
+        if (image.isNull()) {
+            setError(UserDefinedError + 1);
+            setErrorText(i18nc("@info", "Not enough memory to resize the image."));
+            return;
+        }
         document()->editor()->setImage(image);
         setError(NoError);
     }
 
 private:
     QSize mSize;
+    Resampler::Filter mFilter;
 };
 
-ResizeImageOperation::ResizeImageOperation(const QSize& size)
+ResizeImageOperation::ResizeImageOperation(const QSize& size, Resampler::Filter filter)
 : d(new ResizeImageOperationPrivate)
 {
     d->mSize = size;
+    d->mFilter = filter;
     setText(i18nc("(qtundo-format)", "Resize"));
 }
 
@@ -79,7 +88,7 @@ ResizeImageOperation::~ResizeImageOperation()
 void ResizeImageOperation::redo()
 {
     d->mOriginalImage = document()->image();
-    redoAsDocumentJob(new ResizeJob(d->mSize));
+    redoAsDocumentJob(new ResizeJob(d->mSize, d->mFilter));
 }
 
 void ResizeImageOperation::undo()
@@ -29,6 +29,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 
 // Local
 #include <lib/abstractimageoperation.h>
+#include <lib/resampler.h>
 
 namespace Gwenview
 {
@@ -37,7 +38,7 @@ struct ResizeImageOperationPrivate;
 class GWENVIEWLIB_EXPORT ResizeImageOperation : public AbstractImageOperation
 {
 public:
-    ResizeImageOperation(const QSize& size);
+    ResizeImageOperation(const QSize& size, Resampler::Filter filter = Resampler::Lanczos3);
     ~ResizeImageOperation() override;
 
     void redo() override;
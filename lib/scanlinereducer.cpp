@@ -0,0 +1,137 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "scanlinereducer.h"
+
+// Qt
+#include <QDebug>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+ScanlineReducer::ScanlineReducer(const QSize& sourceSize, const QSize& destinationSize, QImage::Format format)
+: mSourceSize(sourceSize)
+, mImage(destinationSize, format)
+, mSourceY(0)
+, mDestinationY(0)
+, mAccumulatedRowCount(0)
+{
+    Q_ASSERT(format == QImage::Format_RGB32 || format == QImage::Format_ARGB32 || format == QImage::Format_Grayscale8);
+    Q_ASSERT(!sourceSize.isEmpty() && !destinationSize.isEmpty());
+    Q_ASSERT(destinationSize.width() <= sourceSize.width() && destinationSize.height() <= sourceSize.height());
+    mImage.fill(0);
+    // ARGB32 pixels are weighted by their alpha, so that the color of
+    // transparent pixels does not bleed into their neighbours
+    mChannelCount = format == QImage::Format_Grayscale8 ? 1 : 4;
+
+    const int destinationWidth = destinationSize.width();
+    mColumnMap.resize(sourceSize.width());
+    mColumnWeights.fill(0, destinationWidth);
+    for (int x = 0; x < sourceSize.width(); ++x) {
+        const int destinationX = qMin(int(qint64(x) * destinationWidth / sourceSize.width()), destinationWidth - 1);
+        mColumnMap[x] = destinationX;
+        ++mColumnWeights[destinationX];
+    }
+    mSums.fill(0, destinationWidth * mChannelCount);
+}
+
+int ScanlineReducer::destinationRowForSourceRow(int y) const
+{
+    return qMin(int(qint64(y) * mImage.height() / mSourceSize.height()), mImage.height() - 1);
+}
+
+void ScanlineReducer::addLine(const uchar* line)
+{
+    if (mSourceY >= mSourceSize.height()) {
+        qWarning() << "Too many lines added";
+        return;
+    }
+    const int destinationY = destinationRowForSourceRow(mSourceY);
+    if (destinationY != mDestinationY) {
+        flushRow();
+        mDestinationY = destinationY;
+    }
+
+    quint64* sums = mSums.data();
+    const int width = mSourceSize.width();
+    if (mImage.format() == QImage::Format_Grayscale8) {
+        for (int x = 0; x < width; ++x) {
+            sums[mColumnMap[x]] += line[x];
+        }
+    } else {
+        const bool hasAlpha = mImage.format() == QImage::Format_ARGB32;
+        const QRgb* pixels = reinterpret_cast<const QRgb*>(line);
+        for (int x = 0; x < width; ++x) {
+            const QRgb pixel = pixels[x];
+            const uint alpha = hasAlpha ? qAlpha(pixel) : 255;
+            quint64* sum = sums + mColumnMap[x] * 4;
+            sum[0] += qRed(pixel) * alpha;
+            sum[1] += qGreen(pixel) * alpha;
+            sum[2] += qBlue(pixel) * alpha;
+            sum[3] += alpha;
+        }
+    }
+    ++mAccumulatedRowCount;
+    ++mSourceY;
+    if (mSourceY == mSourceSize.height()) {
+        flushRow();
+    }
+}
+
+void ScanlineReducer::flushRow()
+{
+    if (mAccumulatedRowCount == 0) {
+        return;
+    }
+    uchar* line = mImage.scanLine(mDestinationY);
+    const int width = mImage.width();
+    const quint64* sums = mSums.constData();
+    if (mImage.format() == QImage::Format_Grayscale8) {
+        for (int x = 0; x < width; ++x) {
+            const quint64 count = quint64(mColumnWeights[x]) * mAccumulatedRowCount;
+            line[x] = count > 0 ? uchar(sums[x] / count) : 0;
+        }
+    } else {
+        QRgb* pixels = reinterpret_cast<QRgb*>(line);
+        for (int x = 0; x < width; ++x) {
+            const quint64* sum = sums + x * 4;
+            const quint64 count = quint64(mColumnWeights[x]) * mAccumulatedRowCount;
+            if (sum[3] == 0 || count == 0) {
+                pixels[x] = qRgba(0, 0, 0, 0);
+                continue;
+            }
+            pixels[x] = qRgba(sum[0] / sum[3], sum[1] / sum[3], sum[2] / sum[3], sum[3] / count);
+        }
+    }
+    mSums.fill(0);
+    mAccumulatedRowCount = 0;
+}
+
+QImage ScanlineReducer::image() const
+{
+    return mImage;
+}
+
+} // namespace
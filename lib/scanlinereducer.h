@@ -0,0 +1,88 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef SCANLINEREDUCER_H
+#define SCANLINEREDUCER_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QImage>
+#include <QSize>
+#include <QVector>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+/**
+ * Scales an image down while it is being decoded: rows of the source image
+ * are added one at a time, and accumulated into the rows of the destination
+ * image. Only the destination image and one row of sums are kept in memory,
+ * whatever the size of the source image.
+ *
+ * Pixels are averaged over the source box covered by each destination pixel.
+ */
+class GWENVIEWLIB_EXPORT ScanlineReducer
+{
+public:
+    /**
+     * @p format must be Format_RGB32, Format_ARGB32 or Format_Grayscale8.
+     * It is both the format of the lines passed to addLine() and the format
+     * of the result. @p destinationSize must not be bigger than
+     * @p sourceSize.
+     */
+    ScanlineReducer(const QSize& sourceSize, const QSize& destinationSize, QImage::Format format);
+
+    /**
+     * Adds the next row of the source image. @p line must contain
+     * sourceSize.width() pixels.
+     */
+    void addLine(const uchar* line);
+
+    /**
+     * Returns the destination image. Rows whose source rows have not all
+     * been added yet are black.
+     */
+    QImage image() const;
+
+private:
+    QSize mSourceSize;
+    QImage mImage;
+    int mChannelCount;
+    int mSourceY;
+    int mDestinationY;
+    int mAccumulatedRowCount;
+    // Index of the destination column of each source column
+    QVector<int> mColumnMap;
+    // Number of source columns of each destination column
+    QVector<int> mColumnWeights;
+    QVector<quint64> mSums;
+
+    int destinationRowForSourceRow(int y) const;
+    void flushRow();
+};
+
+} // namespace
+
+#endif /* SCANLINEREDUCER_H */
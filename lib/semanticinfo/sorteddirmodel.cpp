@@ -21,12 +21,17 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <config-gwenview.h>
 
 // Qt
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <QHash>
 #include <QTimer>
 #include <QDebug>
 #include <QUrl>
 
 // KDE
+#include <KConfigGroup>
 #include <KDirLister>
+#include <KSharedConfig>
 
 
 // Local
@@ -59,6 +64,36 @@ AbstractSortedDirModelFilter::~AbstractSortedDirModelFilter()
     }
 }
 
+/**
+ * What lessThan() needs to know about an item, computed once instead of for
+ * every comparison
+ */
+struct SortKey
+{
+    explicit SortKey(const QCollatorSortKey& nameKey)
+    : mNameKey(nameKey)
+    , mIsDir(false)
+    , mIsDirOrArchive(false)
+    , mIsHidden(false)
+    , mSize(0)
+    {}
+
+    /// Collation key of KFileItem::text()
+    QCollatorSortKey mNameKey;
+    bool mIsDir;
+    bool mIsDirOrArchive;
+    bool mIsHidden;
+    KIO::filesize_t mSize;
+    /// Computed on demand, since it may require reading the file
+    QDateTime mDateTime;
+};
+
+/**
+ * Keys are indexed by the internal pointer of source indexes, which KDirModel
+ * keeps for the lifetime of the item, whatever its row
+ */
+typedef QHash<const void*, SortKey*> SortKeyHash;
+
 struct SortedDirModelPrivate
 {
 #ifdef GWENVIEW_SEMANTICINFO_BACKEND_NONE
@@ -70,6 +105,56 @@ struct SortedDirModelPrivate
     QList<AbstractSortedDirModelFilter*> mFilters;
     QTimer mDelayedApplyFiltersTimer;
     MimeTypeUtils::Kinds mKindFilter;
+    QCollator mCollator;
+    // Same setting as KDirSortFilterProxyModel: without natural sorting,
+    // names are compared with QString::compare() and mCollator cannot be
+    // used
+    bool mNaturalSorting;
+    SortKeyHash mSortKeys;
+
+    ~SortedDirModelPrivate()
+    {
+        qDeleteAll(mSortKeys);
+    }
+
+    SortKey* sortKey(const QModelIndex& sourceIndex, Qt::CaseSensitivity caseSensitivity)
+    {
+        if (mCollator.caseSensitivity() != caseSensitivity) {
+            clearSortKeys();
+            mCollator.setCaseSensitivity(caseSensitivity);
+        }
+        SortKeyHash::ConstIterator it = mSortKeys.constFind(sourceIndex.internalPointer());
+        if (it != mSortKeys.constEnd()) {
+            return it.value();
+        }
+        const KFileItem item = mSourceModel->itemForIndex(sourceIndex);
+        SortKey* key = new SortKey(mCollator.sortKey(item.text()));
+        key->mIsDir = item.isDir();
+        key->mIsDirOrArchive = ArchiveUtils::fileItemIsDirOrArchive(item);
+        key->mIsHidden = item.isHidden();
+        key->mSize = item.size();
+        mSortKeys.insert(sourceIndex.internalPointer(), key);
+        return key;
+    }
+
+    void removeSortKeys(const QModelIndex& parent, int start, int end)
+    {
+        for (int row = start; row <= end; ++row) {
+            const QModelIndex index = mSourceModel->index(row, 0, parent);
+            if (mSourceModel->rowCount(index) > 0) {
+                // Children are removed with their parent without any signal
+                clearSortKeys();
+                return;
+            }
+            delete mSortKeys.take(index.internalPointer());
+        }
+    }
+
+    void clearSortKeys()
+    {
+        qDeleteAll(mSortKeys);
+        mSortKeys.clear();
+    }
 };
 
 SortedDirModel::SortedDirModel(QObject* parent)
@@ -85,6 +170,19 @@ SortedDirModel::SortedDirModel(QObject* parent)
     d->mDelayedApplyFiltersTimer.setInterval(0);
     d->mDelayedApplyFiltersTimer.setSingleShot(true);
     connect(&d->mDelayedApplyFiltersTimer, &QTimer::timeout, this, &SortedDirModel::doApplyFilters);
+
+    d->mNaturalSorting = KConfigGroup(KSharedConfig::openConfig(), "KDE").readEntry("NaturalSorting", true);
+    d->mCollator.setNumericMode(true);
+    d->mCollator.setCaseSensitivity(sortCaseSensitivity());
+    connect(d->mSourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this](const QModelIndex& parent, int start, int end) {
+        d->removeSortKeys(parent, start, end);
+    });
+    connect(d->mSourceModel, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+        d->removeSortKeys(topLeft.parent(), topLeft.row(), bottomRight.row());
+    });
+    connect(d->mSourceModel, &QAbstractItemModel::modelAboutToBeReset, this, [this]() {
+        d->clearSortKeys();
+    });
 }
 
 SortedDirModel::~SortedDirModel()
@@ -259,25 +357,26 @@ void SortedDirModel::doApplyFilters()
 
 bool SortedDirModel::lessThan(const QModelIndex& left, const QModelIndex& right) const
 {
-    const KFileItem leftItem = itemForSourceIndex(left);
-    const KFileItem rightItem = itemForSourceIndex(right);
+    SortKey* leftKey = d->sortKey(left, sortCaseSensitivity());
+    SortKey* rightKey = d->sortKey(right, sortCaseSensitivity());
 
-    const bool leftIsDirOrArchive = ArchiveUtils::fileItemIsDirOrArchive(leftItem);
-    const bool rightIsDirOrArchive = ArchiveUtils::fileItemIsDirOrArchive(rightItem);
-
-    if (leftIsDirOrArchive != rightIsDirOrArchive) {
-        return sortOrder() == Qt::AscendingOrder ? leftIsDirOrArchive : rightIsDirOrArchive;
+    if (leftKey->mIsDirOrArchive != rightKey->mIsDirOrArchive) {
+        return sortOrder() == Qt::AscendingOrder ? leftKey->mIsDirOrArchive : rightKey->mIsDirOrArchive;
     }
 
     // Apply special sort handling only to images. For folders/archives or when
     // a secondary criterion is needed, delegate sorting to the parent class.
-    if (!leftIsDirOrArchive) {
+    if (!leftKey->mIsDirOrArchive) {
         if (sortColumn() == KDirModel::ModifiedTime) {
-            const QDateTime leftDate = TimeUtils::dateTimeForFileItem(leftItem);
-            const QDateTime rightDate = TimeUtils::dateTimeForFileItem(rightItem);
+            if (!leftKey->mDateTime.isValid()) {
+                leftKey->mDateTime = TimeUtils::dateTimeForFileItem(itemForSourceIndex(left));
+            }
+            if (!rightKey->mDateTime.isValid()) {
+                rightKey->mDateTime = TimeUtils::dateTimeForFileItem(itemForSourceIndex(right));
+            }
 
-            if (leftDate != rightDate) {
-                return leftDate < rightDate;
+            if (leftKey->mDateTime != rightKey->mDateTime) {
+                return leftKey->mDateTime < rightKey->mDateTime;
             }
         }
 #ifndef GWENVIEW_SEMANTICINFO_BACKEND_NONE
@@ -292,6 +391,27 @@ bool SortedDirModel::lessThan(const QModelIndex& left, const QModelIndex& right)
 #endif
     }
 
+    // Fast paths for the common cases of KDirSortFilterProxyModel::lessThan(),
+    // which would compare the names with QCollator::compare() for every
+    // comparison. They must give the same order: everything else, including
+    // ties, goes through it.
+    if (leftKey->mIsDir == rightKey->mIsDir) {
+        // Hidden items go before visible ones
+        if (leftKey->mIsHidden != rightKey->mIsHidden) {
+            return sortOrder() == Qt::AscendingOrder ? leftKey->mIsHidden : rightKey->mIsHidden;
+        }
+        if (sortColumn() == KDirModel::Name && d->mNaturalSorting) {
+            const int result = leftKey->mNameKey.compare(rightKey->mNameKey);
+            if (result != 0) {
+                return result < 0;
+            }
+        } else if (sortColumn() == KDirModel::Size && !leftKey->mIsDir) {
+            if (leftKey->mSize != rightKey->mSize) {
+                return leftKey->mSize < rightKey->mSize;
+            }
+        }
+    }
+
     return KDirSortFilterProxyModel::lessThan(left, right);
 }
 
@@ -0,0 +1,270 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "snapshotdirlister.h"
+
+// Qt
+#include <QDebug>
+#include <QHash>
+#include <QTimer>
+
+// KDE
+#include <KCoreDirLister>
+
+// Local
+#include "dirsnapshot.h"
+#include "tracing.h"
+#include "workerpool.h"
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+typedef QHash<QUrl, KFileItem> ItemForUrl;
+
+struct SnapshotDirListerPrivate
+{
+    SnapshotDirLister* q;
+    /// Lists the same folder as q, only used to know when listing is done
+    KCoreDirLister* mReconcileLister;
+    /// Folder whose snapshot is shown, empty if we are not reconciling
+    QUrl mSnapshotUrl;
+    ItemForUrl mSnapshotItems;
+
+    bool isReconciling() const
+    {
+        return !mSnapshotUrl.isEmpty();
+    }
+
+    /**
+     * While reconciling, the signals of q are blocked. Those which do not
+     * report items are emitted with @p emitSignal, when mReconcileLister
+     * receives them from the shared listing job.
+     */
+    template <typename Function>
+    void forwardSignal(Function emitSignal)
+    {
+        if (!isReconciling()) {
+            return;
+        }
+        q->blockSignals(false);
+        emitSignal();
+        q->blockSignals(true);
+    }
+
+    void stopReconciling()
+    {
+        mReconcileLister->stop();
+        mSnapshotUrl.clear();
+        mSnapshotItems.clear();
+        q->blockSignals(false);
+    }
+
+    /**
+     * Replaces the content of the model with the items we really have. Used
+     * when the folder changed while it was being listed.
+     */
+    void resync()
+    {
+        LOG("Resyncing" << q->url());
+        emit q->clear();
+        if (q->url().isEmpty()) {
+            return;
+        }
+        const KFileItemList items = q->items();
+        if (!items.isEmpty()) {
+            emit q->itemsAdded(q->url(), items);
+            emit q->newItems(items);
+        }
+        if (q->isFinished()) {
+            emit q->completed(q->url());
+            emit q->completed();
+        }
+    }
+};
+
+SnapshotDirLister::SnapshotDirLister(QObject* parent)
+: KDirLister(parent)
+, d(new SnapshotDirListerPrivate)
+{
+    d->q = this;
+    d->mReconcileLister = new KCoreDirLister(this);
+    d->mReconcileLister->setAutoUpdate(false);
+    connect(d->mReconcileLister, QOverload<>::of(&KCoreDirLister::completed), this, &SnapshotDirLister::scheduleReconcile);
+    connect(d->mReconcileLister, QOverload<>::of(&KCoreDirLister::canceled), this, &SnapshotDirLister::scheduleReconcile);
+    connect(d->mReconcileLister, QOverload<const QUrl&, const QUrl&>::of(&KCoreDirLister::redirection), this, &SnapshotDirLister::scheduleReconcile);
+
+    // Item signals of this lister are blocked while reconciling, but the
+    // model and the UI need the others, KDirModel updates its root on
+    // redirection() for example
+    connect(d->mReconcileLister, &KCoreDirLister::started, this, [this](const QUrl& url) {
+        d->forwardSignal([this, url]() { emit started(url); });
+    });
+    connect(d->mReconcileLister, QOverload<const QUrl&>::of(&KCoreDirLister::redirection), this, [this](const QUrl& url) {
+        d->forwardSignal([this, url]() { emit redirection(url); });
+    });
+    connect(d->mReconcileLister, QOverload<const QUrl&, const QUrl&>::of(&KCoreDirLister::redirection), this, [this](const QUrl& oldUrl, const QUrl& newUrl) {
+        d->forwardSignal([this, oldUrl, newUrl]() { emit redirection(oldUrl, newUrl); });
+    });
+    connect(d->mReconcileLister, &KCoreDirLister::infoMessage, this, [this](const QString& message) {
+        d->forwardSignal([this, message]() { emit infoMessage(message); });
+    });
+    connect(d->mReconcileLister, &KCoreDirLister::percent, this, [this](int percent) {
+        d->forwardSignal([this, percent]() { emit this->percent(percent); });
+    });
+    connect(d->mReconcileLister, &KCoreDirLister::totalSize, this, [this](KIO::filesize_t size) {
+        d->forwardSignal([this, size]() { emit totalSize(size); });
+    });
+    connect(d->mReconcileLister, &KCoreDirLister::processedSize, this, [this](KIO::filesize_t size) {
+        d->forwardSignal([this, size]() { emit processedSize(size); });
+    });
+    connect(d->mReconcileLister, &KCoreDirLister::speed, this, [this](int bytesPerSecond) {
+        d->forwardSignal([this, bytesPerSecond]() { emit speed(bytesPerSecond); });
+    });
+
+    connect(this, QOverload<>::of(&KCoreDirLister::completed), this, &SnapshotDirLister::storeSnapshot);
+}
+
+SnapshotDirLister::~SnapshotDirLister()
+{
+    blockSignals(false);
+    delete d;
+}
+
+bool SnapshotDirLister::openUrl(const QUrl& url, OpenUrlFlags flags)
+{
+    if (d->isReconciling()) {
+        d->stopReconciling();
+    } else if (!(flags & Keep) && !this->url().isEmpty() && isFinished()) {
+        // Store the folder we are leaving, it may know more dates than when
+        // it was stored
+        storeSnapshot();
+    }
+    if (flags & (Keep | Reload)) {
+        return KDirLister::openUrl(url, flags);
+    }
+
+    const KFileItemList snapshotItems = DirSnapshot::load(url);
+    if (!KDirLister::openUrl(url, flags)) {
+        return false;
+    }
+    if (snapshotItems.isEmpty()) {
+        return true;
+    }
+
+    // KDirLister::openUrl() has emitted clear() and started listing. Show the
+    // snapshot, then hide what KIO reports until the listing is done.
+    TraceSpan span("showDirSnapshot", url);
+    LOG("Showing" << snapshotItems.count() << "items from snapshot of" << url);
+    emit itemsAdded(this->url(), snapshotItems);
+    emit newItems(snapshotItems);
+
+    d->mSnapshotUrl = this->url();
+    d->mSnapshotItems.reserve(snapshotItems.count());
+    for (const KFileItem& item : snapshotItems) {
+        d->mSnapshotItems.insert(item.url(), item);
+    }
+    blockSignals(true);
+    d->mReconcileLister->openUrl(url);
+    return true;
+}
+
+void SnapshotDirLister::scheduleReconcile()
+{
+    // Let KIO finish notifying this lister before looking at its items
+    QTimer::singleShot(0, this, &SnapshotDirLister::reconcile);
+}
+
+void SnapshotDirLister::reconcile()
+{
+    if (!d->isReconciling()) {
+        return;
+    }
+    TraceSpan span("reconcileDirSnapshot", d->mSnapshotUrl);
+    const QUrl snapshotUrl = d->mSnapshotUrl;
+    ItemForUrl snapshotItems = d->mSnapshotItems;
+    d->stopReconciling();
+
+    if (url().adjusted(QUrl::StripTrailingSlash) != snapshotUrl.adjusted(QUrl::StripTrailingSlash)) {
+        // Redirected or cleared while listing
+        d->resync();
+        return;
+    }
+
+    KFileItemList addedItems;
+    QList<QPair<KFileItem, KFileItem> > refreshedItems;
+    const KFileItemList liveItems = items();
+    for (const KFileItem& item : liveItems) {
+        ItemForUrl::Iterator it = snapshotItems.find(item.url());
+        if (it == snapshotItems.end()) {
+            addedItems << item;
+            continue;
+        }
+        if (!it.value().cmp(item)) {
+            refreshedItems << qMakePair(it.value(), item);
+        }
+        snapshotItems.erase(it);
+    }
+    const KFileItemList deletedItems = snapshotItems.values();
+    LOG("added:" << addedItems.count() << "refreshed:" << refreshedItems.count() << "deleted:" << deletedItems.count());
+
+    if (!deletedItems.isEmpty()) {
+        emit itemsDeleted(deletedItems);
+    }
+    if (!refreshedItems.isEmpty()) {
+        emit refreshItems(refreshedItems);
+    }
+    if (!addedItems.isEmpty()) {
+        emit itemsAdded(url(), addedItems);
+        emit newItems(addedItems);
+    }
+    if (isFinished()) {
+        emit completed(url());
+        emit completed();
+    }
+}
+
+void SnapshotDirLister::storeSnapshot()
+{
+    const QUrl dirUrl = url();
+    if (dirUrl.isEmpty()) {
+        return;
+    }
+    const KFileItemList list = items();
+    if (list.count() < DirSnapshot::MIN_ITEM_COUNT) {
+        DirSnapshot::remove(dirUrl);
+        return;
+    }
+    const DirSnapshot::EntryList entries = DirSnapshot::entriesForItems(list);
+    WorkerPool::run(WorkerLane::Background, [dirUrl, entries]() {
+        DirSnapshot::store(dirUrl, entries);
+    });
+}
+
+} // namespace
@@ -0,0 +1,70 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef SNAPSHOTDIRLISTER_H
+#define SNAPSHOTDIRLISTER_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+
+// KDE
+#include <KDirLister>
+
+// Local
+
+namespace Gwenview
+{
+
+struct SnapshotDirListerPrivate;
+
+/**
+ * A KDirLister which shows the DirSnapshot of a folder as soon as it is
+ * opened, then reconciles it with the real content of the folder once it has
+ * been listed: only the items which have been added, removed or modified
+ * since the snapshot was taken are reported to the model, so the view does
+ * not lose its selection or its thumbnails.
+ *
+ * While the folder is being listed, the signals emitted by KIO on this lister
+ * are blocked, and a second lister sharing the same listing job tells us when
+ * it is done. The signals which do not report items, such as redirection()
+ * or percent(), are forwarded from the second lister.
+ */
+class GWENVIEWLIB_EXPORT SnapshotDirLister : public KDirLister
+{
+    Q_OBJECT
+public:
+    explicit SnapshotDirLister(QObject* parent = nullptr);
+    ~SnapshotDirLister() override;
+
+    bool openUrl(const QUrl& url, OpenUrlFlags flags = NoFlags) override;
+
+private Q_SLOTS:
+    void scheduleReconcile();
+    void reconcile();
+    void storeSnapshot();
+
+private:
+    SnapshotDirListerPrivate* const d;
+};
+
+} // namespace
+
+#endif /* SNAPSHOTDIRLISTER_H */
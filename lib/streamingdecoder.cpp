@@ -0,0 +1,385 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "streamingdecoder.h"
+#include <config-gwenview.h>
+
+// STL
+#include <cmath>
+#include <limits>
+
+// Qt
+#include <QDebug>
+#include <QIODevice>
+#include <QVector>
+
+// KDE
+
+// Local
+#include "scanlinereducer.h"
+#include "tracing.h"
+
+// libpng
+#include <png.h>
+
+#ifdef HAVE_FITS
+// cfitsio
+#include <fitsio.h>
+#endif
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+namespace StreamingDecoder
+{
+
+static void readPngData(png_structp pngPtr, png_bytep data, png_size_t length)
+{
+    QIODevice* device = static_cast<QIODevice*>(png_get_io_ptr(pngPtr));
+    while (length) {
+        const qint64 count = device->read(reinterpret_cast<char*>(data), length);
+        if (count <= 0) {
+            png_error(pngPtr, "Read error");
+            return;
+        }
+        data += count;
+        length -= count;
+    }
+}
+
+static void warnPng(png_structp /*pngPtr*/, png_const_charp message)
+{
+    LOG("libpng warning:" << message);
+    Q_UNUSED(message);
+}
+
+static QImage readScaledPng(QIODevice* device, const QSize& requestedSize)
+{
+    png_structp pngPtr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, warnPng);
+    if (!pngPtr) {
+        return QImage();
+    }
+    png_infop infoPtr = png_create_info_struct(pngPtr);
+    if (!infoPtr) {
+        png_destroy_read_struct(&pngPtr, nullptr, nullptr);
+        return QImage();
+    }
+
+    // Volatile because they are modified after setjmp() and used when
+    // libpng fails
+    ScanlineReducer* volatile reducer = nullptr;
+    volatile png_bytep row = nullptr;
+    if (setjmp(png_jmpbuf(pngPtr))) {
+        LOG("Error decoding png data");
+        delete reducer;
+        png_free(pngPtr, row);
+        png_destroy_read_struct(&pngPtr, &infoPtr, nullptr);
+        return QImage();
+    }
+
+    png_set_read_fn(pngPtr, device, readPngData);
+    png_read_info(pngPtr, infoPtr);
+
+    const QSize sourceSize(png_get_image_width(pngPtr, infoPtr), png_get_image_height(pngPtr, infoPtr));
+    const int colorType = png_get_color_type(pngPtr, infoPtr);
+    // All passes of interlaced images are needed before any row is
+    // complete
+    if (png_get_interlace_type(pngPtr, infoPtr) != PNG_INTERLACE_NONE
+            || requestedSize.width() >= sourceSize.width()
+            || requestedSize.height() >= sourceSize.height()) {
+        png_destroy_read_struct(&pngPtr, &infoPtr, nullptr);
+        return QImage();
+    }
+
+    // Decode everything as 8 bit gray, or 8 bit RGBA
+    const bool hasAlpha = (colorType & PNG_COLOR_MASK_ALPHA) || png_get_valid(pngPtr, infoPtr, PNG_INFO_tRNS);
+    const bool grayscale = colorType == PNG_COLOR_TYPE_GRAY && !hasAlpha;
+    png_set_expand(pngPtr);
+    png_set_strip_16(pngPtr);
+    if (!grayscale) {
+        png_set_gray_to_rgb(pngPtr);
+        png_set_add_alpha(pngPtr, 0xff, PNG_FILLER_AFTER);
+    }
+    png_read_update_info(pngPtr, infoPtr);
+
+    const QImage::Format format = grayscale
+        ? QImage::Format_Grayscale8
+        : hasAlpha ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+    reducer = new ScanlineReducer(sourceSize, requestedSize, format);
+    row = static_cast<png_bytep>(png_malloc(pngPtr, png_get_rowbytes(pngPtr, infoPtr)));
+
+    for (int y = 0; y < sourceSize.height(); ++y) {
+        png_read_row(pngPtr, row, nullptr);
+        if (!grayscale) {
+            // Convert RGBA bytes to QRgb in place
+            png_bytep pixel = row;
+            for (int x = 0; x < sourceSize.width(); ++x, pixel += 4) {
+                *reinterpret_cast<QRgb*>(pixel) = qRgba(pixel[0], pixel[1], pixel[2], pixel[3]);
+            }
+        }
+        reducer->addLine(row);
+    }
+
+    const QImage image = reducer->image();
+    delete reducer;
+    png_free(pngPtr, row);
+    // Do not read the end of the file: the text chunks it may contain are
+    // not needed
+    png_destroy_read_struct(&pngPtr, &infoPtr, nullptr);
+    return image;
+}
+
+#ifdef HAVE_FITS
+struct FitsImage
+{
+    fitsfile* mFile;
+    int mDataType;
+    int mWidth;
+    int mHeight;
+
+    FitsImage()
+    : mFile(nullptr)
+    , mDataType(0)
+    , mWidth(0)
+    , mHeight(0)
+    {}
+
+    ~FitsImage()
+    {
+        int status = 0;
+        if (mFile) {
+            fits_close_file(mFile, &status);
+        }
+    }
+
+    template <typename T>
+    bool readRow(int channel, int y, T* row) const
+    {
+        int status = 0;
+        int anyNull = 0;
+        const LONGLONG first = (LONGLONG(channel) * mHeight + y) * mWidth + 1;
+        return fits_read_img(mFile, mDataType, first, mWidth, nullptr, row, &anyNull, &status) == 0;
+    }
+};
+
+/**
+ * Decodes the pixels of @p fits with the automatic stretch of
+ * FITSData::FITSToImage(). The image is read twice, one row at a time: once
+ * to compute the statistics of its first channel, then to convert it.
+ */
+template <typename T>
+static QImage readScaledFitsPixels(const FitsImage& fits, int channelCount, const QSize& requestedSize)
+{
+    QVector<T> row(fits.mWidth);
+
+    // Same statistics as FITSData::calculateMinMax() and
+    // FITSData::runningAverageStdDev()
+    double min = 1.0E30;
+    double max = -1.0E30;
+    int status = 0;
+    const bool hasMinMaxKeys = fits_read_key_dbl(fits.mFile, "DATAMIN", &min, nullptr, &status) == 0
+        && fits_read_key_dbl(fits.mFile, "DATAMAX", &max, nullptr, &status) == 0
+        && !(min == 0 && max == 0);
+    if (!hasMinMaxKeys) {
+        min = 1.0E30;
+        max = -1.0E30;
+    }
+    int n = 2;
+    double oldM = 0, newM = 0, oldS = 0, newS = 0;
+    for (int y = 0; y < fits.mHeight; ++y) {
+        if (!fits.readRow(0, y, row.data())) {
+            return QImage();
+        }
+        for (int x = 0; x < fits.mWidth; ++x) {
+            const T value = row[x];
+            if (!hasMinMaxKeys) {
+                if (value < min) {
+                    min = value;
+                } else if (value > max) {
+                    max = value;
+                }
+            }
+            if (y == 0 && x == 0) {
+                oldM = newM = value;
+                continue;
+            }
+            newM = oldM + (value - oldM) / n;
+            newS = oldS + (value - oldM) * (value - newM);
+            oldM = newM;
+            oldS = newS;
+            ++n;
+        }
+    }
+    const double mean = newM;
+    const double stddev = std::sqrt(n == 2 ? 0 : newS / (n - 2));
+    const double dataMin = mean - stddev;
+    const double dataMax = mean + stddev * 3;
+    if (min == max || !(dataMax > dataMin)) {
+        // Let FITSData handle these degenerate images
+        return QImage();
+    }
+    const double scale = 255. / (dataMax - dataMin);
+    const double zero = (-dataMin) * (255. / (dataMax - dataMin));
+    const T limit = std::numeric_limits<T>::max();
+    const T bMin = dataMin < 0 ? 0 : dataMin;
+    const T bMax = dataMax > limit ? limit : dataMax;
+
+    const QSize sourceSize(fits.mWidth, fits.mHeight);
+    if (channelCount == 1) {
+        ScanlineReducer reducer(sourceSize, requestedSize, QImage::Format_Grayscale8);
+        QVector<uchar> line(fits.mWidth);
+        for (int y = 0; y < fits.mHeight; ++y) {
+            if (!fits.readRow(0, y, row.data())) {
+                return QImage();
+            }
+            for (int x = 0; x < fits.mWidth; ++x) {
+                const double value = qBound(bMin, row[x], bMax) * scale + zero;
+                line[x] = qBound<unsigned char>(0, (unsigned char)value, 255);
+            }
+            reducer.addLine(line.constData());
+        }
+        return reducer.image();
+    }
+
+    ScanlineReducer reducer(sourceSize, requestedSize, QImage::Format_RGB32);
+    QVector<T> greenRow(fits.mWidth);
+    QVector<T> blueRow(fits.mWidth);
+    QVector<QRgb> line(fits.mWidth);
+    for (int y = 0; y < fits.mHeight; ++y) {
+        if (!fits.readRow(0, y, row.data()) || !fits.readRow(1, y, greenRow.data()) || !fits.readRow(2, y, blueRow.data())) {
+            return QImage();
+        }
+        for (int x = 0; x < fits.mWidth; ++x) {
+            const double red = qBound(bMin, row[x], bMax);
+            const double green = qBound(bMin, greenRow[x], bMax);
+            const double blue = qBound(bMin, blueRow[x], bMax);
+            line[x] = qRgb(red * scale + zero, green * scale + zero, blue * scale + zero);
+        }
+        reducer.addLine(reinterpret_cast<const uchar*>(line.constData()));
+    }
+    return reducer.image();
+}
+
+static QImage readScaledFits(QIODevice* device, const QSize& requestedSize)
+{
+    // cfitsio reads from memory, but the decoded pixels are never all
+    // in memory
+    QByteArray data = device->readAll();
+    void* dataPtr = data.data();
+    size_t dataSize = size_t(data.size());
+    FitsImage fits;
+    int status = 0;
+    if (fits_open_memfile(&fits.mFile, "", READONLY, &dataPtr, &dataSize, 0, nullptr, &status)) {
+        LOG("Could not open FITS data");
+        fits.mFile = nullptr;
+        return QImage();
+    }
+
+    int bitpix = 0;
+    int dimensionCount = 0;
+    long axes[3] = {0, 0, 1};
+    if (fits_get_img_param(fits.mFile, 3, &bitpix, &dimensionCount, axes, &status) || dimensionCount < 2) {
+        return QImage();
+    }
+    const int channelCount = dimensionCount < 3 ? 1 : int(axes[2]);
+    fits.mWidth = int(axes[0]);
+    fits.mHeight = int(axes[1]);
+    if ((channelCount != 1 && channelCount != 3)
+            || requestedSize.width() >= fits.mWidth
+            || requestedSize.height() >= fits.mHeight) {
+        return QImage();
+    }
+
+    // Bayer images must be demosaiced as a whole, leave them to FITSData
+    char bayerPattern[FLEN_VALUE];
+    int bayerStatus = 0;
+    if ((bitpix == BYTE_IMG || bitpix == USHORT_IMG || bitpix == SHORT_IMG)
+            && fits_read_keyword(fits.mFile, "BAYERPAT", bayerPattern, nullptr, &bayerStatus) == 0) {
+        return QImage();
+    }
+
+    // Read pixels with the same types as FITSData
+    switch (bitpix) {
+    case BYTE_IMG:
+        fits.mDataType = TBYTE;
+        return readScaledFitsPixels<uint8_t>(fits, channelCount, requestedSize);
+    case SHORT_IMG:
+    case USHORT_IMG:
+        fits.mDataType = TUSHORT;
+        return readScaledFitsPixels<uint16_t>(fits, channelCount, requestedSize);
+    case LONG_IMG:
+    case ULONG_IMG:
+        fits.mDataType = TUINT;
+        return readScaledFitsPixels<uint32_t>(fits, channelCount, requestedSize);
+    case FLOAT_IMG:
+        fits.mDataType = TFLOAT;
+        return readScaledFitsPixels<float>(fits, channelCount, requestedSize);
+    case LONGLONG_IMG:
+        fits.mDataType = TLONGLONG;
+        return readScaledFitsPixels<int64_t>(fits, channelCount, requestedSize);
+    case DOUBLE_IMG:
+        fits.mDataType = TDOUBLE;
+        return readScaledFitsPixels<double>(fits, channelCount, requestedSize);
+    default:
+        return QImage();
+    }
+}
+#endif
+
+bool canReadScaled(const QByteArray& format)
+{
+#ifdef HAVE_FITS
+    if (format == "fits") {
+        return true;
+    }
+#endif
+    return format == "png";
+}
+
+QImage readScaled(QIODevice* device, const QByteArray& format, const QSize& size)
+{
+    TraceSpan span("streamingDecode");
+    if (size.isEmpty()) {
+        return QImage();
+    }
+    if (format == "png") {
+        return readScaledPng(device, size);
+    }
+#ifdef HAVE_FITS
+    if (format == "fits") {
+        return readScaledFits(device, size);
+    }
+#endif
+    return QImage();
+}
+
+} // namespace
+
+} // namespace
@@ -0,0 +1,68 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef STREAMINGDECODER_H
+#define STREAMINGDECODER_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+
+// KDE
+
+// Local
+
+class QIODevice;
+
+namespace Gwenview
+{
+
+/**
+ * Decodes images row by row and scales them down with a ScanlineReducer as
+ * rows are decoded, so that memory usage is bounded by the size of the
+ * result instead of the size of the image. Useful for formats whose Qt
+ * plugin does not support QImageIOHandler::ScaledSize, or only scales the
+ * image once it is fully decoded.
+ */
+namespace StreamingDecoder
+{
+
+/**
+ * Returns true if readScaled() supports images of @p format
+ */
+GWENVIEWLIB_EXPORT bool canReadScaled(const QByteArray& format);
+
+/**
+ * Decodes the image read from @p device, scaled to @p size.
+ *
+ * Returns a null image if it cannot be done, for example for interlaced PNG
+ * images, FITS images with a Bayer pattern, or if @p size is not smaller
+ * than the image. The position of @p device is then undefined.
+ */
+GWENVIEWLIB_EXPORT QImage readScaled(QIODevice* device, const QByteArray& format, const QSize& size);
+
+} // namespace
+
+} // namespace
+
+#endif /* STREAMINGDECODER_H */
@@ -24,18 +24,20 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 // Local
 #include "imageutils.h"
 #include "jpegcontent.h"
+#include "multiresolutionreader.h"
 #include "gwenviewconfig.h"
 #include "exiv2imageloader.h"
+#include "imagehash.h"
+#include "imagehashindex.h"
+#include "rawpreviewcache.h"
+#include "streamingdecoder.h"
+#include "tracing.h"
 
 // KDE
 #include <QDebug>
-#ifdef KDCRAW_FOUND
-#include <kdcraw/kdcraw.h>
-#endif
 
 // Qt
 #include <QImageReader>
-#include <QMatrix>
 #include <QBuffer>
 
 namespace Gwenview
@@ -50,8 +52,6 @@ namespace Gwenview
 #define LOG(x) ;
 #endif
 
-const int MIN_PREV_SIZE = 1000;
-
 //------------------------------------------------------------------------
 //
 // ThumbnailContext
@@ -76,21 +76,16 @@ bool ThumbnailContext::load(const QString &pixPath, int pixelSize)
 
 #ifdef KDCRAW_FOUND
     // raw images deserve special treatment
-    if (KDcrawIface::KDcraw::rawFilesList().contains(QString::fromLatin1(formatHint))) {
-        // use KDCraw to extract the preview
-        bool ret = KDcrawIface::KDcraw::loadEmbeddedPreview(data, pixPath);
-
-        // We need QImage. Loading JpegContent from QImage - exif lost
-        // Loading QImage from JpegContent - unimplemented, would go with loadFromData
-        if (!ret || !originalImage.loadFromData(data) || qMin(originalImage.width(), originalImage.height()) < MIN_PREV_SIZE) {
-            // if the emebedded preview loading failed or gets just a small image, load
-            // half preview instead. That's slower...
-            if (!KDcrawIface::KDcraw::loadHalfPreview(data, pixPath)) {
-                qWarning() << "unable to get preview for " << pixPath.toUtf8().constData();
-                return false;
-            }
-            previewRatio = 2;
+    if (RawPreviewCache::isRawFile(pixPath)) {
+        // The preview is shared with the document loader through
+        // RawPreviewCache, so that it is extracted only once
+        RawPreviewCache::Preview preview;
+        if (!RawPreviewCache::loadPreview(pixPath, pixelSize, &preview)) {
+            qWarning() << "unable to get preview for " << pixPath.toUtf8().constData();
+            return false;
         }
+        data = preview.data;
+        previewRatio = preview.ratio;
 
         // And we need JpegContent too because of EXIF (orientation!).
         if (!content.loadFromData(data)) {
@@ -113,7 +108,9 @@ bool ThumbnailContext::load(const QString &pixPath, int pixelSize)
         }
 
         if (reader.format() == "jpeg" && GwenviewConfig::applyExifOrientation()) {
-            content.load(pixPath);
+            // Only the embedded thumbnail is needed, do not read the image
+            // data
+            content.loadHeader(pixPath);
         }
     }
 
@@ -126,11 +123,7 @@ bool ThumbnailContext::load(const QString &pixPath, int pixelSize)
         orientation = content.orientation();
 
         if (qMax(thumbnail.width(), thumbnail.height()) >= pixelSize) {
-            mImage = thumbnail;
-            if (orientation != NORMAL && orientation != NOT_AVAILABLE) {
-                QMatrix matrix = ImageUtils::transformMatrix(orientation);
-                mImage = mImage.transformed(matrix);
-            }
+            mImage = ImageUtils::transformed(thumbnail, orientation, WorkerLane::Background);
             mOriginalWidth = content.size().width();
             mOriginalHeight = content.size().height();
             return true;
@@ -156,7 +149,23 @@ bool ThumbnailContext::load(const QString &pixPath, int pixelSize)
 
     // format() is empty after QImageReader::read() is called
     format = reader.format();
-    if (!reader.read(&originalImage)) {
+    bool ok = false;
+    if (originalSize.isValid() && qMax(originalSize.width(), originalSize.height()) > pixelSize) {
+        QSize scaledSize = originalSize;
+        scaledSize.scale(pixelSize, pixelSize, Qt::KeepAspectRatio);
+        if (StreamingDecoder::canReadScaled(format) && !reader.fileName().isEmpty()) {
+            reader.device()->seek(0);
+            originalImage = StreamingDecoder::readScaled(reader.device(), format, scaledSize);
+            ok = !originalImage.isNull();
+            if (!ok) {
+                // Fall back to a full decode, from the start of the file
+                reader.setFileName(pixPath);
+            }
+        } else if (!reader.supportsOption(QImageIOHandler::ScaledSize)) {
+            ok = MultiResolutionReader::readLevel(&reader, scaledSize, &originalImage);
+        }
+    }
+    if (!ok && !reader.read(&originalImage)) {
         return false;
     }
 
@@ -180,6 +189,23 @@ bool ThumbnailContext::load(const QString &pixPath, int pixelSize)
     return true;
 }
 
+bool ThumbnailContext::loadFromImage(const QImage& image, const QSize& fullSize, int pixelSize)
+{
+    mNeedCaching = true;
+    if (image.isNull()) {
+        mImage = QImage();
+        return false;
+    }
+    mOriginalWidth = fullSize.width();
+    mOriginalHeight = fullSize.height();
+    if (qMax(image.width(), image.height()) <= pixelSize) {
+        mImage = image;
+    } else {
+        mImage = image.scaled(pixelSize, pixelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return true;
+}
+
 //------------------------------------------------------------------------
 //
 // ThumbnailGenerator
@@ -196,7 +222,7 @@ void ThumbnailGenerator::load(
     ThumbnailGroup::Enum group)
 {
     QMutexLocker lock(&mMutex);
-    Q_ASSERT(mPixPath.isNull());
+    Q_ASSERT(mPixPath.isNull() && mSourceImage.isNull());
 
     mOriginalUri = originalUri;
     mOriginalTime = originalTime;
@@ -209,6 +235,28 @@ void ThumbnailGenerator::load(
     mCond.wakeOne();
 }
 
+void ThumbnailGenerator::loadFromImage(
+    const QString& originalUri, time_t originalTime, KIO::filesize_t originalFileSize, const QString& originalMimeType,
+    const QImage& image,
+    const QSize& fullSize,
+    const QString& thumbnailPath,
+    ThumbnailGroup::Enum group)
+{
+    QMutexLocker lock(&mMutex);
+    Q_ASSERT(mPixPath.isNull() && mSourceImage.isNull());
+
+    mOriginalUri = originalUri;
+    mOriginalTime = originalTime;
+    mOriginalFileSize = originalFileSize;
+    mOriginalMimeType = originalMimeType;
+    mSourceImage = image;
+    mSourceImageFullSize = fullSize;
+    mThumbnailPath = thumbnailPath;
+    mThumbnailGroup = group;
+    if (!isRunning()) start();
+    mCond.wakeOne();
+}
+
 QString ThumbnailGenerator::originalUri() const
 {
     return mOriginalUri;
@@ -247,12 +295,16 @@ void ThumbnailGenerator::run()
     LOG("");
     while (!testCancel()) {
         QString pixPath;
+        QImage sourceImage;
+        QSize sourceImageFullSize;
+        QUrl originalUrl;
+        time_t originalTime;
         int pixelSize;
         {
             QMutexLocker lock(&mMutex);
-            // empty mPixPath means nothing to do
+            // empty mPixPath and mSourceImage means nothing to do
             LOG("Waiting for mPixPath");
-            if (mPixPath.isNull()) {
+            if (mPixPath.isNull() && mSourceImage.isNull()) {
                 LOG("mPixPath.isNull");
                 mCond.wait(&mMutex);
             }
@@ -263,13 +315,29 @@ void ThumbnailGenerator::run()
         {
             QMutexLocker lock(&mMutex);
             pixPath = mPixPath;
+            sourceImage = mSourceImage;
+            sourceImageFullSize = mSourceImageFullSize;
+            originalUrl = QUrl(mOriginalUri);
+            originalTime = mOriginalTime;
             pixelSize = ThumbnailGroup::pixelSize(mThumbnailGroup);
         }
 
-        Q_ASSERT(!pixPath.isNull());
-        LOG("Loading" << pixPath);
+        TraceSpan span("thumbnailGenerate", originalUrl);
         ThumbnailContext context;
-        bool ok = context.load(pixPath, pixelSize);
+        bool ok;
+        if (!sourceImage.isNull()) {
+            LOG("Loading from in-memory image for" << mOriginalUri);
+            ok = context.loadFromImage(sourceImage, sourceImageFullSize, pixelSize);
+        } else {
+            Q_ASSERT(!pixPath.isNull());
+            LOG("Loading" << pixPath);
+            ok = context.load(pixPath, pixelSize);
+        }
+        if (ok) {
+            // The thumbnail is small enough to hash, no need to decode the
+            // image again to find duplicates
+            ImageHashIndex::instance()->insert(originalUrl, originalTime, ImageHash::differenceHash(context.mImage));
+        }
 
         {
             QMutexLocker lock(&mMutex);
@@ -284,6 +352,7 @@ void ThumbnailGenerator::run()
                 qWarning() << "Could not generate thumbnail for file" << mOriginalUri;
             }
             mPixPath.clear(); // done, ready for next
+            mSourceImage = QImage();
         }
         if (testCancel()) {
             return;
@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #define THUMBNAILGENERATOR_H
 
 // Local
+#include <lib/gwenviewlib_export.h>
 #include <lib/thumbnailgroup.h>
 
 // KDE
@@ -36,13 +37,19 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 namespace Gwenview
 {
 
-struct ThumbnailContext {
+struct GWENVIEWLIB_EXPORT ThumbnailContext {
     QImage mImage;
     int mOriginalWidth;
     int mOriginalHeight;
     bool mNeedCaching;
 
     bool load(const QString &pixPath, int pixelSize);
+
+    /**
+     * Generates the thumbnail from an already decoded @p image, which is a
+     * version of an image whose full size is @p fullSize.
+     */
+    bool loadFromImage(const QImage& image, const QSize& fullSize, int pixelSize);
 };
 
 class ThumbnailGenerator : public QThread
@@ -60,6 +67,21 @@ public:
         const QString& thumbnailPath,
         ThumbnailGroup::Enum group);
 
+    /**
+     * Like load(), but generates the thumbnail from @p image instead of
+     * reading the file from disk. @p image must be a full or down sampled
+     * version of the file, @p fullSize is the size of the full image.
+     */
+    void loadFromImage(
+        const QString& originalUri,
+        time_t originalTime,
+        KIO::filesize_t originalFileSize,
+        const QString& originalMimeType,
+        const QImage& image,
+        const QSize& fullSize,
+        const QString& thumbnailPath,
+        ThumbnailGroup::Enum group);
+
     void cancel();
 
     QString originalUri() const;
@@ -78,6 +100,8 @@ private:
     void cacheThumbnail();
     QImage mImage;
     QString mPixPath;
+    QImage mSourceImage;
+    QSize mSourceImageFullSize;
     QString mThumbnailPath;
     QString mOriginalUri;
     time_t mOriginalTime;
@@ -44,9 +44,13 @@
 #include <KJobWidgets>
 
 // Local
+#include "document/documentfactory.h"
+#include "imagehash.h"
+#include "imagehashindex.h"
 #include "mimetypeutils.h"
 #include "thumbnailwriter.h"
 #include "thumbnailgenerator.h"
+#include "tracing.h"
 #include "urlutils.h"
 
 namespace Gwenview
@@ -291,6 +295,9 @@ void ThumbnailProvider::determineNextIcon()
 {
     LOG(this);
     mState = STATE_NEXTTHUMB;
+    if (!mCurrentItem.isNull()) {
+        Tracing::endAsync("thumbnail", mCurrentItem.url(), this);
+    }
 
     // No more items ?
     if (mItems.isEmpty()) {
@@ -302,6 +309,7 @@ void ThumbnailProvider::determineNextIcon()
 
     mCurrentItem = mItems.takeFirst();
     LOG("mCurrentItem.url=" << mCurrentItem.url());
+    Tracing::beginAsync("thumbnail", mCurrentItem.url(), this);
 
     // First, stat the orig file
     mState = STATE_STATORIG;
@@ -439,6 +447,11 @@ void ThumbnailProvider::checkThumbnail()
         if (thumb.text(QStringLiteral("Thumb::URI")) == mOriginalUri &&
                 thumb.text(QStringLiteral("Thumb::MTime")).toInt() == mOriginalTime &&
                  (fileSize == 0 || fileSize == mOriginalFileSize)) {
+            if (MimeTypeUtils::fileItemKind(mCurrentItem) == MimeTypeUtils::KIND_RASTER_IMAGE
+                    && !ImageHashIndex::instance()->findHash(mCurrentUrl, mOriginalTime)) {
+                // The thumbnail was created before the image was indexed
+                ImageHashIndex::instance()->insert(mCurrentUrl, mOriginalTime, ImageHash::differenceHash(thumb));
+            }
             int width = 0, height = 0;
             QSize size;
             bool ok;
@@ -465,6 +478,10 @@ void ThumbnailProvider::checkThumbnail()
 
     // Thumbnail not found or not valid
     if (MimeTypeUtils::fileItemKind(mCurrentItem) == MimeTypeUtils::KIND_RASTER_IMAGE) {
+        if (startCreatingThumbnailFromDocument()) {
+            // The image is open, no need to decode the file again
+            return;
+        }
         if (mCurrentUrl.isLocalFile()) {
             // Original is a local file, create the thumbnail
             startCreatingThumbnail(mCurrentUrl.toLocalFile());
@@ -529,6 +546,36 @@ void ThumbnailProvider::startCreatingThumbnail(const QString& pixPath)
                           mCurrentItem.mimetype(), pixPath, mThumbnailPath, mThumbnailGroup);
 }
 
+bool ThumbnailProvider::startCreatingThumbnailFromDocument()
+{
+    Document::Ptr doc = DocumentFactory::instance()->getCachedDocument(mCurrentItem.url());
+    if (!doc) {
+        return false;
+    }
+    // Modified documents are handled by ThumbnailView itself, we must not
+    // write their thumbnail to the disk cache
+    if (doc->isModified()) {
+        return false;
+    }
+    // The file may have changed since the document has been loaded, the
+    // thumbnail must show what is on disk
+    const QDateTime fileModificationTime = doc->fileModificationTime();
+    if (!fileModificationTime.isValid()
+            || time_t(fileModificationTime.toTime_t()) != mOriginalTime
+            || doc->fileSize() != qint64(mOriginalFileSize)) {
+        LOG("In-memory document is outdated" << mCurrentUrl);
+        return false;
+    }
+    const QImage image = doc->downSampledImageForPixelSize(ThumbnailGroup::pixelSize(mThumbnailGroup));
+    if (image.isNull() || !doc->size().isValid()) {
+        return false;
+    }
+    LOG("Creating thumbnail from in-memory document" << mCurrentUrl);
+    mThumbnailGenerator->loadFromImage(mOriginalUri, mOriginalTime, mOriginalFileSize,
+                          mCurrentItem.mimetype(), image, doc->size(), mThumbnailPath, mThumbnailGroup);
+    return true;
+}
+
 void ThumbnailProvider::slotGotPreview(const KFileItem& item, const QPixmap& pixmap)
 {
     if (mCurrentItem.isNull()) {
@@ -566,4 +613,10 @@ bool ThumbnailProvider::isThumbnailWriterEmpty()
     return sThumbnailWriter->isEmpty();
 }
 
+bool ThumbnailProvider::isThumbnailWritten(const QUrl& url, ThumbnailGroup::Enum group)
+{
+    const QString uri = generateOriginalUri(url.adjusted(QUrl::NormalizePathSegments));
+    return sThumbnailWriter->value(generateThumbnailPath(uri, group)).isNull();
+}
+
 } // namespace
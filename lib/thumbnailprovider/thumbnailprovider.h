@@ -114,6 +114,12 @@ public:
      */
     static bool isThumbnailWriterEmpty();
 
+    /**
+     * Returns true if the thumbnail of @p url for @p group is not waiting to
+     * be written to disk
+     */
+    static bool isThumbnailWritten(const QUrl& url, ThumbnailGroup::Enum group);
+
 Q_SIGNALS:
     /**
      * Emitted when the thumbnail for the @p item has been loaded
@@ -172,6 +178,7 @@ private:
     void createNewThumbnailGenerator();
     void abortSubjob();
     void startCreatingThumbnail(const QString& path);
+    bool startCreatingThumbnailFromDocument();
 
     void emitThumbnailLoaded(const QImage& img, const QSize& size);
 
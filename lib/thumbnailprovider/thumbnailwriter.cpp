@@ -57,6 +57,12 @@ static void storeThumbnailToDiskCache(const QString& path, const QImage& image)
     QFile::rename(tmp.fileName(), path);
 }
 
+ThumbnailWriter::ThumbnailWriter()
+{
+    connect(MemoryPressureMonitor::instance(), &MemoryPressureMonitor::levelChanged,
+            this, &ThumbnailWriter::slotMemoryPressureChanged);
+}
+
 void ThumbnailWriter::queueThumbnail(const QString& path, const QImage& image)
 {
     LOG(path);
@@ -90,6 +96,24 @@ QImage ThumbnailWriter::value(const QString& path) const
     return mCache.value(path);
 }
 
+void ThumbnailWriter::slotMemoryPressureChanged(MemoryPressureMonitor::Level level)
+{
+    if (level != MemoryPressureMonitor::CriticalPressure) {
+        return;
+    }
+    // Storing the thumbnails frees their memory too, without losing the
+    // work done to generate them: get them out as fast as possible
+    if (isEmpty()) {
+        return;
+    }
+    LOG("Flushing thumbnails");
+    if (isRunning()) {
+        setPriority(QThread::HighPriority);
+    } else {
+        start(QThread::HighPriority);
+    }
+}
+
 bool ThumbnailWriter::isEmpty() const
 {
     QMutexLocker locker(&mMutex);
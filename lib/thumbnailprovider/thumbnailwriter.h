@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 #define THUMBNAILWRITER_H
 
 // Local
+#include <lib/memorypressuremonitor.h>
 
 // KDE
 
@@ -42,6 +43,8 @@ class ThumbnailWriter : public QThread
 {
     Q_OBJECT
 public:
+    ThumbnailWriter();
+
     // Return thumbnail if it has still not been stored
     QImage value(const QString&) const;
 
@@ -53,6 +56,9 @@ public Q_SLOTS:
 protected:
     void run() override;
 
+private Q_SLOTS:
+    void slotMemoryPressureChanged(MemoryPressureMonitor::Level);
+
 private:
     typedef QHash<QString, QImage> Cache;
     Cache mCache;
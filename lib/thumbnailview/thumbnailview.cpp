@@ -93,12 +93,14 @@ struct Thumbnail
         , mModificationTime(mtime)
         , mFileSize(0)
         , mRough(true)
-        , mWaitingForThumbnail(true) {}
+        , mWaitingForThumbnail(true)
+        , mEvicted(false) {}
 
     Thumbnail()
         : mFileSize(0)
         , mRough(true)
-        , mWaitingForThumbnail(true) {}
+        , mWaitingForThumbnail(true)
+        , mEvicted(false) {}
 
     /**
      * Init the thumbnail based on a icon
@@ -138,6 +140,20 @@ struct Thumbnail
         mRealFullSize = QSize();
         mRough = true;
         mWaitingForThumbnail = true;
+        mEvicted = false;
+    }
+
+    /**
+     * Frees the pixmaps, keeping the sizes so that the layout does not
+     * change
+     */
+    void evict()
+    {
+        mGroupPix = QPixmap();
+        mAdjustedPix = QPixmap();
+        mRough = true;
+        mWaitingForThumbnail = true;
+        mEvicted = true;
     }
 
     QPersistentModelIndex mIndex;
@@ -158,6 +174,9 @@ struct Thumbnail
     bool mRough;
     /// Set to true if mGroupPix should be replaced with a real thumbnail
     bool mWaitingForThumbnail;
+    /// Set to true if the pixmaps have been freed because memory was short.
+    /// The thumbnail is only loaded again when the item becomes visible.
+    bool mEvicted;
 };
 
 typedef QHash<QUrl, Thumbnail> ThumbnailForUrl;
@@ -317,6 +336,9 @@ ThumbnailView::ThumbnailView(QWidget* parent)
     connect(this, &ThumbnailView::customContextMenuRequested, this, &ThumbnailView::showContextMenu);
 
     connect(this, &ThumbnailView::activated, this, &ThumbnailView::emitIndexActivatedIfNoModifiers);
+
+    connect(MemoryPressureMonitor::instance(), &MemoryPressureMonitor::levelChanged,
+            this, &ThumbnailView::slotMemoryPressureChanged);
 }
 
 ThumbnailView::~ThumbnailView()
@@ -554,6 +576,7 @@ void ThumbnailView::setThumbnail(const KFileItem& item, const QPixmap& pixmap, c
     thumbnail.mFullSize = size.isValid() ? size : QSize(largeGroupSize, largeGroupSize);
     thumbnail.mRealFullSize = size;
     thumbnail.mWaitingForThumbnail = false;
+    thumbnail.mEvicted = false;
     thumbnail.mFileSize = fileSize;
 
     update(thumbnail.mIndex);
@@ -849,6 +872,10 @@ void ThumbnailView::generateThumbnailsForItems()
             if (kind == MimeTypeUtils::KIND_DIR) {
                 distance = distance + visibleSurface;
             }
+        } else if (it != d->mThumbnailForUrl.constEnd() && it.value().mEvicted && !visibleItemRect.isValid()) {
+            // Do not load again thumbnails which have been evicted to save
+            // memory before they are needed
+            continue;
         } else {
             // Item is not visible, order thumbnails according to distance
             // Start at 2 * visibleSurface to ensure invisible thumbnails are
@@ -949,6 +976,33 @@ void ThumbnailView::smoothNextThumbnail()
     }
 }
 
+void ThumbnailView::slotMemoryPressureChanged(MemoryPressureMonitor::Level level)
+{
+    if (level == MemoryPressureMonitor::NoPressure) {
+        return;
+    }
+    const QRect visibleRect = viewport()->rect();
+    ThumbnailForUrl::Iterator it = d->mThumbnailForUrl.begin();
+    while (it != d->mThumbnailForUrl.end()) {
+        const QModelIndex index = it->mIndex;
+        if (isVisible() && index.isValid() && visualRect(index).intersects(visibleRect)) {
+            ++it;
+            continue;
+        }
+        d->mSmoothThumbnailQueue.removeAll(it.key());
+        if (level == MemoryPressureMonitor::CriticalPressure) {
+            // The thumbnail will be loaded again from the disk cache when
+            // the item becomes visible
+            it->evict();
+        } else {
+            // The scaled thumbnail will be computed again from mGroupPix
+            it->mAdjustedPix = QPixmap();
+            it->mRough = true;
+        }
+        ++it;
+    }
+}
+
 void ThumbnailView::reloadThumbnail(const QModelIndex& index)
 {
     QUrl url = urlForIndex(index);
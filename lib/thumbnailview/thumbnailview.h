@@ -28,6 +28,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 // KDE
 #include <QUrl>
 
+// Local
+#include <lib/memorypressuremonitor.h>
+
 class KFileItem;
 class QDragEnterEvent;
 class QDragMoveEvent;
@@ -206,6 +209,11 @@ private Q_SLOTS:
 
     void smoothNextThumbnail();
 
+    /**
+     * Drops the thumbnails of hidden items when memory runs low
+     */
+    void slotMemoryPressureChanged(MemoryPressureMonitor::Level);
+
 private:
     friend struct ThumbnailViewPrivate;
     ThumbnailViewPrivate * const d;
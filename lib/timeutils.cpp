@@ -125,6 +125,12 @@ struct CacheItem
 
 typedef QHash<QUrl, CacheItem> Cache;
 
+static Cache& cache()
+{
+    static Cache cache;
+    return cache;
+}
+
 QDateTime dateTimeForFileItem(const KFileItem& fileItem, CachePolicy cachePolicy)
 {
     if (cachePolicy == SkipCache) {
@@ -133,18 +139,34 @@ QDateTime dateTimeForFileItem(const KFileItem& fileItem, CachePolicy cachePolicy
         return item.realTime;
     }
 
-    static Cache cache;
     const QUrl url = fileItem.targetUrl();
 
-    Cache::iterator it = cache.find(url);
-    if (it == cache.end()) {
-        it = cache.insert(url, CacheItem());
+    Cache::iterator it = cache().find(url);
+    if (it == cache().end()) {
+        it = cache().insert(url, CacheItem());
     }
 
     it.value().update(fileItem);
     return it.value().realTime;
 }
 
+QDateTime cachedDateTimeForFileItem(const KFileItem& fileItem)
+{
+    Cache::const_iterator it = cache().constFind(fileItem.targetUrl());
+    if (it == cache().constEnd() || it.value().fileMTime != fileItem.time(KFileItem::ModificationTime)) {
+        return QDateTime();
+    }
+    return it.value().realTime;
+}
+
+void setCachedDateTimeForFileItem(const KFileItem& fileItem, const QDateTime& dateTime)
+{
+    CacheItem item;
+    item.fileMTime = fileItem.time(KFileItem::ModificationTime);
+    item.realTime = dateTime;
+    cache().insert(fileItem.targetUrl(), item);
+}
+
 } // namespace
 
 } // namespace
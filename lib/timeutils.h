@@ -41,6 +41,18 @@ enum CachePolicy
 
 QDateTime GWENVIEWLIB_EXPORT dateTimeForFileItem(const KFileItem& fileItem, Gwenview::TimeUtils::CachePolicy cachePolicy = UseCache);
 
+/**
+ * Returns the date of @p fileItem if it is in the cache and up to date, an
+ * invalid date otherwise. Never reads the file.
+ */
+QDateTime GWENVIEWLIB_EXPORT cachedDateTimeForFileItem(const KFileItem& fileItem);
+
+/**
+ * Puts a date computed earlier, for example in a previous session, in the
+ * cache
+ */
+void GWENVIEWLIB_EXPORT setCachedDateTimeForFileItem(const KFileItem& fileItem, const QDateTime& dateTime);
+
 } // namespace
 
 } // namespace
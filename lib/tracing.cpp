@@ -0,0 +1,256 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "tracing.h"
+
+// Qt
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+static QAtomicInt sNextThreadId(1);
+
+/**
+ * Small integer identifying the current thread in the trace, more readable
+ * than the value of QThread::currentThreadId()
+ */
+static thread_local int sThreadId = 0;
+
+struct TraceWriter
+{
+    QMutex mMutex;
+    QFile mFile;
+    QAtomicInt mEnabled;
+    bool mFirstEvent;
+    QElapsedTimer mTimer;
+
+    TraceWriter()
+    : mFirstEvent(true)
+    {
+        mTimer.start();
+        const QString path = QFile::decodeName(qgetenv("GV_TRACE_FILE"));
+        if (!path.isEmpty()) {
+            open(path);
+        }
+    }
+
+    ~TraceWriter()
+    {
+        close();
+    }
+
+    void open(const QString& path)
+    {
+        QMutexLocker locker(&mMutex);
+        mFile.setFileName(path);
+        if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning() << "Could not open trace file" << path;
+            return;
+        }
+        LOG("Tracing to" << path);
+        mFile.write("[\n");
+        mFirstEvent = true;
+        mEnabled.store(1);
+    }
+
+    void close()
+    {
+        QMutexLocker locker(&mMutex);
+        mEnabled.store(0);
+        if (!mFile.isOpen()) {
+            return;
+        }
+        mFile.write("\n]\n");
+        mFile.close();
+    }
+
+    void writeLocked(const QJsonObject& event)
+    {
+        if (!mFirstEvent) {
+            mFile.write(",\n");
+        }
+        mFirstEvent = false;
+        mFile.write(QJsonDocument(event).toJson(QJsonDocument::Compact));
+    }
+
+    void write(const char* name, char phase, const QUrl& url, qint64 ts, QJsonObject event = QJsonObject())
+    {
+        const qint64 pid = QCoreApplication::applicationPid();
+        QJsonObject threadNameEvent;
+        if (sThreadId == 0) {
+            sThreadId = sNextThreadId.fetchAndAddRelaxed(1);
+            // Name the thread once, so that the timeline shows which rows
+            // are the GUI thread and which are workers
+            QString threadName = QThread::currentThread()->objectName();
+            if (threadName.isEmpty()) {
+                threadName = QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread()
+                    ? QStringLiteral("GUI")
+                    : QStringLiteral("Thread %1").arg(sThreadId);
+            }
+            threadNameEvent[QStringLiteral("name")] = QStringLiteral("thread_name");
+            threadNameEvent[QStringLiteral("ph")] = QStringLiteral("M");
+            threadNameEvent[QStringLiteral("pid")] = pid;
+            threadNameEvent[QStringLiteral("tid")] = sThreadId;
+            threadNameEvent[QStringLiteral("args")] = QJsonObject {{QStringLiteral("name"), threadName}};
+        }
+
+        event[QStringLiteral("name")] = QString::fromLatin1(name);
+        event[QStringLiteral("cat")] = QStringLiteral("gwenview");
+        event[QStringLiteral("ph")] = QString(QLatin1Char(phase));
+        event[QStringLiteral("ts")] = ts;
+        event[QStringLiteral("pid")] = pid;
+        event[QStringLiteral("tid")] = sThreadId;
+        if (!url.isEmpty()) {
+            event[QStringLiteral("args")] = QJsonObject {{QStringLiteral("url"), url.toDisplayString()}};
+        }
+
+        QMutexLocker locker(&mMutex);
+        if (!mFile.isOpen()) {
+            return;
+        }
+        if (!threadNameEvent.isEmpty()) {
+            writeLocked(threadNameEvent);
+        }
+        writeLocked(event);
+    }
+};
+
+Q_GLOBAL_STATIC(TraceWriter, sWriter)
+
+namespace Tracing
+{
+
+bool isEnabled()
+{
+    TraceWriter* writer = sWriter;
+    return writer && writer->mEnabled.load();
+}
+
+void setOutputFile(const QString& path)
+{
+    TraceWriter* writer = sWriter;
+    writer->close();
+    if (!path.isEmpty()) {
+        writer->open(path);
+    }
+}
+
+qint64 timestamp()
+{
+    return sWriter->mTimer.nsecsElapsed() / 1000;
+}
+
+void complete(const char* name, const QUrl& url, qint64 start, qint64 duration)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    QJsonObject event;
+    event[QStringLiteral("dur")] = duration;
+    sWriter->write(name, 'X', url, start, event);
+}
+
+void instant(const char* name, const QUrl& url)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    QJsonObject event;
+    // Thread-scoped, so that it is drawn on the row of the current thread
+    event[QStringLiteral("s")] = QStringLiteral("t");
+    sWriter->write(name, 'i', url, timestamp(), event);
+}
+
+void counter(const char* name, qint64 value)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    QJsonObject event;
+    event[QStringLiteral("args")] = QJsonObject {{QStringLiteral("value"), value}};
+    sWriter->write(name, 'C', QUrl(), timestamp(), event);
+}
+
+static QJsonObject asyncEvent(const void* id)
+{
+    QJsonObject event;
+    event[QStringLiteral("id")] = QStringLiteral("0x%1").arg(quintptr(id), 0, 16);
+    return event;
+}
+
+void beginAsync(const char* name, const QUrl& url, const void* id)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    sWriter->write(name, 'b', url, timestamp(), asyncEvent(id));
+}
+
+void endAsync(const char* name, const QUrl& url, const void* id)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    sWriter->write(name, 'e', url, timestamp(), asyncEvent(id));
+}
+
+} // namespace
+
+TraceSpan::TraceSpan(const char* name, const QUrl& url)
+: mName(name)
+, mStart(-1)
+{
+    if (Tracing::isEnabled()) {
+        mUrl = url;
+        mStart = Tracing::timestamp();
+    }
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (mStart >= 0) {
+        Tracing::complete(mName, mUrl, mStart, Tracing::timestamp() - mStart);
+    }
+}
+
+} // namespace
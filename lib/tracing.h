@@ -0,0 +1,117 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <lib/gwenviewlib_export.h>
+
+// Qt
+#include <QString>
+#include <QUrl>
+
+// KDE
+
+// Local
+
+namespace Gwenview
+{
+
+/**
+ * Opt-in timeline of the document loading phases, written in the Chrome
+ * trace-event JSON format so that it can be opened with chrome://tracing or
+ * https://ui.perfetto.dev.
+ *
+ * Tracing is enabled by setting the GV_TRACE_FILE environment variable to the
+ * path of the file to write. When it is not set, all the functions below
+ * return immediately.
+ *
+ * Every event carries the url of the document it relates to, so that the
+ * latency of a given image can be attributed to its phases.
+ */
+namespace Tracing
+{
+
+/**
+ * Returns true if events are being recorded
+ */
+GWENVIEWLIB_EXPORT bool isEnabled();
+
+/**
+ * Starts writing events to @p path, closing the current trace file if there
+ * is one. An empty path disables tracing. Useful for unit-testing.
+ */
+GWENVIEWLIB_EXPORT void setOutputFile(const QString& path);
+
+/**
+ * Microseconds elapsed since tracing started
+ */
+GWENVIEWLIB_EXPORT qint64 timestamp();
+
+/**
+ * Records a span which started at @p start and lasted @p duration
+ * microseconds, on the current thread.
+ */
+GWENVIEWLIB_EXPORT void complete(const char* name, const QUrl& url, qint64 start, qint64 duration);
+
+/**
+ * Records a single point in time
+ */
+GWENVIEWLIB_EXPORT void instant(const char* name, const QUrl& url);
+
+/**
+ * Records the current value of a counter, such as the depth of a queue
+ */
+GWENVIEWLIB_EXPORT void counter(const char* name, qint64 value);
+
+/**
+ * Starts a span which does not begin and end in the same function, for
+ * example a KIO transfer or a job waiting in a queue. @p id must be the same
+ * when calling endAsync().
+ */
+GWENVIEWLIB_EXPORT void beginAsync(const char* name, const QUrl& url, const void* id);
+
+/**
+ * Ends a span started with beginAsync()
+ */
+GWENVIEWLIB_EXPORT void endAsync(const char* name, const QUrl& url, const void* id);
+
+} // namespace
+
+/**
+ * Records the time spent between its construction and its destruction.
+ */
+class GWENVIEWLIB_EXPORT TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name, const QUrl& url = QUrl());
+    ~TraceSpan();
+
+private:
+    const char* mName;
+    QUrl mUrl;
+    qint64 mStart;
+
+    Q_DISABLE_COPY(TraceSpan)
+};
+
+} // namespace
+
+#endif /* TRACING_H */
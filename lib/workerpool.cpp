@@ -0,0 +1,197 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "workerpool.h"
+
+// Qt
+#include <QAtomicInt>
+#include <QDebug>
+#include <QThread>
+#include <QThreadPool>
+
+// KDE
+
+// Local
+#include "tracing.h"
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+static int getThreadCount(const char* envName, int defaultValue)
+{
+    QByteArray ba = qgetenv(envName);
+    if (ba.isEmpty()) {
+        return defaultValue;
+    }
+    LOG("Custom value for" << envName << ":" << ba);
+    bool ok;
+    int value = ba.toInt(&ok);
+    return ok && value > 0 ? value : defaultValue;
+}
+
+struct Lane
+{
+    QThreadPool mPool;
+    QThread::Priority mPriority;
+    QAtomicInt mQueued;
+    QAtomicInt mActive;
+    QAtomicInt mMaxQueued;
+    QAtomicInteger<qint64> mFinished;
+
+    void init(const char* envName, int defaultThreadCount, QThread::Priority priority)
+    {
+        mPool.setMaxThreadCount(getThreadCount(envName, defaultThreadCount));
+        mPriority = priority;
+    }
+};
+
+struct Lanes
+{
+    Lane mLanes[WorkerLane::Count];
+
+    Lanes()
+    {
+        const int idealThreadCount = qMax(QThread::idealThreadCount(), 1);
+        mLanes[WorkerLane::Interactive].init("GV_INTERACTIVE_THREADS", idealThreadCount, QThread::NormalPriority);
+        mLanes[WorkerLane::Preload].init("GV_PRELOAD_THREADS", 1, QThread::LowPriority);
+        // Background work is often very CPU-intensive (RAW half previews
+        // for example), keep it to a single thread by default
+        mLanes[WorkerLane::Background].init("GV_BACKGROUND_THREADS", 1, QThread::IdlePriority);
+        mLanes[WorkerLane::BulkIO].init("GV_BULK_IO_THREADS", 2, QThread::LowPriority);
+    }
+};
+
+Q_GLOBAL_STATIC(Lanes, sLanes)
+
+static Lane* lane(WorkerLane::Enum value)
+{
+    Q_ASSERT(value >= 0 && value < WorkerLane::Count);
+    return &sLanes->mLanes[value];
+}
+
+static void traceQueueDepth(WorkerLane::Enum value, int queued)
+{
+    if (Tracing::isEnabled()) {
+        Tracing::counter(WorkerPool::laneName(value), queued);
+    }
+}
+
+namespace WorkerPool
+{
+
+QThreadPool* pool(WorkerLane::Enum value)
+{
+    return &lane(value)->mPool;
+}
+
+void setMaxThreadCount(WorkerLane::Enum value, int count)
+{
+    lane(value)->mPool.setMaxThreadCount(count);
+}
+
+Statistics statistics(WorkerLane::Enum value)
+{
+    Lane* l = lane(value);
+    Statistics stats;
+    stats.maxThreadCount = l->mPool.maxThreadCount();
+    stats.queued = l->mQueued.load();
+    stats.active = l->mActive.load();
+    stats.maxQueued = l->mMaxQueued.load();
+    stats.finished = l->mFinished.load();
+    return stats;
+}
+
+const char* laneName(WorkerLane::Enum value)
+{
+    switch (value) {
+    case WorkerLane::Interactive:
+        return "interactiveQueue";
+    case WorkerLane::Preload:
+        return "preloadQueue";
+    case WorkerLane::Background:
+        return "backgroundQueue";
+    case WorkerLane::BulkIO:
+        return "bulkIOQueue";
+    default:
+        return "unknownQueue";
+    }
+}
+
+void taskQueued(WorkerLane::Enum value)
+{
+    Lane* l = lane(value);
+    const int queued = l->mQueued.fetchAndAddOrdered(1) + 1;
+    int maxQueued = l->mMaxQueued.load();
+    while (queued > maxQueued && !l->mMaxQueued.testAndSetOrdered(maxQueued, queued)) {
+        maxQueued = l->mMaxQueued.load();
+    }
+    traceQueueDepth(value, queued);
+}
+
+TaskScope::TaskScope(WorkerLane::Enum value)
+: mLane(value)
+, mPreviousPriority(QThread::currentThread()->priority())
+{
+    if (mPreviousPriority == QThread::InheritPriority) {
+        // Threads which were never given a priority, setPriority() does not
+        // accept this value
+        mPreviousPriority = QThread::NormalPriority;
+    }
+    Lane* l = lane(value);
+    const int queued = l->mQueued.fetchAndAddOrdered(-1) - 1;
+    l->mActive.ref();
+    if (mPreviousPriority != l->mPriority) {
+        QThread::currentThread()->setPriority(l->mPriority);
+    }
+    traceQueueDepth(value, queued);
+}
+
+TaskScope::~TaskScope()
+{
+    Lane* l = lane(mLane);
+    l->mActive.deref();
+    l->mFinished.ref();
+    if (mPreviousPriority != l->mPriority) {
+        QThread::currentThread()->setPriority(mPreviousPriority);
+    }
+}
+
+int rangeCount(WorkerLane::Enum value, int count, int minCountPerRange)
+{
+    const int maxRanges = qMin(qMax(lane(value)->mPool.maxThreadCount(), 1), count);
+    if (maxRanges <= 1) {
+        return 1;
+    }
+    return qBound(1, count / qMax(minCountPerRange, 1), maxRanges);
+}
+
+} // namespace WorkerPool
+
+} // namespace Gwenview
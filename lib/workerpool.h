@@ -0,0 +1,212 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <lib/gwenviewlib_export.h>
+
+// STL
+#include <functional>
+
+// Qt
+#include <QAtomicInt>
+#include <QFuture>
+#include <QSharedPointer>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+
+// KDE
+
+// Local
+#include <lib/workerlane.h>
+
+class QThreadPool;
+
+namespace Gwenview
+{
+
+/**
+ * Thread pools used to run work outside of the GUI thread, one per
+ * WorkerLane. Use WorkerPool::run() instead of QtConcurrent::run().
+ *
+ * The number of threads of each lane can be set with the
+ * GV_INTERACTIVE_THREADS, GV_PRELOAD_THREADS, GV_BACKGROUND_THREADS and
+ * GV_BULK_IO_THREADS environment variables.
+ */
+namespace WorkerPool
+{
+
+struct Statistics
+{
+    int maxThreadCount;
+    /// Tasks waiting for a thread
+    int queued;
+    /// Tasks being run
+    int active;
+    /// Highest value of queued since startup
+    int maxQueued;
+    /// Tasks run since startup
+    qint64 finished;
+};
+
+GWENVIEWLIB_EXPORT QThreadPool* pool(WorkerLane::Enum lane);
+
+GWENVIEWLIB_EXPORT void setMaxThreadCount(WorkerLane::Enum lane, int count);
+
+/**
+ * Queue depth and activity of @p lane, useful to tune thread counts. When
+ * tracing is enabled, queue depths are also recorded as counters in the
+ * trace.
+ */
+GWENVIEWLIB_EXPORT Statistics statistics(WorkerLane::Enum lane);
+
+GWENVIEWLIB_EXPORT const char* laneName(WorkerLane::Enum lane);
+
+GWENVIEWLIB_EXPORT void taskQueued(WorkerLane::Enum lane);
+
+/**
+ * Keeps the statistics of a lane up to date while a task runs, and applies
+ * the thread priority of the lane. The previous priority is restored
+ * afterwards, because a task may run in the thread waiting for it.
+ */
+class GWENVIEWLIB_EXPORT TaskScope
+{
+public:
+    explicit TaskScope(WorkerLane::Enum lane);
+    ~TaskScope();
+
+private:
+    WorkerLane::Enum mLane;
+    QThread::Priority mPreviousPriority;
+
+    Q_DISABLE_COPY(TaskScope)
+};
+
+/**
+ * Runs @p functor in a thread of @p lane
+ */
+template <typename Functor>
+auto run(WorkerLane::Enum lane, Functor functor) -> QFuture<decltype(functor())>
+{
+    taskQueued(lane);
+    return QtConcurrent::run(pool(lane), [lane, functor]() mutable {
+        TaskScope scope(lane);
+        return functor();
+    });
+}
+
+/**
+ * Runs a function in a lane like run(), and can queue it again in another
+ * lane as long as it has not started, for example when a document which was
+ * being preloaded is shown.
+ */
+template <typename T>
+class MovableTask
+{
+public:
+    template <typename Functor>
+    QFuture<T> run(WorkerLane::Enum lane, Functor functor)
+    {
+        mFunction = functor;
+        return start(lane);
+    }
+
+    /**
+     * If the task has not started yet, queues it again in @p lane and sets
+     * @p future to the new future. The previous one then finishes without
+     * running the function.
+     *
+     * @return false if the task has already started, or is already queued
+     * in @p lane
+     */
+    bool moveTo(WorkerLane::Enum lane, QFuture<T>* future)
+    {
+        if (!mClaim || lane == mLane || !mClaim->testAndSetOrdered(0, 1)) {
+            return false;
+        }
+        *future = start(lane);
+        return true;
+    }
+
+private:
+    std::function<T()> mFunction;
+    WorkerLane::Enum mLane;
+    // Set by whoever gets the queued task first: its thread, or moveTo()
+    QSharedPointer<QAtomicInt> mClaim;
+
+    QFuture<T> start(WorkerLane::Enum lane)
+    {
+        mLane = lane;
+        QSharedPointer<QAtomicInt> claim(new QAtomicInt(0));
+        mClaim = claim;
+        std::function<T()> function = mFunction;
+        return WorkerPool::run(lane, [claim, function]() -> T {
+            if (!claim->testAndSetOrdered(0, 1)) {
+                return T();
+            }
+            return function();
+        });
+    }
+};
+
+/**
+ * Returns in how many ranges runInRanges() splits @p count items
+ */
+GWENVIEWLIB_EXPORT int rangeCount(WorkerLane::Enum lane, int count, int minCountPerRange);
+
+/**
+ * Calls @p function(start, end) on consecutive ranges covering [0, count[,
+ * in parallel on the threads of @p lane, and returns when all of them are
+ * done. Ranges contain at least @p minCountPerRange items, so that small
+ * jobs are not split.
+ *
+ * The calling thread works on the first range, and waiting for a range
+ * which has not started yet runs it in the calling thread, so it is safe to
+ * call this from a thread of @p lane.
+ */
+template <typename Function>
+void runInRanges(WorkerLane::Enum lane, int count, int minCountPerRange, Function function)
+{
+    const int ranges = rangeCount(lane, count, minCountPerRange);
+    if (ranges <= 1) {
+        function(0, count);
+        return;
+    }
+    QVector<QFuture<void> > futures;
+    for (int idx = 1; idx < ranges; ++idx) {
+        const int start = int(qint64(count) * idx / ranges);
+        const int end = int(qint64(count) * (idx + 1) / ranges);
+        futures << run(lane, [function, start, end]() {
+            function(start, end);
+        });
+    }
+    function(0, int(qint64(count) / ranges));
+    for (QFuture<void>& future : futures) {
+        future.waitForFinished();
+    }
+}
+
+} // namespace WorkerPool
+
+} // namespace Gwenview
+
+#endif /* WORKERPOOL_H */
@@ -0,0 +1,463 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "cachewatcher.h"
+
+// Qt
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QSet>
+#include <QTimer>
+#include <QUrl>
+
+// KDE
+#include <KDirWatch>
+
+// Local
+#include <lib/imagehashindex.h>
+#include <lib/mimetypeutils.h>
+#include <lib/thumbnailprovider/thumbnailprovider.h>
+#include <lib/workerpool.h>
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+/**
+ * How long to wait after the last change before processing changes, so
+ * that files being copied are processed once they are complete
+ */
+static const int CHANGE_DELAY = 2000;
+
+/**
+ * How long to wait at most after the first change before processing
+ * changes, so that a tree which never stops changing is kept up to date.
+ * Files still being written then are processed again once complete.
+ */
+static const int MAX_CHANGE_DELAY = 30000;
+
+/**
+ * How often to collect the garbage of the caches, in milliseconds
+ */
+static const int GARBAGE_COLLECTION_INTERVAL = 6 * 3600 * 1000;
+
+/**
+ * Returns the maximum number of inotify watches of a user, or 0 if it is
+ * unknown
+ */
+static qint64 maxInotifyWatches()
+{
+    QFile file(QStringLiteral("/proc/sys/fs/inotify/max_user_watches"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    return file.readAll().trimmed().toLongLong();
+}
+
+/**
+ * An unmounted mount point, or the root of removable media which is not
+ * plugged, is missing or empty
+ */
+static bool isPopulated(const QString& dir)
+{
+    return QDirIterator(dir, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot).hasNext();
+}
+
+static bool hasThumbnail(const KFileItem& item)
+{
+    switch (MimeTypeUtils::fileItemKind(item)) {
+    case MimeTypeUtils::KIND_RASTER_IMAGE:
+    case MimeTypeUtils::KIND_SVG_IMAGE:
+    case MimeTypeUtils::KIND_VIDEO:
+        return true;
+    default:
+        return false;
+    }
+}
+
+struct CacheWatcherPrivate
+{
+    QList<ThumbnailGroup::Enum> mGroups;
+    bool mVerbose;
+    QStringList mRootDirs;
+    KDirWatch* mDirWatch;
+    // Set when watching each file would use too many inotify watches
+    bool mWatchDirsOnly;
+    QList<ThumbnailProvider*> mProviders;
+
+    QSet<QString> mChangedPaths;
+    QSet<QString> mChangedDirs;
+    QSet<QString> mDeletedPaths;
+    QTimer mChangeTimer;
+    QTimer mMaxChangeTimer;
+
+    QTimer mGarbageTimer;
+    QFutureWatcher<int> mGarbageWatcher;
+
+    void addChangedPath(const QString& path)
+    {
+        mDeletedPaths.remove(path);
+        mChangedPaths.insert(path);
+        scheduleChanges();
+    }
+
+    void scheduleChanges()
+    {
+        // Restarted on each change, see CHANGE_DELAY
+        mChangeTimer.start();
+        if (!mMaxChangeTimer.isActive()) {
+            mMaxChangeTimer.start();
+        }
+    }
+
+    /**
+     * Decides whether files are watched individually: KDirWatch uses an
+     * inotify watch per file and per folder, and silently falls back to
+     * polling when it runs out of them
+     */
+    void chooseWatchMode(const QStringList& dirs)
+    {
+        mWatchDirsOnly = false;
+        if (mDirWatch->internalMethod() != KDirWatch::INotify) {
+            return;
+        }
+        const qint64 maxWatches = maxInotifyWatches();
+        if (maxWatches <= 0) {
+            return;
+        }
+        qint64 dirCount = 0;
+        qint64 fileCount = 0;
+        for (const QString& dir : dirs) {
+            ++dirCount;
+            QDirIterator it(dir, QDir::AllEntries | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                it.next();
+                if (it.fileInfo().isDir()) {
+                    ++dirCount;
+                } else {
+                    ++fileCount;
+                }
+            }
+        }
+        if (dirCount + fileCount <= maxWatches) {
+            return;
+        }
+        mWatchDirsOnly = true;
+        if (dirCount > maxWatches) {
+            qWarning() << "Watching" << dirCount << "folders exceeds the inotify limit of" << maxWatches
+                       << "watches, some changes will only be detected by polling."
+                       << "Raise fs.inotify.max_user_watches to avoid this.";
+        } else {
+            qWarning() << "Watching" << dirCount + fileCount << "files and folders exceeds the inotify limit of" << maxWatches
+                       << "watches, only folders are watched."
+                       << "Raise fs.inotify.max_user_watches to watch files too.";
+        }
+    }
+
+    void appendItems(const QString& path, KFileItemList* items)
+    {
+        const QFileInfo info(path);
+        if (info.isDir()) {
+            // A tree moved into a watched folder is reported as a single
+            // new folder
+            QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                const KFileItem item(QUrl::fromLocalFile(it.next()));
+                if (hasThumbnail(item)) {
+                    *items << item;
+                }
+            }
+        } else if (info.isFile()) {
+            const KFileItem item(QUrl::fromLocalFile(path));
+            if (hasThumbnail(item)) {
+                // The file may have been rewritten within the second of its
+                // previous modification time, which the thumbnail would not
+                // notice
+                ThumbnailProvider::deleteImageThumbnail(item.url());
+                *items << item;
+            }
+        }
+    }
+
+    /**
+     * When only folders are watched, we do not know which files of a
+     * modified folder changed: let ThumbnailProvider check all of them,
+     * thumbnails which are up to date are kept
+     */
+    void appendDirItems(const QString& path, KFileItemList* items)
+    {
+        QDirIterator it(path, QDir::Files);
+        while (it.hasNext()) {
+            const KFileItem item(QUrl::fromLocalFile(it.next()));
+            if (hasThumbnail(item)) {
+                *items << item;
+            }
+        }
+    }
+};
+
+CacheWatcher::CacheWatcher(QObject* parent)
+: QObject(parent)
+, d(new CacheWatcherPrivate)
+{
+    d->mGroups << ThumbnailGroup::Normal << ThumbnailGroup::Large;
+    d->mVerbose = false;
+    d->mWatchDirsOnly = false;
+    d->mDirWatch = new KDirWatch(this);
+    connect(d->mDirWatch, SIGNAL(created(QString)), SLOT(slotCreated(QString)));
+    connect(d->mDirWatch, SIGNAL(dirty(QString)), SLOT(slotDirty(QString)));
+    connect(d->mDirWatch, SIGNAL(deleted(QString)), SLOT(slotDeleted(QString)));
+
+    d->mChangeTimer.setSingleShot(true);
+    d->mChangeTimer.setInterval(CHANGE_DELAY);
+    connect(&d->mChangeTimer, SIGNAL(timeout()), SLOT(processChanges()));
+    d->mMaxChangeTimer.setSingleShot(true);
+    d->mMaxChangeTimer.setInterval(MAX_CHANGE_DELAY);
+    connect(&d->mMaxChangeTimer, SIGNAL(timeout()), SLOT(processChanges()));
+
+    d->mGarbageTimer.setInterval(GARBAGE_COLLECTION_INTERVAL);
+    connect(&d->mGarbageTimer, SIGNAL(timeout()), SLOT(startGarbageCollection()));
+    connect(&d->mGarbageWatcher, SIGNAL(finished()), SLOT(slotGarbageCollected()));
+}
+
+CacheWatcher::~CacheWatcher()
+{
+    d->mGarbageWatcher.disconnect();
+    d->mGarbageWatcher.waitForFinished();
+    qDeleteAll(d->mProviders);
+    delete d;
+}
+
+void CacheWatcher::setThumbnailGroups(const QList<ThumbnailGroup::Enum>& groups)
+{
+    d->mGroups = groups;
+}
+
+void CacheWatcher::setVerbose(bool verbose)
+{
+    d->mVerbose = verbose;
+}
+
+void CacheWatcher::start(const QStringList& dirs)
+{
+    for (ThumbnailGroup::Enum group : d->mGroups) {
+        ThumbnailProvider* provider = new ThumbnailProvider;
+        provider->setThumbnailGroup(group);
+        connect(provider, SIGNAL(thumbnailLoaded(KFileItem,QPixmap,QSize,qulonglong)),
+                SLOT(slotThumbnailLoaded(KFileItem)));
+        connect(provider, SIGNAL(thumbnailLoadingFailed(KFileItem)),
+                SLOT(slotThumbnailLoadingFailed(KFileItem)));
+        connect(provider, SIGNAL(finished()),
+                SLOT(slotProviderFinished()));
+        d->mProviders << provider;
+    }
+
+    if (d->mDirWatch->internalMethod() != KDirWatch::INotify) {
+        qWarning() << "inotify is not available, changes will be detected by polling";
+    }
+    for (const QString& dir : dirs) {
+        d->mRootDirs << QDir(dir).absolutePath();
+    }
+    d->chooseWatchMode(d->mRootDirs);
+    const KDirWatch::WatchModes watchModes = d->mWatchDirsOnly
+        ? KDirWatch::WatchSubDirs
+        : KDirWatch::WatchSubDirs | KDirWatch::WatchFiles;
+    for (const QString& path : qAsConst(d->mRootDirs)) {
+        d->mDirWatch->addDir(path, watchModes);
+    }
+
+    startGarbageCollection();
+    d->mGarbageTimer.start();
+}
+
+void CacheWatcher::slotCreated(const QString& path)
+{
+    LOG(path);
+    d->addChangedPath(path);
+}
+
+void CacheWatcher::slotDirty(const QString& path)
+{
+    LOG(path);
+    if (QFileInfo(path).isDir()) {
+        // Changes to the content of a folder are reported for each file,
+        // unless files are not watched. Files deleted in the meantime are
+        // then left to the garbage collection.
+        if (d->mWatchDirsOnly) {
+            d->mChangedDirs.insert(path);
+            d->scheduleChanges();
+        }
+        return;
+    }
+    d->addChangedPath(path);
+}
+
+void CacheWatcher::slotDeleted(const QString& path)
+{
+    LOG(path);
+    d->mChangedPaths.remove(path);
+    d->mDeletedPaths.insert(path);
+    d->scheduleChanges();
+}
+
+void CacheWatcher::processChanges()
+{
+    d->mChangeTimer.stop();
+    d->mMaxChangeTimer.stop();
+    for (const QString& path : qAsConst(d->mDeletedPaths)) {
+        const QUrl url = QUrl::fromLocalFile(path);
+        if (d->mVerbose) {
+            qInfo() << "Removed" << path;
+        }
+        ThumbnailProvider::deleteImageThumbnail(url);
+        ImageHashIndex::instance()->remove(url);
+    }
+    d->mDeletedPaths.clear();
+
+    KFileItemList items;
+    for (const QString& path : qAsConst(d->mChangedPaths)) {
+        d->appendItems(path, &items);
+    }
+    d->mChangedPaths.clear();
+    for (const QString& path : qAsConst(d->mChangedDirs)) {
+        d->appendDirItems(path, &items);
+    }
+    d->mChangedDirs.clear();
+    if (items.isEmpty()) {
+        return;
+    }
+    LOG("Updating" << items.count() << "thumbnails");
+    for (ThumbnailProvider* provider : qAsConst(d->mProviders)) {
+        provider->appendItems(items);
+    }
+}
+
+void CacheWatcher::startGarbageCollection()
+{
+    if (d->mGarbageWatcher.isRunning()) {
+        return;
+    }
+    const QStringList dirs = d->mRootDirs;
+    d->mGarbageWatcher.setFuture(WorkerPool::run(WorkerLane::Background, [dirs]() {
+        return CacheWatcher::collectGarbage(dirs);
+    }));
+}
+
+void CacheWatcher::slotGarbageCollected()
+{
+    const int count = d->mGarbageWatcher.result();
+    if (d->mVerbose || count > 0) {
+        qInfo() << "Removed" << count << "orphaned cache entries";
+    }
+    ImageHashIndex::instance()->flush();
+}
+
+void CacheWatcher::slotThumbnailLoaded(const KFileItem& item)
+{
+    if (d->mVerbose) {
+        qInfo() << "Done" << item.url().toLocalFile();
+    }
+}
+
+void CacheWatcher::slotThumbnailLoadingFailed(const KFileItem& item)
+{
+    qWarning() << "Could not create thumbnail for" << item.url().toLocalFile();
+}
+
+void CacheWatcher::slotProviderFinished()
+{
+    for (const ThumbnailProvider* provider : qAsConst(d->mProviders)) {
+        if (provider->isRunning()) {
+            return;
+        }
+    }
+    // Nothing else flushes the index of a long-running process
+    ImageHashIndex::instance()->flush();
+}
+
+int CacheWatcher::collectGarbage(const QStringList& dirs)
+{
+    QStringList prefixes;
+    for (const QString& dir : dirs) {
+        if (!isPopulated(dir)) {
+            // Everything under it would look orphaned
+            qWarning() << "Not collecting the garbage of" << dir << "which is missing or empty, it may not be mounted";
+            continue;
+        }
+        QString prefix = QDir(dir).absolutePath();
+        if (!prefix.endsWith(QLatin1Char('/'))) {
+            prefix += QLatin1Char('/');
+        }
+        prefixes << prefix;
+    }
+    auto isOrphan = [&prefixes](const QUrl& url) {
+        if (!url.isLocalFile()) {
+            return false;
+        }
+        const QString path = url.toLocalFile();
+        for (const QString& prefix : qAsConst(prefixes)) {
+            if (path.startsWith(prefix)) {
+                return !QFileInfo::exists(path);
+            }
+        }
+        return false;
+    };
+
+    int count = 0;
+    for (ThumbnailGroup::Enum group : {ThumbnailGroup::Normal, ThumbnailGroup::Large}) {
+        QDirIterator it(ThumbnailProvider::thumbnailBaseDir(group), QStringList() << QStringLiteral("*.png"), QDir::Files);
+        while (it.hasNext()) {
+            const QString thumbnailPath = it.next();
+            // Only reads the text chunks in front of the pixels
+            QImageReader reader(thumbnailPath, "png");
+            const QUrl url(reader.text(QStringLiteral("Thumb::URI")));
+            if (isOrphan(url) && QFile::remove(thumbnailPath)) {
+                LOG("Removed thumbnail of" << url);
+                ++count;
+            }
+        }
+    }
+
+    ImageHashIndex* index = ImageHashIndex::instance();
+    const QList<QUrl> urls = index->urls();
+    for (const QUrl& url : urls) {
+        if (isOrphan(url)) {
+            index->remove(url);
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace
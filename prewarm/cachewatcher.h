@@ -0,0 +1,97 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef CACHEWATCHER_H
+#define CACHEWATCHER_H
+
+// Qt
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+// KDE
+#include <KFileItem>
+
+// Local
+#include <lib/thumbnailgroup.h>
+
+namespace Gwenview
+{
+
+struct CacheWatcherPrivate;
+
+/**
+ * Keeps the caches of folder trees up to date while files change, without
+ * Gwenview running.
+ *
+ * The trees are watched with KDirWatch, which uses inotify on Linux.
+ * Thumbnails of new and modified images are generated once the changes
+ * settle, or after a while if they never do, thumbnails and hashes of deleted images are removed, and cache
+ * entries of images which disappeared while nothing was watching are
+ * garbage-collected periodically.
+ *
+ * If watching each file would exceed the inotify limit, only folders are
+ * watched and all the files of a modified folder are checked.
+ */
+class CacheWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CacheWatcher(QObject* parent = nullptr);
+    ~CacheWatcher() override;
+
+    void setThumbnailGroups(const QList<ThumbnailGroup::Enum>& groups);
+
+    void setVerbose(bool verbose);
+
+    /**
+     * Starts watching @p dirs and their sub-folders, and collects the
+     * garbage of their caches
+     */
+    void start(const QStringList& dirs);
+
+    /**
+     * Removes the thumbnails and hashes of the images of @p dirs which do
+     * not exist anymore. Returns the number of removed entries.
+     *
+     * Cache entries of other folders are left alone, they may belong to
+     * removable media which is not mounted. For the same reason, missing or
+     * empty folders of @p dirs are skipped.
+     */
+    static int collectGarbage(const QStringList& dirs);
+
+private Q_SLOTS:
+    void slotCreated(const QString& path);
+    void slotDirty(const QString& path);
+    void slotDeleted(const QString& path);
+    void processChanges();
+    void startGarbageCollection();
+    void slotGarbageCollected();
+    void slotThumbnailLoaded(const KFileItem& item);
+    void slotThumbnailLoadingFailed(const KFileItem& item);
+    void slotProviderFinished();
+
+private:
+    CacheWatcherPrivate* const d;
+};
+
+} // namespace
+
+#endif /* CACHEWATCHER_H */
@@ -0,0 +1,210 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// System
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#endif
+
+// Qt
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QTextStream>
+#include <QThread>
+
+// KDE
+#include <KAboutData>
+#include <KLocalizedString>
+
+// Local
+#include <lib/about.h>
+#include <lib/thumbnailprovider/thumbnailprovider.h>
+#include "cachewatcher.h"
+#include "prewarmer.h"
+
+using namespace Gwenview;
+
+/**
+ * Lowers the CPU and I/O priorities of the current thread, threads started
+ * afterwards inherit them
+ */
+static void lowerPriority()
+{
+#ifdef Q_OS_UNIX
+    if (setpriority(PRIO_PROCESS, 0, 19) != 0) {
+        qWarning() << "Could not lower CPU priority";
+    }
+#endif
+#if defined(Q_OS_LINUX) && defined(SYS_ioprio_set)
+    // Values from linux/ioprio.h, which is not always installed
+    const int IOPRIO_WHO_PROCESS = 1;
+    const int IOPRIO_CLASS_IDLE = 3;
+    const int IOPRIO_CLASS_SHIFT = 13;
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0) {
+        qWarning() << "Could not lower I/O priority";
+    }
+#endif
+}
+
+static void printSummary(const Prewarmer::Summary& summary)
+{
+    const double seconds = summary.elapsed / 1000.;
+    QTextStream out(stdout);
+    out << i18n("Folders processed: %1", summary.dirCount) << '\n';
+    if (summary.skippedDirCount > 0) {
+        out << i18n("Folders skipped, already done: %1", summary.skippedDirCount) << '\n';
+    }
+    out << i18n("Images: %1", summary.imageCount) << '\n';
+    out << i18n("Thumbnails: %1", summary.thumbnailCount) << '\n';
+    out << i18n("Failures: %1", summary.failureCount) << '\n';
+    out << i18n("Time: %1 s (%2 images/s)",
+                QString::number(seconds, 'f', 1),
+                QString::number(seconds > 0 ? summary.imageCount / seconds : 0., 'f', 1)) << '\n';
+}
+
+int main(int argc, char** argv)
+{
+    // Meant to run on servers, without a display
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    KLocalizedString::setApplicationDomain("gwenview");
+    QApplication app(argc, argv);
+
+    QScopedPointer<KAboutData> aboutData(
+        Gwenview::createAboutData(
+            QStringLiteral("org.kde.gwenview"), /* component name */
+            i18n("Gwenview Cache Prewarmer")  /* programName */
+        ));
+    aboutData->setShortDescription(i18n("Generates thumbnails of folder trees ahead of time"));
+    KAboutData::setApplicationData(*aboutData);
+
+    QCommandLineParser parser;
+    aboutData->setupCommandLine(&parser);
+    parser.addPositionalArgument(QStringLiteral("folders"), i18n("Folders to process, with their sub-folders"), i18n("folder..."));
+    QCommandLineOption jobsOption(QStringList() << QStringLiteral("j") << QStringLiteral("jobs"),
+                                  i18n("Number of images to process in parallel (default: number of CPUs)"), i18n("count"));
+    QCommandLineOption sizeOption(QStringList() << QStringLiteral("s") << QStringLiteral("size"),
+                                  i18n("Thumbnail size to generate: normal, large or both (default: both)"), i18n("size"), QStringLiteral("both"));
+    QCommandLineOption thumbnailDirOption(QStringList() << QStringLiteral("t") << QStringLiteral("thumbnail-dir"),
+                                          i18n("Store thumbnails in <dir> instead of the thumbnail cache of the user"), i18n("dir"));
+    QCommandLineOption progressOption(QStringList() << QStringLiteral("p") << QStringLiteral("progress-file"),
+                                      i18n("Record finished folders in <file>, and skip unmodified folders already recorded there. The file is emptied once all folders are done"), i18n("file"));
+    QCommandLineOption niceOption(QStringList() << QStringLiteral("n") << QStringLiteral("nice"),
+                                  i18n("Run with the lowest CPU and I/O priorities"));
+    QCommandLineOption watchOption(QStringList() << QStringLiteral("w") << QStringLiteral("watch"),
+                                   i18n("Keep running and update the cache when files are added, modified or deleted, with the lowest priorities"));
+    QCommandLineOption verboseOption(QStringList() << QStringLiteral("verbose"),
+                                     i18n("Print each processed file"));
+    parser.addOption(jobsOption);
+    parser.addOption(sizeOption);
+    parser.addOption(thumbnailDirOption);
+    parser.addOption(progressOption);
+    parser.addOption(niceOption);
+    parser.addOption(watchOption);
+    parser.addOption(verboseOption);
+    parser.process(app);
+    aboutData->processCommandLine(&parser);
+
+    const QStringList dirs = parser.positionalArguments();
+    if (dirs.isEmpty()) {
+        qCritical() << i18n("Missing folder argument.");
+        parser.showHelp(1);
+    }
+    for (const QString& dir : dirs) {
+        if (!QDir(dir).exists()) {
+            qCritical() << i18n("Folder %1 does not exist.", dir);
+            return 1;
+        }
+    }
+
+    int jobCount = QThread::idealThreadCount();
+    if (parser.isSet(jobsOption)) {
+        bool ok;
+        jobCount = parser.value(jobsOption).toInt(&ok);
+        if (!ok || jobCount < 1) {
+            qCritical() << i18n("Invalid number of jobs: %1", parser.value(jobsOption));
+            return 1;
+        }
+    }
+
+    QList<ThumbnailGroup::Enum> groups;
+    const QString size = parser.value(sizeOption);
+    if (size == QLatin1String("normal") || size == QLatin1String("both")) {
+        groups << ThumbnailGroup::Normal;
+    }
+    if (size == QLatin1String("large") || size == QLatin1String("both")) {
+        groups << ThumbnailGroup::Large;
+    }
+    if (groups.isEmpty()) {
+        qCritical() << i18n("Invalid thumbnail size: %1", size);
+        return 1;
+    }
+
+    if (parser.isSet(thumbnailDirOption)) {
+        QString thumbnailDir = QDir(parser.value(thumbnailDirOption)).absolutePath();
+        if (!QDir().mkpath(thumbnailDir)) {
+            qCritical() << i18n("Could not create %1.", thumbnailDir);
+            return 1;
+        }
+        if (!thumbnailDir.endsWith(QLatin1Char('/'))) {
+            thumbnailDir += QLatin1Char('/');
+        }
+        ThumbnailProvider::setThumbnailBaseDir(thumbnailDir);
+    }
+
+    // Before any worker thread is started, so that they inherit it
+    const bool watch = parser.isSet(watchOption);
+    if (parser.isSet(niceOption) || watch) {
+        lowerPriority();
+    }
+
+    Prewarmer prewarmer;
+    prewarmer.setJobCount(jobCount);
+    prewarmer.setThumbnailGroups(groups);
+    prewarmer.setProgressFile(parser.value(progressOption));
+    prewarmer.setVerbose(parser.isSet(verboseOption));
+    if (!watch) {
+        QObject::connect(&prewarmer, SIGNAL(finished()), &app, SLOT(quit()));
+        prewarmer.start(dirs);
+        app.exec();
+        const Prewarmer::Summary summary = prewarmer.summary();
+        printSummary(summary);
+        return summary.failureCount > 0 ? 2 : 0;
+    }
+
+    // Started first, so that files changing during the initial run are not
+    // missed
+    CacheWatcher watcher;
+    watcher.setThumbnailGroups(groups);
+    watcher.setVerbose(parser.isSet(verboseOption));
+    watcher.start(dirs);
+    QObject::connect(&prewarmer, &Prewarmer::finished, [&prewarmer]() {
+        printSummary(prewarmer.summary());
+    });
+    prewarmer.start(dirs);
+    return app.exec();
+}
@@ -0,0 +1,460 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+// Self
+#include "prewarmer.h"
+
+// Qt
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSharedPointer>
+#include <QTextStream>
+#include <QTimer>
+#include <QUrl>
+
+// KDE
+
+// STL
+#include <memory>
+
+// Local
+#include <lib/imagehashindex.h>
+#include <lib/mimetypeutils.h>
+#include <lib/thumbnailprovider/thumbnailprovider.h>
+
+namespace Gwenview
+{
+
+#undef ENABLE_LOG
+#undef LOG
+//#define ENABLE_LOG
+#ifdef ENABLE_LOG
+#define LOG(x) qDebug() << x
+#else
+#define LOG(x) ;
+#endif
+
+/**
+ * How often to check whether the thumbnails of processed folders have been
+ * written
+ */
+static const int WRITER_POLL_INTERVAL = 100;
+
+/**
+ * How many images of a folder are handed to a worker at once
+ */
+static const int CHUNK_SIZE = 32;
+
+static qint64 dirModificationTime(const QString& dir)
+{
+    return QFileInfo(dir).lastModified().toMSecsSinceEpoch();
+}
+
+/**
+ * A folder, with its modification time when its images were listed
+ */
+struct PrewarmDir
+{
+    QString mPath;
+    qint64 mModificationTime = 0;
+    QList<QUrl> mUrls;
+    /// Chunks which have not been processed yet
+    int mRemainingChunks = 0;
+};
+
+typedef QSharedPointer<PrewarmDir> PrewarmDirPtr;
+
+/**
+ * Part of the images of a folder
+ */
+struct PrewarmChunk
+{
+    PrewarmDirPtr mDir;
+    KFileItemList mItems;
+};
+
+struct PrewarmWorker
+{
+    QList<ThumbnailProvider*> mProviders;
+    /// Chunk being processed, mDir is null if the worker is idle
+    PrewarmChunk mChunk;
+    /// Providers which have not finished mChunk yet
+    int mRunningProviders = 0;
+};
+
+struct PrewarmerPrivate
+{
+    Prewarmer* q;
+    int mJobCount;
+    QList<ThumbnailGroup::Enum> mGroups;
+    bool mVerbose;
+    Prewarmer::Summary mSummary;
+    QElapsedTimer mTimer;
+
+    QStringList mRootDirs;
+    std::unique_ptr<QDirIterator> mDirIterator;
+    bool mNoMoreDirs;
+
+    QFile mProgressFile;
+    /// Folder => modification time, read from the progress file
+    QHash<QString, qint64> mDoneDirs;
+    /// Chunks of the listed folders, waiting for an idle worker
+    QList<PrewarmChunk> mChunks;
+    /// Processed folders whose thumbnails may not have been written yet
+    QList<PrewarmDirPtr> mUnwrittenDirs;
+    QTimer mWriterTimer;
+
+    QList<PrewarmWorker*> mWorkers;
+    QHash<ThumbnailProvider*, PrewarmWorker*> mWorkerForProvider;
+    bool mFinishing;
+
+    /**
+     * Returns the next folder to process, or a null string when all trees
+     * have been walked. Trees are walked as folders are needed, so that
+     * work starts right away on big trees.
+     */
+    QString nextDir()
+    {
+        forever {
+            if (mDirIterator && mDirIterator->hasNext()) {
+                return mDirIterator->next();
+            }
+            if (mRootDirs.isEmpty()) {
+                return QString();
+            }
+            const QString root = QDir(mRootDirs.takeFirst()).absolutePath();
+            // Do not follow symlinks, they could create loops
+            mDirIterator.reset(new QDirIterator(root, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories));
+            return root;
+        }
+    }
+
+    KFileItemList imageItems(const QString& dirPath) const
+    {
+        KFileItemList items;
+        const QFileInfoList infoList = QDir(dirPath).entryInfoList(QDir::Files, QDir::Name);
+        for (const QFileInfo& info : infoList) {
+            const KFileItem item(QUrl::fromLocalFile(info.absoluteFilePath()));
+            switch (MimeTypeUtils::fileItemKind(item)) {
+            case MimeTypeUtils::KIND_RASTER_IMAGE:
+            case MimeTypeUtils::KIND_SVG_IMAGE:
+            case MimeTypeUtils::KIND_VIDEO:
+                items << item;
+                break;
+            default:
+                break;
+            }
+        }
+        return items;
+    }
+
+    void loadProgress()
+    {
+        if (mProgressFile.fileName().isEmpty()) {
+            return;
+        }
+        if (mProgressFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QTextStream stream(&mProgressFile);
+            stream.setCodec("UTF-8");
+            while (!stream.atEnd()) {
+                // Lines are "<modification time>\t<folder>"
+                const QString line = stream.readLine();
+                const int tab = line.indexOf(QLatin1Char('\t'));
+                bool ok;
+                const qint64 modificationTime = line.leftRef(tab).toLongLong(&ok);
+                if (tab > 0 && ok) {
+                    mDoneDirs.insert(line.mid(tab + 1), modificationTime);
+                }
+            }
+            mProgressFile.close();
+        }
+        if (!mProgressFile.open(QIODevice::Append | QIODevice::Text)) {
+            qWarning() << "Could not open progress file" << mProgressFile.fileName();
+        }
+    }
+
+    void markDone(const PrewarmDir& dir)
+    {
+        ++mSummary.dirCount;
+        if (!mProgressFile.isOpen()) {
+            return;
+        }
+        // Written right away, so that progress survives an interruption
+        mProgressFile.write(QByteArray::number(dir.mModificationTime) + '\t' + dir.mPath.toUtf8() + '\n');
+        mProgressFile.flush();
+    }
+
+    bool isWritten(const PrewarmDir& dir) const
+    {
+        for (const QUrl& url : dir.mUrls) {
+            for (ThumbnailGroup::Enum group : mGroups) {
+                if (!ThumbnailProvider::isThumbnailWritten(url, group)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Lists the next folder with images and splits its images in chunks.
+     * Returns false if there is no folder left.
+     */
+    bool listNextDir()
+    {
+        while (!mNoMoreDirs) {
+            PrewarmDirPtr dir(new PrewarmDir);
+            dir->mPath = nextDir();
+            if (dir->mPath.isNull()) {
+                mNoMoreDirs = true;
+                break;
+            }
+            // Before listing the images: if the folder changes meanwhile, it
+            // is not skipped next time
+            dir->mModificationTime = dirModificationTime(dir->mPath);
+            auto it = mDoneDirs.constFind(dir->mPath);
+            if (it != mDoneDirs.constEnd() && it.value() == dir->mModificationTime) {
+                ++mSummary.skippedDirCount;
+                continue;
+            }
+            const KFileItemList items = imageItems(dir->mPath);
+            if (items.isEmpty()) {
+                markDone(*dir);
+                continue;
+            }
+            LOG("Processing" << dir->mPath << "with" << items.count() << "images");
+            for (const KFileItem& item : items) {
+                dir->mUrls << item.url();
+            }
+            for (int start = 0; start < items.count(); start += CHUNK_SIZE) {
+                PrewarmChunk chunk;
+                chunk.mDir = dir;
+                chunk.mItems = items.mid(start, CHUNK_SIZE);
+                mChunks << chunk;
+                ++dir->mRemainingChunks;
+            }
+            mSummary.imageCount += items.count();
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Gives the next chunk of images to @p worker. Returns false if there
+     * is no chunk left.
+     */
+    bool startNextChunk(PrewarmWorker* worker)
+    {
+        if (mChunks.isEmpty() && !listNextDir()) {
+            return false;
+        }
+        worker->mChunk = mChunks.takeFirst();
+        worker->mRunningProviders = worker->mProviders.count();
+        for (ThumbnailProvider* provider : worker->mProviders) {
+            provider->appendItems(worker->mChunk.mItems);
+        }
+        return true;
+    }
+
+    bool isIdle() const
+    {
+        if (!mChunks.isEmpty()) {
+            return false;
+        }
+        for (const PrewarmWorker* worker : mWorkers) {
+            if (worker->mChunk.mDir) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+Prewarmer::Prewarmer(QObject* parent)
+: QObject(parent)
+, d(new PrewarmerPrivate)
+{
+    d->q = this;
+    d->mJobCount = 1;
+    d->mGroups << ThumbnailGroup::Normal << ThumbnailGroup::Large;
+    d->mVerbose = false;
+    d->mNoMoreDirs = false;
+    d->mFinishing = false;
+    d->mWriterTimer.setInterval(WRITER_POLL_INTERVAL);
+    connect(&d->mWriterTimer, SIGNAL(timeout()), SLOT(markWrittenDirsDone()));
+}
+
+Prewarmer::~Prewarmer()
+{
+    for (PrewarmWorker* worker : d->mWorkers) {
+        qDeleteAll(worker->mProviders);
+    }
+    qDeleteAll(d->mWorkers);
+    delete d;
+}
+
+void Prewarmer::setJobCount(int count)
+{
+    d->mJobCount = qMax(count, 1);
+}
+
+int Prewarmer::jobCount() const
+{
+    return d->mJobCount;
+}
+
+void Prewarmer::setThumbnailGroups(const QList<ThumbnailGroup::Enum>& groups)
+{
+    d->mGroups = groups;
+}
+
+void Prewarmer::setProgressFile(const QString& path)
+{
+    d->mProgressFile.setFileName(path);
+}
+
+void Prewarmer::setVerbose(bool verbose)
+{
+    d->mVerbose = verbose;
+}
+
+void Prewarmer::start(const QStringList& dirs)
+{
+    d->mTimer.start();
+    d->mRootDirs = dirs;
+    d->loadProgress();
+
+    for (int idx = 0; idx < d->mJobCount; ++idx) {
+        PrewarmWorker* worker = new PrewarmWorker;
+        for (ThumbnailGroup::Enum group : d->mGroups) {
+            ThumbnailProvider* provider = new ThumbnailProvider;
+            provider->setThumbnailGroup(group);
+            connect(provider, SIGNAL(thumbnailLoaded(KFileItem,QPixmap,QSize,qulonglong)),
+                    SLOT(slotThumbnailLoaded(KFileItem)));
+            connect(provider, SIGNAL(thumbnailLoadingFailed(KFileItem)),
+                    SLOT(slotThumbnailLoadingFailed(KFileItem)));
+            connect(provider, SIGNAL(finished()),
+                    SLOT(slotProviderFinished()));
+            worker->mProviders << provider;
+            d->mWorkerForProvider.insert(provider, worker);
+        }
+        d->mWorkers << worker;
+    }
+    QMetaObject::invokeMethod(this, "startIdleWorkers", Qt::QueuedConnection);
+}
+
+Prewarmer::Summary Prewarmer::summary() const
+{
+    return d->mSummary;
+}
+
+void Prewarmer::slotThumbnailLoaded(const KFileItem& item)
+{
+    ++d->mSummary.thumbnailCount;
+    if (d->mVerbose) {
+        qInfo() << "Done" << item.url().toLocalFile();
+    }
+}
+
+void Prewarmer::slotThumbnailLoadingFailed(const KFileItem& item)
+{
+    ++d->mSummary.failureCount;
+    qWarning() << "Could not create thumbnail for" << item.url().toLocalFile();
+}
+
+void Prewarmer::slotProviderFinished()
+{
+    ThumbnailProvider* provider = static_cast<ThumbnailProvider*>(sender());
+    PrewarmWorker* worker = d->mWorkerForProvider.value(provider);
+    if (!worker || !worker->mChunk.mDir) {
+        return;
+    }
+    --worker->mRunningProviders;
+    if (worker->mRunningProviders > 0) {
+        return;
+    }
+    const PrewarmDirPtr dir = worker->mChunk.mDir;
+    worker->mChunk = PrewarmChunk();
+    --dir->mRemainingChunks;
+    if (dir->mRemainingChunks == 0) {
+        // Thumbnails are written by a separate thread, the folder is only
+        // done once they are on disk
+        d->mUnwrittenDirs << dir;
+        if (!d->mWriterTimer.isActive()) {
+            d->mWriterTimer.start();
+        }
+    }
+    // Queued: the provider is still emitting its signal
+    QMetaObject::invokeMethod(this, "startIdleWorkers", Qt::QueuedConnection);
+}
+
+void Prewarmer::startIdleWorkers()
+{
+    for (PrewarmWorker* worker : d->mWorkers) {
+        if (!worker->mChunk.mDir && !d->startNextChunk(worker)) {
+            break;
+        }
+    }
+    if (d->mNoMoreDirs && d->isIdle() && !d->mFinishing) {
+        d->mFinishing = true;
+        waitForWriter();
+    }
+}
+
+void Prewarmer::markWrittenDirsDone()
+{
+    auto it = d->mUnwrittenDirs.begin();
+    while (it != d->mUnwrittenDirs.end()) {
+        if (d->isWritten(**it)) {
+            d->markDone(**it);
+            it = d->mUnwrittenDirs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (d->mUnwrittenDirs.isEmpty()) {
+        d->mWriterTimer.stop();
+    }
+}
+
+void Prewarmer::waitForWriter()
+{
+    if (!ThumbnailProvider::isThumbnailWriterEmpty()) {
+        QTimer::singleShot(WRITER_POLL_INTERVAL, this, SLOT(waitForWriter()));
+        return;
+    }
+    markWrittenDirsDone();
+    ImageHashIndex::instance()->flush();
+    // All folders are done: the next run must not skip them
+    if (d->mProgressFile.isOpen()) {
+        d->mProgressFile.resize(0);
+        d->mProgressFile.close();
+    }
+    d->mSummary.elapsed = d->mTimer.elapsed();
+    emit finished();
+}
+
+} // namespace
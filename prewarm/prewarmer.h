@@ -0,0 +1,110 @@
+// vim: set tabstop=4 shiftwidth=4 expandtab:
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA.
+
+*/
+#ifndef PREWARMER_H
+#define PREWARMER_H
+
+// Qt
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+// KDE
+#include <KFileItem>
+
+// Local
+#include <lib/thumbnailgroup.h>
+
+namespace Gwenview
+{
+
+struct PrewarmerPrivate;
+
+/**
+ * Walks folder trees and fills the caches Gwenview would otherwise fill
+ * while browsing: thumbnails of each requested size, and the image hash
+ * index, which is updated as thumbnails are generated.
+ *
+ * The images of each folder are split in chunks, handed to jobCount()
+ * workers each running its own ThumbnailProvider per size, so that as many
+ * images are decoded in parallel, even within a single big folder. A folder
+ * is done once all of its chunks are.
+ */
+class Prewarmer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Summary
+    {
+        int dirCount = 0;
+        /// Folders listed in the progress file of a previous run
+        int skippedDirCount = 0;
+        int imageCount = 0;
+        int thumbnailCount = 0;
+        int failureCount = 0;
+        qint64 elapsed = 0;
+    };
+
+    explicit Prewarmer(QObject* parent = nullptr);
+    ~Prewarmer() override;
+
+    void setJobCount(int count);
+    int jobCount() const;
+
+    void setThumbnailGroups(const QList<ThumbnailGroup::Enum>& groups);
+
+    /**
+     * Folders whose thumbnails have been written are appended to @p path,
+     * with their modification time. Folders listed there and not modified
+     * since are skipped, so that an interrupted run can be resumed. The file
+     * is emptied when a run completes, so that the next run goes through
+     * all folders again.
+     */
+    void setProgressFile(const QString& path);
+
+    void setVerbose(bool verbose);
+
+    /**
+     * Starts processing @p dirs and their sub-folders. finished() is
+     * emitted once all thumbnails have been written.
+     */
+    void start(const QStringList& dirs);
+
+    Summary summary() const;
+
+Q_SIGNALS:
+    void finished();
+
+private Q_SLOTS:
+    void slotThumbnailLoaded(const KFileItem& item);
+    void slotThumbnailLoadingFailed(const KFileItem& item);
+    void slotProviderFinished();
+    void startIdleWorkers();
+    void markWrittenDirsDone();
+    void waitForWriter();
+
+private:
+    PrewarmerPrivate* const d;
+    friend struct PrewarmerPrivate;
+};
+
+} // namespace
+
+#endif /* PREWARMER_H */
@@ -0,0 +1,145 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "animationinfotest.h"
+
+// Qt
+#include <QFile>
+#include <QtEndian>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/animationinfo.h"
+#include "testutils.h"
+
+QTEST_MAIN(AnimationInfoTest)
+
+using namespace Gwenview;
+
+static QByteArray readTestFile(const QString& name)
+{
+    QFile file(pathForTestFile(name));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+static QByteArray pngChunk(const QByteArray& type, const QByteArray& data)
+{
+    QByteArray chunk(4, '\0');
+    qToBigEndian<quint32>(data.size(), reinterpret_cast<uchar*>(chunk.data()));
+    // The CRC is not checked, leave it empty
+    return chunk + type + data + QByteArray(4, '\0');
+}
+
+static QByteArray webpChunk(const QByteArray& fourcc, const QByteArray& data)
+{
+    QByteArray chunk = fourcc + QByteArray(4, '\0');
+    qToLittleEndian<quint32>(data.size(), reinterpret_cast<uchar*>(chunk.data() + 4));
+    chunk += data;
+    if (data.size() % 2) {
+        chunk += '\0';
+    }
+    return chunk;
+}
+
+static QByteArray webpFile(const QByteArray& chunks)
+{
+    QByteArray header = QByteArray("RIFF") + QByteArray(4, '\0') + QByteArray("WEBP");
+    qToLittleEndian<quint32>(chunks.size() + 4, reinterpret_cast<uchar*>(header.data() + 4));
+    return header + chunks;
+}
+
+void AnimationInfoTest::testGif_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<int>("expectedCount");
+
+    QTest::newRow("1frame") << "1frame.gif" << 1;
+    QTest::newRow("4frames") << "4frames.gif" << 4;
+    QTest::newRow("40frames") << "40frames.gif" << 40;
+    // Has a Graphic Control Extension, but only one frame (Bug #185523)
+    QTest::newRow("185523") << "185523_1frame_with_graphic_control_extension.gif" << 1;
+}
+
+void AnimationInfoTest::testGif()
+{
+    QFETCH(QString, fileName);
+    QFETCH(int, expectedCount);
+
+    const QByteArray data = readTestFile(fileName);
+    QVERIFY(!data.isEmpty());
+    QCOMPARE(AnimationInfo::frameCount(data), expectedCount);
+}
+
+void AnimationInfoTest::testMaxFrames()
+{
+    const QByteArray data = readTestFile("40frames.gif");
+    QVERIFY(!data.isEmpty());
+    QCOMPARE(AnimationInfo::frameCount(data, 2), 2);
+}
+
+void AnimationInfoTest::testPng()
+{
+    const QByteArray data = readTestFile("test.png");
+    QVERIFY(!data.isEmpty());
+    QCOMPARE(AnimationInfo::frameCount(data), 1);
+
+    // APNG: acTL comes before IDAT
+    const QByteArray signature("\x89PNG\r\n\x1a\n", 8);
+    const QByteArray ihdr = pngChunk("IHDR", QByteArray(13, '\0'));
+    QByteArray actl(8, '\0');
+    qToBigEndian<quint32>(3, reinterpret_cast<uchar*>(actl.data()));
+    const QByteArray apng = signature + ihdr + pngChunk("acTL", actl)
+        + pngChunk("IDAT", QByteArray(4, '\0')) + pngChunk("IEND", QByteArray());
+    QCOMPARE(AnimationInfo::frameCount(apng), 3);
+}
+
+void AnimationInfoTest::testWebp()
+{
+    // Still lossy image
+    const QByteArray still = webpFile(webpChunk("VP8 ", QByteArray(10, '\0')));
+    QCOMPARE(AnimationInfo::frameCount(still), 1);
+
+    // Extended format without the animation flag
+    QByteArray vp8x(10, '\0');
+    const QByteArray extendedStill = webpFile(webpChunk("VP8X", vp8x) + webpChunk("VP8L", QByteArray(5, '\0')));
+    QCOMPARE(AnimationInfo::frameCount(extendedStill), 1);
+
+    // Animation with three frames, one of them of odd size
+    vp8x[0] = 0x02;
+    const QByteArray animated = webpFile(webpChunk("VP8X", vp8x)
+        + webpChunk("ANIM", QByteArray(6, '\0'))
+        + webpChunk("ANMF", QByteArray(16, '\0'))
+        + webpChunk("ANMF", QByteArray(17, '\0'))
+        + webpChunk("ANMF", QByteArray(16, '\0')));
+    QCOMPARE(AnimationInfo::frameCount(animated), 3);
+    QCOMPARE(AnimationInfo::frameCount(animated, 2), 2);
+}
+
+void AnimationInfoTest::testUnsupported()
+{
+    QCOMPARE(AnimationInfo::frameCount(QByteArray()), -1);
+    QCOMPARE(AnimationInfo::frameCount(readTestFile("orient6.jpg")), -1);
+    // Truncated GIF header
+    QCOMPARE(AnimationInfo::frameCount(QByteArray("GIF89a\x01\x00", 8)), -1);
+}
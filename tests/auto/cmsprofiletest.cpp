@@ -29,7 +29,11 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Cambridge, MA 02110-1301, USA
 // KDE
 #include <qtest.h>
 
+// lcms
+#include <lcms2.h>
+
 // Qt
+#include <QImage>
 
 QTEST_MAIN(CmsProfileTest)
 
@@ -64,6 +68,76 @@ void CmsProfileTest::testLoadFromImageData_data()
 }
 #undef NEW_ROW
 
+static QImage createGrayGradient()
+{
+    QImage image(256, 4, QImage::Format_Grayscale8);
+    for (int y = 0; y < image.height(); ++y) {
+        uchar* line = image.scanLine(y);
+        for (int x = 0; x < image.width(); ++x) {
+            line[x] = uchar(x);
+        }
+    }
+    return image;
+}
+
+void CmsProfileTest::testTransformGrayImage()
+{
+    const QImage gradient = createGrayGradient();
+    Cms::Profile::Ptr grayProfile = Cms::Profile::getGrayProfile();
+    Cms::Profile::Ptr sRgbProfile = Cms::Profile::getSRgbProfile();
+    QVERIFY(grayProfile->isGray());
+    QVERIFY(!sRgbProfile->isGray());
+
+    // Gray to RGB: the gray profile has the tone curve of sRGB, so values
+    // must be kept
+    QImage image = gradient;
+    QVERIFY(Cms::transformImage(&image, grayProfile, sRgbProfile, INTENT_PERCEPTUAL));
+    QCOMPARE(image.format(), QImage::Format_RGB32);
+    QCOMPARE(image.size(), gradient.size());
+    for (int x = 0; x < image.width(); ++x) {
+        const QRgb rgb = image.pixel(x, 2);
+        QVERIFY2(qAbs(qRed(rgb) - x) <= 2 && qAbs(qGreen(rgb) - x) <= 2 && qAbs(qBlue(rgb) - x) <= 2,
+                 qPrintable(QStringLiteral("%1: %2").arg(x).arg(rgb, 0, 16)));
+        QCOMPARE(qAlpha(rgb), 255);
+    }
+    // The source image must not be modified
+    QCOMPARE(gradient, createGrayGradient());
+
+    // Gray pixels with an RGB profile
+    image = gradient;
+    QVERIFY(Cms::transformImage(&image, sRgbProfile, sRgbProfile, INTENT_PERCEPTUAL));
+    QCOMPARE(image.format(), QImage::Format_RGB32);
+    QVERIFY(qAbs(qGreen(image.pixel(128, 0)) - 128) <= 2);
+
+    // Gray to gray keeps the format
+    image = gradient;
+    QVERIFY(Cms::transformImage(&image, grayProfile, grayProfile, INTENT_PERCEPTUAL));
+    QCOMPARE(image.format(), QImage::Format_Grayscale8);
+    QVERIFY(qAbs(image.constScanLine(1)[200] - 200) <= 2);
+
+    // RGB pixels cannot be transformed with a gray profile
+    image = gradient.convertToFormat(QImage::Format_RGB32);
+    QVERIFY(!Cms::transformImage(&image, grayProfile, sRgbProfile, INTENT_PERCEPTUAL));
+}
+
+void CmsProfileTest::testTransformGrayIndexedImage()
+{
+    QImage image(4, 4, QImage::Format_Indexed8);
+    QVector<QRgb> colorTable;
+    for (int idx = 0; idx < 256; ++idx) {
+        colorTable << qRgba(idx, idx, idx, idx == 0 ? 0 : 255);
+    }
+    image.setColorTable(colorTable);
+    image.fill(100);
+
+    QVERIFY(Cms::transformImage(&image, Cms::Profile::getGrayProfile(), Cms::Profile::getSRgbProfile(), INTENT_PERCEPTUAL));
+    QCOMPARE(image.format(), QImage::Format_Indexed8);
+    const QRgb rgb = image.color(100);
+    QVERIFY(qAbs(qRed(rgb) - 100) <= 2 && qAbs(qBlue(rgb) - 100) <= 2);
+    QCOMPARE(qAlpha(image.color(0)), 0);
+    QCOMPARE(qAlpha(rgb), 255);
+}
+
 #if 0
 
 void CmsProfileTest::testLoadFromExiv2Image()
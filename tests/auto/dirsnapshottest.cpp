@@ -0,0 +1,253 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "dirsnapshottest.h"
+
+#include <sys/stat.h>
+#include <utime.h>
+
+// Qt
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+
+// KDE
+#include <KCoreDirLister>
+#include <kio_version.h>
+#include <qtest.h>
+
+// Local
+#include "../lib/dirsnapshot.h"
+#include "../lib/snapshotdirlister.h"
+#include "../lib/timeutils.h"
+#include "testutils.h"
+
+QTEST_MAIN(DirSnapshotTest)
+
+using namespace Gwenview;
+
+static const QUrl DIR_URL(QStringLiteral("sftp://server/photos"));
+
+static void setEntryField(KIO::UDSEntry* entry, uint field, const QString& value)
+{
+#if KIO_VERSION >= QT_VERSION_CHECK(5, 48, 0)
+    entry->replace(field, value);
+#else
+    entry->insert(field, value);
+#endif
+}
+
+static void setEntryField(KIO::UDSEntry* entry, uint field, long long value)
+{
+#if KIO_VERSION >= QT_VERSION_CHECK(5, 48, 0)
+    entry->replace(field, value);
+#else
+    entry->insert(field, value);
+#endif
+}
+
+static KFileItem createItem(const QString& name, qint64 size, qint64 mtime)
+{
+    KIO::UDSEntry entry;
+    setEntryField(&entry, KIO::UDSEntry::UDS_NAME, name);
+    setEntryField(&entry, KIO::UDSEntry::UDS_SIZE, size);
+    setEntryField(&entry, KIO::UDSEntry::UDS_MODIFICATION_TIME, mtime);
+    setEntryField(&entry, KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
+    return KFileItem(entry, DIR_URL, false, true);
+}
+
+static KFileItemList createItems()
+{
+    KFileItemList items;
+    items << createItem(QStringLiteral("a.png"), 100, 1000)
+          << createItem(QStringLiteral("b.jpg"), 200, 2000)
+          << createItem(QStringLiteral("c.gif"), 300, 3000);
+    return items;
+}
+
+/**
+ * Creates a file of @p size bytes, with a fixed modification time so that
+ * two folders can hold identical items
+ */
+static void createFile(const QString& path, int size)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(size, 'x'));
+    file.close();
+    struct utimbuf times;
+    times.actime = 1500000000;
+    times.modtime = 1500000000;
+    QCOMPARE(utime(QFile::encodeName(path).constData(), &times), 0);
+}
+
+static QStringList fileNames(const KFileItemList& items)
+{
+    QStringList names;
+    for (const KFileItem& item : items) {
+        names << item.name();
+    }
+    names.sort();
+    return names;
+}
+
+void DirSnapshotTest::initTestCase()
+{
+    QVERIFY(mCacheDir.isValid());
+    DirSnapshot::setCacheDir(mCacheDir.path());
+}
+
+void DirSnapshotTest::testRoundTrip()
+{
+    const KFileItemList items = createItems();
+    // Determine the mime type of the first item, it should be stored
+    QCOMPARE(items.first().mimetype(), QStringLiteral("image/png"));
+
+    DirSnapshot::store(DIR_URL, DirSnapshot::entriesForItems(items));
+    const KFileItemList loadedItems = DirSnapshot::load(DIR_URL);
+    QCOMPARE(loadedItems.count(), items.count());
+    for (int idx = 0; idx < items.count(); ++idx) {
+        const KFileItem& item = items.at(idx);
+        const KFileItem& loadedItem = loadedItems.at(idx);
+        QCOMPARE(loadedItem.url(), item.url());
+        QCOMPARE(loadedItem.size(), item.size());
+        QCOMPARE(loadedItem.time(KFileItem::ModificationTime), item.time(KFileItem::ModificationTime));
+        QVERIFY(loadedItem.cmp(item));
+    }
+    QCOMPARE(loadedItems.first().entry().stringValue(KIO::UDSEntry::UDS_MIME_TYPE), QStringLiteral("image/png"));
+}
+
+void DirSnapshotTest::testDateTime()
+{
+    const KFileItemList items = createItems();
+    const QDateTime dateTime(QDate(2018, 6, 1), QTime(12, 30));
+    TimeUtils::setCachedDateTimeForFileItem(items.at(1), dateTime);
+    DirSnapshot::store(DIR_URL, DirSnapshot::entriesForItems(items));
+
+    // Forget the date, loading the snapshot should bring it back
+    TimeUtils::setCachedDateTimeForFileItem(items.at(1), QDateTime());
+    QVERIFY(!TimeUtils::cachedDateTimeForFileItem(items.at(1)).isValid());
+
+    const KFileItemList loadedItems = DirSnapshot::load(DIR_URL);
+    QCOMPARE(loadedItems.count(), items.count());
+    QCOMPARE(TimeUtils::cachedDateTimeForFileItem(loadedItems.at(1)), dateTime);
+    QVERIFY(!TimeUtils::cachedDateTimeForFileItem(loadedItems.at(2)).isValid());
+}
+
+void DirSnapshotTest::testUnknownFolder()
+{
+    DirSnapshot::store(DIR_URL, DirSnapshot::entriesForItems(createItems()));
+    QVERIFY(DirSnapshot::load(QUrl(QStringLiteral("sftp://server/other"))).isEmpty());
+
+    DirSnapshot::remove(DIR_URL);
+    QVERIFY(DirSnapshot::load(DIR_URL).isEmpty());
+}
+
+void DirSnapshotTest::testCorruptedSnapshot()
+{
+    DirSnapshot::store(DIR_URL, DirSnapshot::entriesForItems(createItems()));
+    const QStringList files = QDir(mCacheDir.path()).entryList(QStringList() << QStringLiteral("*.snapshot"));
+    QCOMPARE(files.count(), 1);
+
+    // Truncate the snapshot in the middle of the entries
+    QFile file(mCacheDir.path() + QLatin1Char('/') + files.first());
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() / 2));
+    file.close();
+
+    QVERIFY(DirSnapshot::load(DIR_URL).isEmpty());
+    QVERIFY(!QFile::exists(file.fileName()));
+}
+
+void DirSnapshotTest::testHugeCount()
+{
+    DirSnapshot::store(DIR_URL, DirSnapshot::entriesForItems(createItems()));
+    const QStringList files = QDir(mCacheDir.path()).entryList(QStringList() << QStringLiteral("*.snapshot"));
+    QCOMPARE(files.count(), 1);
+
+    // Rewrite the header with an entry count the file cannot hold
+    QFile file(mCacheDir.path() + QLatin1Char('/') + files.first());
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QDataStream stream(&file);
+    stream << quint32(0x47564453) << quint32(1)
+           << DIR_URL.adjusted(QUrl::StripTrailingSlash).toString(QUrl::FullyEncoded)
+           << qint32(0x7fffffff);
+    file.close();
+
+    QVERIFY(DirSnapshot::load(DIR_URL).isEmpty());
+    QVERIFY(!QFile::exists(file.fileName()));
+}
+
+void DirSnapshotTest::testReconcile()
+{
+    TestUtils::SandBoxDir sandBoxDir;
+    QVERIFY(sandBoxDir.mkdir(QStringLiteral("before")));
+    QVERIFY(sandBoxDir.mkdir(QStringLiteral("after")));
+    createFile(sandBoxDir.absoluteFilePath(QStringLiteral("before/keep.png")), 10);
+    createFile(sandBoxDir.absoluteFilePath(QStringLiteral("before/changed.png")), 10);
+    createFile(sandBoxDir.absoluteFilePath(QStringLiteral("before/removed.png")), 10);
+    createFile(sandBoxDir.absoluteFilePath(QStringLiteral("after/keep.png")), 10);
+    createFile(sandBoxDir.absoluteFilePath(QStringLiteral("after/changed.png")), 20);
+    createFile(sandBoxDir.absoluteFilePath(QStringLiteral("after/added.png")), 10);
+    const QUrl beforeUrl = QUrl::fromLocalFile(sandBoxDir.absoluteFilePath(QStringLiteral("before")));
+    const QUrl afterUrl = QUrl::fromLocalFile(sandBoxDir.absoluteFilePath(QStringLiteral("after")));
+
+    // Store the content of "before" as the snapshot of "after", as if
+    // "after" had been modified since it was last shown
+    {
+        KCoreDirLister lister;
+        QSignalSpy spy(&lister, SIGNAL(completed()));
+        lister.openUrl(beforeUrl);
+        QVERIFY(spy.wait());
+        QCOMPARE(lister.items().count(), 3);
+        DirSnapshot::store(afterUrl, DirSnapshot::entriesForItems(lister.items()));
+    }
+
+    SnapshotDirLister lister;
+    QList<KFileItemList> addedItems;
+    KFileItemList deletedItems;
+    KFileItemList refreshedItems;
+    connect(&lister, &KCoreDirLister::itemsAdded, this, [&addedItems](const QUrl&, const KFileItemList& items) {
+        addedItems << items;
+    });
+    connect(&lister, &KCoreDirLister::itemsDeleted, this, [&deletedItems](const KFileItemList& items) {
+        deletedItems << items;
+    });
+    connect(&lister, &KCoreDirLister::refreshItems, this, [&refreshedItems](const QList<QPair<KFileItem, KFileItem> >& items) {
+        for (const auto& pair : items) {
+            refreshedItems << pair.second;
+        }
+    });
+    QSignalSpy completedSpy(&lister, SIGNAL(completed()));
+    lister.openUrl(afterUrl);
+
+    // The snapshot is shown right away
+    QCOMPARE(addedItems.count(), 1);
+    QCOMPARE(fileNames(addedItems.first()), QStringList() << QStringLiteral("changed.png") << QStringLiteral("keep.png") << QStringLiteral("removed.png"));
+
+    // Then the differences with the real content are reported, keep.png has
+    // not changed
+    QVERIFY(completedSpy.wait());
+    QCOMPARE(completedSpy.count(), 1);
+    QCOMPARE(fileNames(deletedItems), QStringList() << QStringLiteral("removed.png"));
+    QCOMPARE(fileNames(refreshedItems), QStringList() << QStringLiteral("changed.png"));
+    QCOMPARE(addedItems.count(), 2);
+    QCOMPARE(fileNames(addedItems.at(1)), QStringList() << QStringLiteral("added.png"));
+    QCOMPARE(fileNames(lister.items()), QStringList() << QStringLiteral("added.png") << QStringLiteral("changed.png") << QStringLiteral("keep.png"));
+}
@@ -352,6 +352,31 @@ void DocumentTest::testDeleteWhileLoading()
     QTest::qWait(2000);
 }
 
+/**
+ * Asking for the full image while a down sampled image is being decoded must
+ * abandon the down sampled decode and produce the full image.
+ */
+void DocumentTest::testLoadFullWhileLoadingDownSampled()
+{
+    QUrl url = urlForTestFile("orient6.jpg");
+    QImage image;
+    bool ok = image.load(url.toLocalFile());
+    QVERIFY2(ok, "Could not load 'orient6.jpg'");
+    image = image.transformed(ImageUtils::transformMatrix(ROT_90));
+
+    Document::Ptr doc = DocumentFactory::instance()->load(url);
+    while (doc->loadingState() < Document::MetaInfoLoaded) {
+        QTest::qWait(10);
+    }
+    bool ready = doc->prepareDownSampledImageForZoom(0.2);
+    QVERIFY2(!ready, "There should not be a down sampled image at this point");
+    doc->startLoadingFullImage();
+
+    doc->waitUntilLoaded();
+    QCOMPARE(doc->loadingState(), Document::Loaded);
+    QCOMPARE(image, doc->image());
+}
+
 void DocumentTest::testLoadRotated()
 {
     QUrl url = urlForTestFile("orient6.jpg");
@@ -113,6 +113,7 @@ private Q_SLOTS:
     void testLoadAnimated();
     void testPrepareDownSampledAfterFailure();
     void testDeleteWhileLoading();
+    void testLoadFullWhileLoadingDownSampled();
     void testLoadRotated();
     void testMultipleLoads();
     void testSaveAs();
@@ -0,0 +1,305 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "imagehashtest.h"
+
+#include <math.h>
+
+// Qt
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QSet>
+#include <QtEndian>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/imagehash.h"
+#include "../lib/imagehashindex.h"
+
+QTEST_MAIN(ImageHashTest)
+
+using namespace Gwenview;
+
+static QImage createImage(int width, int height, qreal fx, qreal fy, int brightness = 0)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            // Use relative coordinates so that images of different sizes
+            // show the same pattern
+            const qreal value = 120 + 100 * sin(fx * x / width + fy * y / height);
+            const int gray = qBound(0, int(value) + brightness, 255);
+            line[x] = qRgb(gray, gray, gray);
+        }
+    }
+    return image;
+}
+
+static QUrl urlForIndex(int idx)
+{
+    return QUrl(QStringLiteral("file:///photos/%1.jpg").arg(idx));
+}
+
+/**
+ * Appends a record to the index, the way another process would
+ */
+static void writeRecord(QDataStream* stream, const QUrl& url, qint64 modificationTime, quint64 hash)
+{
+    const QByteArray urlString = url.url().toUtf8();
+    const QByteArray md5 = QCryptographicHash::hash(urlString, QCryptographicHash::Md5);
+    *stream << qFromBigEndian<quint64>(reinterpret_cast<const uchar*>(md5.constData()))
+            << modificationTime << hash << urlString;
+}
+
+void ImageHashTest::initTestCase()
+{
+    QVERIFY(mCacheDir.isValid());
+    ImageHashIndex::setCacheDir(mCacheDir.path());
+}
+
+void ImageHashTest::init()
+{
+    QFile::remove(ImageHashIndex::cacheDir() + QStringLiteral("index"));
+    ImageHashIndex::instance()->reload();
+}
+
+void ImageHashTest::cleanup()
+{
+    // Drop pending records, so that they are not written to the temporary
+    // dir when the index is destroyed
+    ImageHashIndex::instance()->reload();
+}
+
+void ImageHashTest::testDistance()
+{
+    QCOMPARE(ImageHash::distance(0, 0), 0);
+    QCOMPARE(ImageHash::distance(0, ~quint64(0)), 64);
+    QCOMPARE(ImageHash::distance(0xb, 0x1), 2);
+}
+
+void ImageHashTest::testSimilarImages()
+{
+    const quint64 hash = ImageHash::differenceHash(createImage(256, 192, 9, 5));
+    const quint64 scaledHash = ImageHash::differenceHash(createImage(128, 96, 9, 5));
+    const quint64 brighterHash = ImageHash::differenceHash(createImage(256, 192, 9, 5, 20));
+    const quint64 otherHash = ImageHash::differenceHash(createImage(256, 192, -7, 11));
+
+    QVERIFY(ImageHash::distance(hash, scaledHash) <= 4);
+    QVERIFY(ImageHash::distance(hash, brighterHash) <= 4);
+    QVERIFY(ImageHash::distance(hash, otherHash) > 16);
+    QCOMPARE(ImageHash::differenceHash(QImage()), quint64(0));
+}
+
+void ImageHashTest::testFindHash()
+{
+    ImageHashIndex* index = ImageHashIndex::instance();
+    const QUrl url = urlForIndex(1);
+    index->insert(url, 1000, 0x1234);
+
+    quint64 hash = 0;
+    QVERIFY(index->findHash(url, 1000, &hash));
+    QCOMPARE(hash, quint64(0x1234));
+    QVERIFY(index->findHash(url, 1000));
+
+    // The file has been modified since it was hashed
+    QVERIFY(!index->findHash(url, 2000));
+    QVERIFY(!index->findHash(urlForIndex(2), 1000));
+
+    // Updating the hash of a file replaces it
+    index->insert(url, 2000, 0x5678);
+    QVERIFY(index->findHash(url, 2000, &hash));
+    QCOMPARE(hash, quint64(0x5678));
+    QCOMPARE(index->count(), 1);
+    QVERIFY(index->similarUrls(0x1234, 0).isEmpty());
+    QCOMPARE(index->similarUrls(0x5678, 0), QList<QUrl>() << url);
+}
+
+void ImageHashTest::testPersistence()
+{
+    ImageHashIndex* index = ImageHashIndex::instance();
+    for (int idx = 0; idx < 10; ++idx) {
+        index->insert(urlForIndex(idx), 1000 + idx, idx);
+    }
+    // Update an entry, the last record must win
+    index->insert(urlForIndex(3), 5000, 42);
+    index->flush();
+
+    index->reload();
+    QCOMPARE(index->count(), 10);
+    quint64 hash;
+    QVERIFY(index->findHash(urlForIndex(7), 1007, &hash));
+    QCOMPARE(hash, quint64(7));
+    QVERIFY(!index->findHash(urlForIndex(3), 1003));
+    QVERIFY(index->findHash(urlForIndex(3), 5000, &hash));
+    QCOMPARE(hash, quint64(42));
+}
+
+void ImageHashTest::testTruncatedIndex()
+{
+    ImageHashIndex* index = ImageHashIndex::instance();
+    index->insert(urlForIndex(1), 1000, 1);
+    index->insert(urlForIndex(2), 1000, 2);
+    index->flush();
+
+    // Simulate a crash while a record was being appended
+    QFile file(ImageHashIndex::cacheDir() + QStringLiteral("index"));
+    QVERIFY(file.open(QIODevice::Append));
+    file.write("\x00\x00\x01", 3);
+    file.close();
+
+    index->reload();
+    QCOMPARE(index->count(), 2);
+
+    // New records must still be readable after the broken one
+    index->insert(urlForIndex(3), 1000, 3);
+    index->flush();
+    index->reload();
+    QCOMPARE(index->count(), 3);
+    QVERIFY(index->findHash(urlForIndex(3), 1000));
+}
+
+void ImageHashTest::testRemove()
+{
+    ImageHashIndex* index = ImageHashIndex::instance();
+    for (int idx = 0; idx < 3; ++idx) {
+        index->insert(urlForIndex(idx), 1000, idx);
+    }
+    index->flush();
+
+    index->remove(urlForIndex(1));
+    QCOMPARE(index->count(), 2);
+    QVERIFY(!index->findHash(urlForIndex(1), 1000));
+    QVERIFY(index->similarUrls(1, 0).isEmpty());
+    QCOMPARE(index->urls().toSet(), QSet<QUrl>() << urlForIndex(0) << urlForIndex(2));
+
+    // The removal must survive a reload, although the log still contains
+    // the record of the removed url
+    index->flush();
+    index->reload();
+    QCOMPARE(index->count(), 2);
+    QVERIFY(!index->findHash(urlForIndex(1), 1000));
+    QVERIFY(index->findHash(urlForIndex(2), 1000));
+
+    // Removing an unknown url does nothing
+    index->remove(urlForIndex(5));
+    QCOMPARE(index->count(), 2);
+}
+
+void ImageHashTest::testSharedIndex()
+{
+    ImageHashIndex* index = ImageHashIndex::instance();
+    index->insert(urlForIndex(1), 1000, 1);
+    index->flush();
+
+    // Another process appends a record
+    const QString indexPath = ImageHashIndex::cacheDir() + QStringLiteral("index");
+    {
+        QFile file(indexPath);
+        QVERIFY(file.open(QIODevice::Append));
+        QDataStream stream(&file);
+        writeRecord(&stream, urlForIndex(2), 1000, 2);
+    }
+    index->insert(urlForIndex(3), 1000, 3);
+    index->flush();
+    QVERIFY(index->findHash(urlForIndex(2), 1000));
+
+    index->reload();
+    QCOMPARE(index->count(), 3);
+
+    // Another process compacts the index, our pending records must be
+    // written to the new log
+    index->insert(urlForIndex(4), 1000, 4);
+    {
+        QFile file(indexPath);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        QDataStream stream(&file);
+        stream << quint32(0x47564948) << quint32(3) << quint64(42);
+        writeRecord(&stream, urlForIndex(1), 1000, 1);
+        writeRecord(&stream, urlForIndex(5), 1000, 5);
+    }
+    index->flush();
+    index->reload();
+    QCOMPARE(index->urls().toSet(), QSet<QUrl>() << urlForIndex(1) << urlForIndex(4) << urlForIndex(5));
+}
+
+void ImageHashTest::testChangesWhileLoading()
+{
+    ImageHashIndex* index = ImageHashIndex::instance();
+    for (int idx = 0; idx < 3; ++idx) {
+        index->insert(urlForIndex(idx), 1000, idx);
+    }
+    index->flush();
+
+    // Changes made before the index is loaded must win over the log
+    index->reload();
+    index->insert(urlForIndex(0), 2000, 42);
+    index->remove(urlForIndex(1));
+    QVERIFY(index->findHash(urlForIndex(0), 2000));
+    QCOMPARE(index->count(), 2);
+    QVERIFY(!index->findHash(urlForIndex(0), 1000));
+    QVERIFY(!index->findHash(urlForIndex(1), 1000));
+    QVERIFY(index->findHash(urlForIndex(2), 1000));
+    QCOMPARE(index->urls().toSet(), QSet<QUrl>() << urlForIndex(0) << urlForIndex(2));
+
+    index->flush();
+    index->reload();
+    QCOMPARE(index->urls().toSet(), QSet<QUrl>() << urlForIndex(0) << urlForIndex(2));
+    quint64 hash;
+    QVERIFY(index->findHash(urlForIndex(0), 2000, &hash));
+    QCOMPARE(hash, quint64(42));
+}
+
+void ImageHashTest::testSimilarUrls()
+{
+    ImageHashIndex* index = ImageHashIndex::instance();
+    QList<quint64> hashes;
+    quint64 value = 0x9e3779b97f4a7c15ULL;
+    for (int idx = 0; idx < 2000; ++idx) {
+        // xorshift, to get well spread hashes with a reproducible result
+        value ^= value << 13;
+        value ^= value >> 7;
+        value ^= value << 17;
+        hashes << value;
+    }
+    // Add near-duplicates of the first hash
+    hashes << (hashes[0] ^ 0x1) << (hashes[0] ^ 0x300) << (hashes[0] ^ 0xf0000);
+
+    for (int idx = 0; idx < hashes.size(); ++idx) {
+        index->insert(urlForIndex(idx), 1000, hashes[idx]);
+    }
+
+    for (int maxDistance : {0, 2, 4, 12}) {
+        QSet<QUrl> expected;
+        for (int idx = 0; idx < hashes.size(); ++idx) {
+            if (ImageHash::distance(hashes[0], hashes[idx]) <= maxDistance) {
+                expected << urlForIndex(idx);
+            }
+        }
+        const QList<QUrl> urls = index->similarUrls(hashes[0], maxDistance);
+        QCOMPARE(urls.size(), expected.size());
+        QCOMPARE(urls.toSet(), expected);
+    }
+    QCOMPARE(index->similarUrls(hashes[0], 4).size(), 4);
+}
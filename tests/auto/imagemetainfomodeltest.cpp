@@ -55,4 +55,49 @@ void ImageMetaInfoModelTest::testCatchExiv2Errors()
 
     ImageMetaInfoModel model;
     model.setExiv2Image(image.get());
+    // Values are only formatted when groups are fetched
+    for (int row = 0; row < model.rowCount(); ++row) {
+        model.fetchMore(model.index(row, 0));
+    }
+}
+
+void ImageMetaInfoModelTest::testGroupsAreFilledOnDemand()
+{
+    Exiv2::Image::AutoPtr image;
+    {
+        Exiv2ImageLoader loader;
+        QVERIFY(loader.load(pathForTestFile("orient6.jpg")));
+        image = loader.popImage();
+    }
+
+    ImageMetaInfoModel model;
+    model.setExiv2Image(image.get());
+    QModelIndex exifIndex;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        if (model.index(row, 0).data().toString() == QLatin1String("EXIF")) {
+            exifIndex = model.index(row, 0);
+        }
+    }
+    QVERIFY(exifIndex.isValid());
+    QCOMPARE(model.rowCount(exifIndex), 0);
+    QVERIFY(model.hasChildren(exifIndex));
+    QVERIFY(model.canFetchMore(exifIndex));
+
+    // Preferred keys are read without creating rows
+    QCOMPARE(model.getValueForKey("Exif.Image.Make"), QString::fromUtf8("Canon"));
+    QCOMPARE(model.rowCount(exifIndex), 0);
+
+    model.fetchMore(exifIndex);
+    QVERIFY(!model.canFetchMore(exifIndex));
+    QVERIFY(model.rowCount(exifIndex) > 0);
+    QCOMPARE(model.getValueForKey("Exif.Image.Make"), QString::fromUtf8("Canon"));
+
+    // A group which has been fetched is filled again when new data is set
+    model.setExiv2Image(image.get());
+    QVERIFY(!model.canFetchMore(exifIndex));
+    QVERIFY(model.rowCount(exifIndex) > 0);
+
+    model.setExiv2Image(nullptr);
+    QCOMPARE(model.rowCount(exifIndex), 0);
+    QVERIFY(!model.hasChildren(exifIndex));
 }
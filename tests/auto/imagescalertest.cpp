@@ -66,6 +66,98 @@ void ImageScalerTest::testScaleFullImage()
     QVERIFY(TestUtils::imageCompare(scaledImage, expectedImage));
 }
 
+static Document::Ptr loadTestDocument()
+{
+    Document::Ptr doc = DocumentFactory::instance()->load(urlForTestFile("test.png"));
+    doc->startLoadingFullImage();
+    doc->waitUntilLoaded();
+    return doc;
+}
+
+/**
+ * Large rects are emitted right away with a fast pass, then replaced by
+ * smooth tiles
+ */
+void ImageScalerTest::testSmoothTiles()
+{
+    const qreal zoom = 3.5;
+    Document::Ptr doc = loadTestDocument();
+    QCOMPARE(doc->loadingState(), Document::Loaded);
+
+    ImageScaler scaler;
+    ImageScalerClient client(&scaler);
+    scaler.setDocument(doc);
+    scaler.setZoom(zoom);
+    const QRect rect(QPoint(0, 0), doc->size() * zoom);
+    scaler.setDestinationRegion(rect);
+
+    // The fast pass covers the whole rect
+    QCOMPARE(client.mImageInfoList.size(), 1);
+    const ImageScalerClient::ImageInfo& fastPass = client.mImageInfoList.first();
+    QCOMPARE(QRect(QPoint(fastPass.left, fastPass.top), fastPass.image.size()), rect);
+
+    // 525x350 pixels are scaled in 3x2 tiles
+    QTRY_COMPARE_WITH_TIMEOUT(client.mImageInfoList.size(), 7, 5000);
+    QRegion smoothRegion;
+    for (int idx = 1; idx < client.mImageInfoList.size(); ++idx) {
+        const ImageScalerClient::ImageInfo& info = client.mImageInfoList.at(idx);
+        smoothRegion |= QRect(QPoint(info.left, info.top), info.image.size());
+    }
+    QVERIFY((QRegion(rect) - smoothRegion).isEmpty());
+
+    QImage expectedImage = doc->image().scaled(rect.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    QVERIFY(TestUtils::fuzzyImageCompare(client.createFullImage(), expectedImage, 4));
+}
+
+/**
+ * Smooth tiles of a previous zoom must not be emitted
+ */
+void ImageScalerTest::testZoomChangeCancelsSmoothTiles()
+{
+    Document::Ptr doc = loadTestDocument();
+
+    ImageScaler scaler;
+    ImageScalerClient client(&scaler);
+    scaler.setDocument(doc);
+    scaler.setZoom(3.5);
+    scaler.setDestinationRegion(QRect(QPoint(0, 0), doc->size() * 3.5));
+    QCOMPARE(client.mImageInfoList.size(), 1);
+
+    // Zoom 4 is scaled without smoothing, in one pass
+    scaler.setZoom(4);
+    scaler.setDestinationRegion(QRect(QPoint(0, 0), doc->size() * 4));
+    QCOMPARE(client.mImageInfoList.size(), 2);
+    QTest::qWait(500);
+    QCOMPARE(client.mImageInfoList.size(), 2);
+}
+
+/**
+ * Strips exposed by scrolling are scaled smoothly in one pass, even when
+ * they are larger than the rects scaled synchronously
+ */
+void ImageScalerTest::testScrollStripIsSmooth()
+{
+    const qreal zoom = 3.5;
+    Document::Ptr doc = loadTestDocument();
+
+    ImageScaler scaler;
+    ImageScalerClient client(&scaler);
+    scaler.setDocument(doc);
+    scaler.setZoom(zoom);
+    const QRect rect(0, 0, doc->width() * zoom, 150);
+    QVERIFY(rect.width() * rect.height() > 256 * 256);
+    scaler.setDestinationRegion(rect);
+
+    QCOMPARE(client.mImageInfoList.size(), 1);
+    const ImageScalerClient::ImageInfo& info = client.mImageInfoList.first();
+    QCOMPARE(QRect(QPoint(info.left, info.top), info.image.size()), rect);
+    QTest::qWait(500);
+    QCOMPARE(client.mImageInfoList.size(), 1);
+
+    QImage expectedImage = doc->image().scaled(doc->size() * zoom, Qt::IgnoreAspectRatio, Qt::SmoothTransformation).copy(rect);
+    QVERIFY(TestUtils::fuzzyImageCompare(info.image, expectedImage, 4));
+}
+
 #if 0
 /**
  * Scale parts of an image
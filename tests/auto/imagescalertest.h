@@ -88,6 +88,9 @@ class ImageScalerTest : public QObject
 
 private Q_SLOTS:
     void testScaleFullImage();
+    void testSmoothTiles();
+    void testZoomChangeCancelsSmoothTiles();
+    void testScrollStripIsSmooth();
 
     // FIXME Disabled for now, does not compile since ImageScaler::setImage() has
     // been replaced with ImageScaler::setDocument()
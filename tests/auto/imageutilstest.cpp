@@ -0,0 +1,142 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "imageutilstest.h"
+
+// Qt
+#include <QImage>
+#include <QMatrix>
+#include <QThreadPool>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/imageutils.h"
+#include "../lib/workerpool.h"
+
+QTEST_MAIN(ImageUtilsTest)
+
+using namespace Gwenview;
+
+Q_DECLARE_METATYPE(QImage::Format)
+Q_DECLARE_METATYPE(Gwenview::Orientation)
+
+static QImage createGradientImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            line[x] = qRgba(x * 7 % 256, y * 13 % 256, (x + y) % 256, 255 - x % 128);
+        }
+    }
+    return image;
+}
+
+void ImageUtilsTest::testTransformed_data()
+{
+    QTest::addColumn<QImage::Format>("format");
+    QTest::addColumn<Orientation>("orientation");
+
+    const QList<QPair<const char*, QImage::Format> > formats = {
+        {"mono", QImage::Format_Mono},
+        {"indexed8", QImage::Format_Indexed8},
+        {"grayscale8", QImage::Format_Grayscale8},
+        {"rgb16", QImage::Format_RGB16},
+        {"rgb888", QImage::Format_RGB888},
+        {"rgb32", QImage::Format_RGB32},
+        {"argb32", QImage::Format_ARGB32},
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+        {"rgba64", QImage::Format_RGBA64},
+#endif
+    };
+    const QList<QPair<const char*, Orientation> > orientations = {
+        {"hflip", HFLIP},
+        {"rot180", ROT_180},
+        {"vflip", VFLIP},
+        {"transpose", TRANSPOSE},
+        {"rot90", ROT_90},
+        {"transverse", TRANSVERSE},
+        {"rot270", ROT_270},
+    };
+    for (const auto& format : formats) {
+        for (const auto& orientation : orientations) {
+            QTest::newRow(qPrintable(QStringLiteral("%1-%2").arg(QLatin1String(format.first), QLatin1String(orientation.first))))
+                << format.second << orientation.second;
+        }
+    }
+}
+
+void ImageUtilsTest::testTransformed()
+{
+    QFETCH(QImage::Format, format);
+    QFETCH(Orientation, orientation);
+    // Sizes which are not multiples of the tile size
+    const QImage image = createGradientImage(150, 71).convertToFormat(format);
+
+    const QImage result = ImageUtils::transformed(image, orientation);
+    if (image.depth() >= 8) {
+        QCOMPARE(result.format(), format);
+    }
+
+    // Conversions work pixel per pixel, so comparing in ARGB32 checks every
+    // pixel went to the right place
+    const QImage expected = image.convertToFormat(QImage::Format_ARGB32)
+        .transformed(ImageUtils::transformMatrix(orientation));
+    QCOMPARE(result.convertToFormat(QImage::Format_ARGB32), expected);
+}
+
+void ImageUtilsTest::testTransformedKeepsMetadata()
+{
+    QImage image = createGradientImage(20, 10).convertToFormat(QImage::Format_Indexed8);
+    image.setDotsPerMeterX(1000);
+    image.setDotsPerMeterY(2000);
+
+    QImage result = ImageUtils::transformed(image, ROT_90);
+    QCOMPARE(result.size(), QSize(10, 20));
+    QCOMPARE(result.colorTable(), image.colorTable());
+    QCOMPARE(result.dotsPerMeterX(), 2000);
+    QCOMPARE(result.dotsPerMeterY(), 1000);
+
+    result = ImageUtils::transformed(image, HFLIP);
+    QCOMPARE(result.dotsPerMeterX(), 1000);
+    QCOMPARE(result.dotsPerMeterY(), 2000);
+
+    QCOMPARE(ImageUtils::transformed(image, NORMAL), image);
+    QVERIFY(ImageUtils::transformed(QImage(), ROT_90).isNull());
+}
+
+void ImageUtilsTest::testTransformedRangesMatchSingleThread()
+{
+    // Big enough to be split in ranges
+    const QImage image = createGradientImage(1500, 1100);
+    const int threadCount = WorkerPool::pool(WorkerLane::Interactive)->maxThreadCount();
+
+    for (Orientation orientation : {ROT_90, TRANSVERSE, VFLIP}) {
+        WorkerPool::setMaxThreadCount(WorkerLane::Interactive, 4);
+        const QImage parallel = ImageUtils::transformed(image, orientation);
+        WorkerPool::setMaxThreadCount(WorkerLane::Interactive, 1);
+        const QImage single = ImageUtils::transformed(image, orientation);
+        WorkerPool::setMaxThreadCount(WorkerLane::Interactive, threadCount);
+
+        QCOMPARE(parallel, single);
+        QCOMPARE(parallel, image.transformed(ImageUtils::transformMatrix(orientation)));
+    }
+}
@@ -279,6 +279,27 @@ void JpegContentTest::testRawData()
     QCOMPARE(content.rawData(), fileData);
 }
 
+void JpegContentTest::testLoadHeader()
+{
+    const QString path = pathForTestFile(ORIENT6_FILE);
+    Gwenview::JpegContent content;
+    QVERIFY(content.load(path));
+    Gwenview::JpegContent header;
+    QVERIFY(header.loadHeader(path));
+
+    // The compressed image data is not read
+    QVERIFY(header.rawData().size() < content.rawData().size());
+    QVERIFY(content.rawData().startsWith(header.rawData()));
+
+    QCOMPARE(header.orientation(), content.orientation());
+    QCOMPARE(header.size(), content.size());
+    QCOMPARE(header.comment(), content.comment());
+    QCOMPARE(header.thumbnail(), content.thumbnail());
+
+    QVERIFY(!header.loadHeader(pathForTestFile("test.png")));
+    QVERIFY(!header.loadHeader(QStringLiteral("does-not-exist.jpg")));
+}
+
 void JpegContentTest::testSetImage()
 {
     Gwenview::JpegContent content;
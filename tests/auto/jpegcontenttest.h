@@ -38,6 +38,7 @@ private Q_SLOTS:
     void testMultipleRotations();
     void testLoadTruncated();
     void testRawData();
+    void testLoadHeader();
     void testSetImage();
 };
 
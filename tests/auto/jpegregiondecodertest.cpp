@@ -0,0 +1,97 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "jpegregiondecodertest.h"
+
+// Qt
+#include <QFile>
+#include <QImageReader>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/jpegregiondecoder.h"
+#include "testutils.h"
+
+QTEST_MAIN(JpegRegionDecoderTest)
+
+using namespace Gwenview;
+
+static QByteArray readTestFile(const QString& name)
+{
+    QFile file(pathForTestFile(name));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+static QImage readFullImage(const QString& name)
+{
+    // Regions are decoded without applying the orientation
+    QImageReader reader(pathForTestFile(name));
+    reader.setAutoTransform(false);
+    return reader.read();
+}
+
+void JpegRegionDecoderTest::testDecode_data()
+{
+    QTest::addColumn<QRect>("rect");
+    QTest::addColumn<QRect>("expectedRect");
+
+    QTest::newRow("top-left") << QRect(0, 0, 100, 50) << QRect(0, 0, 100, 50);
+    // Does not start on an MCU boundary
+    QTest::newRow("middle") << QRect(123, 211, 200, 150) << QRect(123, 211, 200, 150);
+    QTest::newRow("bottom-right") << QRect(450, 650, 50, 57) << QRect(450, 650, 50, 57);
+    QTest::newRow("outside") << QRect(450, 650, 100, 100) << QRect(450, 650, 50, 57);
+}
+
+void JpegRegionDecoderTest::testDecode()
+{
+    QFETCH(QRect, rect);
+    QFETCH(QRect, expectedRect);
+    const QString name = QStringLiteral("302350_exiv_0.23_exception.jpg");
+    const QImage fullImage = readFullImage(name);
+    QCOMPARE(fullImage.size(), QSize(500, 707));
+
+    const QImage image = JpegRegionDecoder::decode(readTestFile(name), rect);
+    QCOMPARE(image.format(), QImage::Format_RGB32);
+    QCOMPARE(image.size(), expectedRect.size());
+    // Upsampling of chroma may differ a bit at the edges of the region
+    QVERIFY(TestUtils::fuzzyImageCompare(image, fullImage.copy(expectedRect), 4));
+}
+
+void JpegRegionDecoderTest::testGrayscale()
+{
+    const QString name = QStringLiteral("1x10k.jpg");
+    const QRect rect(0, 5000, 1, 100);
+    const QImage image = JpegRegionDecoder::decode(readTestFile(name), rect);
+    QCOMPARE(image.format(), QImage::Format_Grayscale8);
+    QVERIFY(TestUtils::fuzzyImageCompare(image, readFullImage(name).copy(rect), 1));
+}
+
+void JpegRegionDecoderTest::testInvalidData()
+{
+    QImage image = JpegRegionDecoder::decode(QByteArray("not a jpeg"), QRect(0, 0, 10, 10));
+    QVERIFY(image.isNull());
+
+    image = JpegRegionDecoder::decode(readTestFile(QStringLiteral("test.png")), QRect(0, 0, 10, 10));
+    QVERIFY(image.isNull());
+}
@@ -0,0 +1,147 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "memorypressuremonitortest.h"
+
+// Qt
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/memorypressuremonitor.h"
+
+QTEST_MAIN(MemoryPressureMonitorTest)
+
+using namespace Gwenview;
+
+void MemoryPressureMonitorTest::testParsePressure()
+{
+    const QByteArray content =
+        "some avg10=12.50 avg60=3.00 avg300=1.00 total=123456\n"
+        "full avg10=2.25 avg60=0.50 avg300=0.10 total=4567\n";
+    MemoryPressureMonitor::Sample sample;
+    QVERIFY(MemoryPressureMonitor::parsePressure(content, &sample));
+    QCOMPARE(sample.someAvg10, 12.5);
+    QCOMPARE(sample.fullAvg10, 2.25);
+}
+
+void MemoryPressureMonitorTest::testParseInvalidPressure()
+{
+    MemoryPressureMonitor::Sample sample;
+    QVERIFY(!MemoryPressureMonitor::parsePressure(QByteArray(), &sample));
+    QVERIFY(!MemoryPressureMonitor::parsePressure("some avg10=abc\n", &sample));
+    QCOMPARE(sample.someAvg10, qreal(-1));
+    QCOMPARE(sample.fullAvg10, qreal(-1));
+}
+
+void MemoryPressureMonitorTest::testCgroupPath_data()
+{
+    QTest::addColumn<QByteArray>("content");
+    QTest::addColumn<QString>("expectedPath");
+    QTest::addColumn<bool>("expectedUnified");
+
+    QTest::newRow("v2") << QByteArray("0::/user.slice/kiosk.scope\n")
+        << "/user.slice/kiosk.scope" << true;
+    QTest::newRow("v1")
+        << QByteArray("5:cpu,cpuacct:/\n4:memory:/kiosk\n0::/\n")
+        << "/kiosk" << false;
+    QTest::newRow("v1-shared") << QByteArray("3:memory,hugetlb:/kiosk\n")
+        << "/kiosk" << false;
+    QTest::newRow("none") << QByteArray("5:cpu:/\n") << QString() << false;
+}
+
+void MemoryPressureMonitorTest::testCgroupPath()
+{
+    QFETCH(QByteArray, content);
+    QFETCH(QString, expectedPath);
+    QFETCH(bool, expectedUnified);
+
+    bool unified = !expectedUnified;
+    QCOMPARE(MemoryPressureMonitor::cgroupPath(content, &unified), expectedPath);
+    QCOMPARE(unified, expectedUnified);
+}
+
+void MemoryPressureMonitorTest::testParseMemoryStat_data()
+{
+    QTest::addColumn<QByteArray>("content");
+    QTest::addColumn<bool>("expectedFound");
+    QTest::addColumn<qulonglong>("expectedInactiveFile");
+
+    QTest::newRow("v2")
+        << QByteArray("anon 104857600\nfile 943718400\nactive_file 104857600\ninactive_file 838860800\n")
+        << true << 838860800ULL;
+    QTest::newRow("v1")
+        << QByteArray("cache 943718400\nrss 104857600\ninactive_file 1024\n"
+                      "total_cache 943718400\ntotal_inactive_file 838860800\n")
+        << true << 838860800ULL;
+    QTest::newRow("none") << QByteArray("anon 104857600\n") << false << 0ULL;
+    QTest::newRow("empty") << QByteArray() << false << 0ULL;
+}
+
+void MemoryPressureMonitorTest::testParseMemoryStat()
+{
+    QFETCH(QByteArray, content);
+    QFETCH(bool, expectedFound);
+    QFETCH(qulonglong, expectedInactiveFile);
+
+    MemoryPressureMonitor::Sample sample;
+    QCOMPARE(MemoryPressureMonitor::parseMemoryStat(content, &sample), expectedFound);
+    QCOMPARE(sample.cgroupInactiveFile, expectedInactiveFile);
+}
+
+void MemoryPressureMonitorTest::testLevelForSample_data()
+{
+    QTest::addColumn<qreal>("some");
+    QTest::addColumn<qreal>("full");
+    QTest::addColumn<qulonglong>("current");
+    QTest::addColumn<qulonglong>("inactiveFile");
+    QTest::addColumn<qulonglong>("max");
+    QTest::addColumn<int>("expectedLevel");
+
+    QTest::newRow("unknown") << qreal(-1) << qreal(-1) << 0ULL << 0ULL << 0ULL << int(MemoryPressureMonitor::NoPressure);
+    QTest::newRow("idle") << qreal(0) << qreal(0) << 10ULL << 0ULL << 100ULL << int(MemoryPressureMonitor::NoPressure);
+    QTest::newRow("some-moderate") << qreal(15) << qreal(0) << 0ULL << 0ULL << 0ULL << int(MemoryPressureMonitor::ModeratePressure);
+    QTest::newRow("some-critical") << qreal(50) << qreal(0) << 0ULL << 0ULL << 0ULL << int(MemoryPressureMonitor::CriticalPressure);
+    QTest::newRow("full-critical") << qreal(15) << qreal(12) << 0ULL << 0ULL << 0ULL << int(MemoryPressureMonitor::CriticalPressure);
+    QTest::newRow("cgroup-moderate") << qreal(-1) << qreal(-1) << 85ULL << 0ULL << 100ULL << int(MemoryPressureMonitor::ModeratePressure);
+    QTest::newRow("cgroup-critical") << qreal(0) << qreal(0) << 95ULL << 0ULL << 100ULL << int(MemoryPressureMonitor::CriticalPressure);
+    // Reading files fills the cgroup with page cache the kernel can reclaim
+    QTest::newRow("cgroup-cache") << qreal(0) << qreal(0) << 95ULL << 60ULL << 100ULL << int(MemoryPressureMonitor::NoPressure);
+    QTest::newRow("cgroup-cache-critical") << qreal(0) << qreal(0) << 98ULL << 5ULL << 100ULL << int(MemoryPressureMonitor::CriticalPressure);
+    QTest::newRow("cgroup-inactive-above-current") << qreal(0) << qreal(0) << 50ULL << 60ULL << 100ULL << int(MemoryPressureMonitor::NoPressure);
+}
+
+void MemoryPressureMonitorTest::testLevelForSample()
+{
+    QFETCH(qreal, some);
+    QFETCH(qreal, full);
+    QFETCH(qulonglong, current);
+    QFETCH(qulonglong, inactiveFile);
+    QFETCH(qulonglong, max);
+    QFETCH(int, expectedLevel);
+
+    MemoryPressureMonitor::Sample sample;
+    sample.someAvg10 = some;
+    sample.fullAvg10 = full;
+    sample.cgroupCurrent = current;
+    sample.cgroupInactiveFile = inactiveFile;
+    sample.cgroupMax = max;
+    QCOMPARE(int(MemoryPressureMonitor::levelForSample(sample)), expectedLevel);
+}
@@ -0,0 +1,77 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "metainfoprovidertest.h"
+
+// Qt
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSignalSpy>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/imagemetainfomodel.h"
+#include "../lib/metainfoprovider.h"
+#include "testutils.h"
+
+QTEST_MAIN(MetaInfoProviderTest)
+
+using namespace Gwenview;
+
+void MetaInfoProviderTest::testLoadMetaInfo()
+{
+    const QUrl url = urlForTestFile("orient6.jpg");
+    MetaInfoProvider::ModelPtr model = MetaInfoProvider::loadMetaInfo(url);
+    QVERIFY(model);
+
+    QCOMPARE(model->getValueForKey("Exif.Image.Make"), QString::fromUtf8("Canon"));
+    QCOMPARE(model->getValueForKey("General.Name"), QString::fromUtf8("orient6.jpg"));
+
+    // The image is rotated, so the size must be transposed like Document does
+    QSize size = QImageReader(url.toLocalFile()).size();
+    size.transpose();
+    ImageMetaInfoModel expected;
+    expected.setImageSize(size);
+    QCOMPARE(model->getValueForKey("General.ImageSize"), expected.getValueForKey("General.ImageSize"));
+}
+
+void MetaInfoProviderTest::testCache()
+{
+    MetaInfoProvider* provider = MetaInfoProvider::instance();
+    const QUrl url = urlForTestFile("test.png");
+    const QDateTime time = QFileInfo(url.toLocalFile()).lastModified();
+    QSignalSpy spy(provider, SIGNAL(metaInfoLoaded(QUrl)));
+
+    QVERIFY(!provider->metaInfo(url, time));
+    QVERIFY(waitForSignal(spy));
+    QCOMPARE(spy.takeFirst().at(0).toUrl(), url);
+
+    MetaInfoProvider::ModelPtr model = provider->metaInfo(url, time);
+    QVERIFY(model);
+    QCOMPARE(provider->metaInfo(url, time), model);
+
+    // A different modification time means the file changed
+    QVERIFY(!provider->metaInfo(url, time.addSecs(1)));
+    QVERIFY(waitForSignal(spy));
+    MetaInfoProvider::ModelPtr newModel = provider->metaInfo(url, time.addSecs(1));
+    QVERIFY(newModel);
+    QVERIFY(newModel != model);
+}
@@ -0,0 +1,107 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "multiresolutionreadertest.h"
+
+// Qt
+#include <QImageReader>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/multiresolutionreader.h"
+#include "testutils.h"
+
+QTEST_MAIN(MultiResolutionReaderTest)
+
+using namespace Gwenview;
+
+// pyramid.tif contains a red 64x32 image, followed by a green 32x16 level and
+// a blue 16x8 level
+static const char* PYRAMID_FILE = "pyramid.tif";
+
+static void skipIfNoMultiPageSupport(QImageReader* reader)
+{
+    if (reader->imageCount() < 2) {
+        QSKIP("The TIFF image plugin does not support multi-page images");
+    }
+}
+
+void MultiResolutionReaderTest::testLevels()
+{
+    QImageReader reader(pathForTestFile(PYRAMID_FILE));
+    skipIfNoMultiPageSupport(&reader);
+
+    const QVector<MultiResolutionReader::Level> levels = MultiResolutionReader::levels(&reader);
+    QCOMPARE(levels.count(), 2);
+    QCOMPARE(levels[0].index, 1);
+    QCOMPARE(levels[0].size, QSize(32, 16));
+    QCOMPARE(levels[1].index, 2);
+    QCOMPARE(levels[1].size, QSize(16, 8));
+
+    // The reader must still be usable to read the main image
+    QImage image = reader.read();
+    QCOMPARE(image.size(), QSize(64, 32));
+}
+
+void MultiResolutionReaderTest::testReadLevel_data()
+{
+    QTest::addColumn<QSize>("minimumSize");
+    QTest::addColumn<bool>("expectedOk");
+    QTest::addColumn<QSize>("expectedSize");
+    QTest::addColumn<QColor>("expectedColor");
+
+    QTest::newRow("smallest") << QSize(10, 5) << true << QSize(16, 8) << QColor(Qt::blue);
+    QTest::newRow("exact") << QSize(16, 8) << true << QSize(16, 8) << QColor(Qt::blue);
+    QTest::newRow("middle") << QSize(20, 10) << true << QSize(32, 16) << QColor(Qt::green);
+    QTest::newRow("too big") << QSize(40, 20) << false << QSize() << QColor();
+}
+
+void MultiResolutionReaderTest::testReadLevel()
+{
+    QFETCH(QSize, minimumSize);
+    QFETCH(bool, expectedOk);
+    QFETCH(QSize, expectedSize);
+    QFETCH(QColor, expectedColor);
+
+    QImageReader reader(pathForTestFile(PYRAMID_FILE));
+    skipIfNoMultiPageSupport(&reader);
+
+    QImage image;
+    bool ok = MultiResolutionReader::readLevel(&reader, minimumSize, &image);
+    QCOMPARE(ok, expectedOk);
+    if (!ok) {
+        QVERIFY(image.isNull());
+        QCOMPARE(reader.read().size(), QSize(64, 32));
+        return;
+    }
+    QCOMPARE(image.size(), expectedSize);
+    QCOMPARE(QColor(image.pixel(0, 0)), expectedColor);
+}
+
+void MultiResolutionReaderTest::testSingleImage()
+{
+    QImageReader reader(pathForTestFile("test.png"));
+    QVERIFY(MultiResolutionReader::levels(&reader).isEmpty());
+
+    QImage image;
+    QVERIFY(!MultiResolutionReader::readLevel(&reader, QSize(1, 1), &image));
+    QVERIFY(!reader.read().isNull());
+}
@@ -0,0 +1,108 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "rawpreviewcachetest.h"
+
+// Qt
+#include <QBuffer>
+#include <QFile>
+#include <QImage>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/rawpreviewcache.h"
+#include "testutils.h"
+
+QTEST_MAIN(RawPreviewCacheTest)
+
+using namespace Gwenview;
+
+static QByteArray createJpegData(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "jpeg");
+    return data;
+}
+
+static void writeSourceFile(const QString& path, const QByteArray& content)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(content);
+}
+
+void RawPreviewCacheTest::initTestCase()
+{
+    QVERIFY(mTempDir.isValid());
+    RawPreviewCache::setCacheDir(mTempDir.path() + "/cache");
+}
+
+void RawPreviewCacheTest::testStoreAndFind()
+{
+    const QString sourcePath = mTempDir.path() + "/store.raw";
+    writeSourceFile(sourcePath, "fake raw content");
+
+    RawPreviewCache::Preview preview;
+    QVERIFY(!RawPreviewCache::findPreview(sourcePath, 0, &preview));
+
+    preview.data = createJpegData(40, 30);
+    preview.ratio = 2;
+    RawPreviewCache::storePreview(sourcePath, preview);
+
+    RawPreviewCache::Preview cached;
+    QVERIFY(RawPreviewCache::findPreview(sourcePath, 0, &cached));
+    QCOMPARE(cached.data, preview.data);
+    QCOMPARE(cached.ratio, 2);
+}
+
+void RawPreviewCacheTest::testStaleEntry()
+{
+    const QString sourcePath = mTempDir.path() + "/stale.raw";
+    writeSourceFile(sourcePath, "fake raw content");
+
+    RawPreviewCache::Preview preview;
+    preview.data = createJpegData(40, 30);
+    RawPreviewCache::storePreview(sourcePath, preview);
+
+    // Changing the size of the source must invalidate the entry
+    writeSourceFile(sourcePath, "modified fake raw content");
+
+    RawPreviewCache::Preview cached;
+    QVERIFY(!RawPreviewCache::findPreview(sourcePath, 0, &cached));
+}
+
+void RawPreviewCacheTest::testMinSize()
+{
+    const QString sourcePath = mTempDir.path() + "/minsize.raw";
+    writeSourceFile(sourcePath, "fake raw content");
+
+    RawPreviewCache::Preview preview;
+    preview.data = createJpegData(40, 30);
+    RawPreviewCache::storePreview(sourcePath, preview);
+
+    RawPreviewCache::Preview cached;
+    QVERIFY(RawPreviewCache::findPreview(sourcePath, 30, &cached));
+    QVERIFY(!RawPreviewCache::findPreview(sourcePath, 31, &cached));
+}
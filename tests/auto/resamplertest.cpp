@@ -0,0 +1,156 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "resamplertest.h"
+
+// Qt
+#include <QImage>
+#include <QThreadPool>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/resampler.h"
+#include "../lib/workerpool.h"
+
+QTEST_MAIN(ResamplerTest)
+
+using namespace Gwenview;
+
+Q_DECLARE_METATYPE(Gwenview::Resampler::Filter)
+
+static QImage createCheckerImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            line[x] = ((x / 3 + y / 5) % 2) ? qRgb(250, x % 256, 10) : qRgb(5, 128, y % 256);
+        }
+    }
+    return image;
+}
+
+void ResamplerTest::testUniformImage_data()
+{
+    QTest::addColumn<Resampler::Filter>("filter");
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("box-down") << Resampler::Box << QSize(33, 17);
+    QTest::newRow("bilinear-down") << Resampler::Bilinear << QSize(33, 17);
+    QTest::newRow("mitchell-down") << Resampler::Mitchell << QSize(33, 17);
+    QTest::newRow("lanczos3-down") << Resampler::Lanczos3 << QSize(33, 17);
+    QTest::newRow("lanczos3-up") << Resampler::Lanczos3 << QSize(250, 310);
+    QTest::newRow("lanczos3-mixed") << Resampler::Lanczos3 << QSize(250, 20);
+}
+
+void ResamplerTest::testUniformImage()
+{
+    QFETCH(Resampler::Filter, filter);
+    QFETCH(QSize, size);
+    QImage image(100, 80, QImage::Format_RGB32);
+    image.fill(qRgb(12, 200, 97));
+
+    const QImage result = Resampler::scaled(image, size, filter);
+    QCOMPARE(result.size(), size);
+    QCOMPARE(result.format(), QImage::Format_RGB32);
+    for (int y = 0; y < result.height(); ++y) {
+        for (int x = 0; x < result.width(); ++x) {
+            QCOMPARE(result.pixel(x, y), qRgb(12, 200, 97));
+        }
+    }
+}
+
+void ResamplerTest::testBoxAverage()
+{
+    QImage image(4, 2, QImage::Format_Grayscale8);
+    const uchar values[2][4] = {{0, 100, 10, 20}, {50, 50, 30, 40}};
+    for (int y = 0; y < 2; ++y) {
+        memcpy(image.scanLine(y), values[y], 4);
+    }
+
+    const QImage result = Resampler::scaled(image, QSize(2, 1), Resampler::Box);
+    QCOMPARE(result.format(), QImage::Format_Grayscale8);
+    QCOMPARE(int(result.constScanLine(0)[0]), 50);
+    QCOMPARE(int(result.constScanLine(0)[1]), 25);
+}
+
+void ResamplerTest::testFormats()
+{
+    QImage argb(10, 10, QImage::Format_ARGB32);
+    argb.fill(Qt::transparent);
+    QCOMPARE(Resampler::scaled(argb, QSize(5, 5), Resampler::Mitchell).format(), QImage::Format_ARGB32_Premultiplied);
+
+    QImage rgb888(10, 10, QImage::Format_RGB888);
+    rgb888.fill(Qt::red);
+    QCOMPARE(Resampler::scaled(rgb888, QSize(5, 5), Resampler::Mitchell).format(), QImage::Format_RGB32);
+
+    QImage gray(10, 10, QImage::Format_Indexed8);
+    gray.setColorCount(256);
+    for (int idx = 0; idx < 256; ++idx) {
+        gray.setColor(idx, qRgb(idx, idx, idx));
+    }
+    gray.fill(12);
+    QCOMPARE(Resampler::scaled(gray, QSize(5, 5), Resampler::Mitchell).format(), QImage::Format_Grayscale8);
+
+    // Same size, nothing to do
+    QCOMPARE(Resampler::scaled(rgb888, rgb888.size(), Resampler::Mitchell), rgb888);
+    QVERIFY(Resampler::scaled(rgb888, QSize(0, 5), Resampler::Mitchell).isNull());
+    QVERIFY(Resampler::scaled(QImage(), QSize(5, 5), Resampler::Mitchell).isNull());
+}
+
+void ResamplerTest::testPremultipliedAlpha()
+{
+    // Lanczos rings around the sharp edge between a transparent area and an
+    // opaque white one: colors must stay below alpha
+    QImage image(40, 40, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    for (int y = 0; y < 40; ++y) {
+        for (int x = 20; x < 40; ++x) {
+            image.setPixel(x, y, qRgba(255, 255, 255, 255));
+        }
+    }
+    const QImage result = Resampler::scaled(image, QSize(97, 13), Resampler::Lanczos3);
+    for (int y = 0; y < result.height(); ++y) {
+        for (int x = 0; x < result.width(); ++x) {
+            const QRgb pixel = result.pixel(x, y);
+            QVERIFY(qRed(pixel) <= qAlpha(pixel));
+            QVERIFY(qGreen(pixel) <= qAlpha(pixel));
+            QVERIFY(qBlue(pixel) <= qAlpha(pixel));
+        }
+    }
+}
+
+void ResamplerTest::testStripsMatchSingleThread()
+{
+    // Big enough to be split in strips
+    const QImage image = createCheckerImage(1500, 1100);
+    const QSize size(1100, 700);
+    const int threadCount = WorkerPool::pool(WorkerLane::Interactive)->maxThreadCount();
+
+    WorkerPool::setMaxThreadCount(WorkerLane::Interactive, 4);
+    const QImage parallel = Resampler::scaled(image, size, Resampler::Lanczos3);
+    WorkerPool::setMaxThreadCount(WorkerLane::Interactive, 1);
+    const QImage single = Resampler::scaled(image, size, Resampler::Lanczos3);
+    WorkerPool::setMaxThreadCount(WorkerLane::Interactive, threadCount);
+
+    QCOMPARE(parallel.size(), size);
+    QCOMPARE(parallel, single);
+}
@@ -26,16 +26,43 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <lib/semanticinfo/sorteddirmodel.h>
 
 // Qt
+#include <QFile>
 
 // KDE
 #include <qtest.h>
 #include <KDirLister>
+#include <KDirModel>
+#include <KDirSortFilterProxyModel>
 #include <QTemporaryDir>
 
 using namespace Gwenview;
 
 QTEST_MAIN(SortedDirModelTest)
 
+static void createFile(const QString& path, int size)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(size, 'x'));
+}
+
+static void listDir(SortedDirModel* model, const QString& dir)
+{
+    QEventLoop loop;
+    QObject::connect(model->dirLister(), SIGNAL(completed()), &loop, SLOT(quit()));
+    model->dirLister()->openUrl(QUrl::fromLocalFile(dir));
+    loop.exec();
+}
+
+static QStringList names(const SortedDirModel& model)
+{
+    QStringList list;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        list << model.itemForIndex(model.index(row, 0)).name();
+    }
+    return list;
+}
+
 void SortedDirModelTest::initTestCase()
 {
     mSandBoxDir.mkdir("empty_dir");
@@ -47,6 +74,21 @@ void SortedDirModelTest::initTestCase()
     createEmptyFile(mSandBoxDir.absoluteFilePath("dirs_and_docs/file.png"));
     mSandBoxDir.mkdir("docs_only");
     createEmptyFile(mSandBoxDir.absoluteFilePath("docs_only/file.png"));
+    mSandBoxDir.mkdir("sorting");
+    mSandBoxDir.mkdir("sorting/zdir");
+    createFile(mSandBoxDir.absoluteFilePath("sorting/img10.png"), 1);
+    createFile(mSandBoxDir.absoluteFilePath("sorting/img2.png"), 3);
+    createFile(mSandBoxDir.absoluteFilePath("sorting/img1.png"), 2);
+    createFile(mSandBoxDir.absoluteFilePath("sorting/b.png"), 2);
+    mSandBoxDir.mkdir("mixed");
+    mSandBoxDir.mkdir("mixed/dir");
+    mSandBoxDir.mkdir("mixed/.hiddendir");
+    createFile(mSandBoxDir.absoluteFilePath("mixed/.hidden.png"), 2);
+    createFile(mSandBoxDir.absoluteFilePath("mixed/a.png"), 2);
+    createFile(mSandBoxDir.absoluteFilePath("mixed/A.png"), 3);
+    createFile(mSandBoxDir.absoluteFilePath("mixed/img10.png"), 1);
+    createFile(mSandBoxDir.absoluteFilePath("mixed/IMG2.png"), 2);
+    createFile(mSandBoxDir.absoluteFilePath("mixed/img1.png"), 2);
 }
 
 void SortedDirModelTest::testHasDocuments_data()
@@ -75,3 +117,65 @@ void SortedDirModelTest::testHasDocuments()
     loop.exec();
     QCOMPARE(model.hasDocuments(), hasDocuments);
 }
+
+void SortedDirModelTest::testSortByName()
+{
+    SortedDirModel model;
+    listDir(&model, mSandBoxDir.absoluteFilePath("sorting"));
+    model.sort(KDirModel::Name, Qt::AscendingOrder);
+    QCOMPARE(names(model), QStringList() << "zdir" << "b.png" << "img1.png" << "img2.png" << "img10.png");
+
+    // Folders stay first
+    model.sort(KDirModel::Name, Qt::DescendingOrder);
+    QCOMPARE(names(model), QStringList() << "zdir" << "img10.png" << "img2.png" << "img1.png" << "b.png");
+}
+
+void SortedDirModelTest::testSortBySize()
+{
+    SortedDirModel model;
+    listDir(&model, mSandBoxDir.absoluteFilePath("sorting"));
+    model.sort(KDirModel::Size, Qt::AscendingOrder);
+    // Files of the same size are sorted by name
+    QCOMPARE(names(model), QStringList() << "zdir" << "img10.png" << "b.png" << "img1.png" << "img2.png");
+}
+
+void SortedDirModelTest::testSortMatchesBaseClass_data()
+{
+    QTest::addColumn<int>("column");
+    QTest::addColumn<int>("order");
+    QTest::newRow("name-ascending") << int(KDirModel::Name) << int(Qt::AscendingOrder);
+    QTest::newRow("name-descending") << int(KDirModel::Name) << int(Qt::DescendingOrder);
+    QTest::newRow("size-ascending") << int(KDirModel::Size) << int(Qt::AscendingOrder);
+    QTest::newRow("size-descending") << int(KDirModel::Size) << int(Qt::DescendingOrder);
+}
+
+void SortedDirModelTest::testSortMatchesBaseClass()
+{
+    // The sort keys cached by SortedDirModel must give the same order as
+    // KDirSortFilterProxyModel, including for hidden items and name ties
+    QFETCH(int, column);
+    QFETCH(int, order);
+    const QUrl url = QUrl::fromLocalFile(mSandBoxDir.absoluteFilePath("mixed"));
+
+    SortedDirModel model;
+    model.dirLister()->setShowingDotFiles(true);
+    listDir(&model, url.toLocalFile());
+    model.sort(column, Qt::SortOrder(order));
+
+    KDirModel dirModel;
+    dirModel.dirLister()->setShowingDotFiles(true);
+    KDirSortFilterProxyModel baseModel;
+    baseModel.setSourceModel(&dirModel);
+    QEventLoop loop;
+    connect(dirModel.dirLister(), SIGNAL(completed()), &loop, SLOT(quit()));
+    dirModel.dirLister()->openUrl(url);
+    loop.exec();
+    baseModel.sort(column, Qt::SortOrder(order));
+
+    QStringList expected;
+    for (int row = 0; row < baseModel.rowCount(); ++row) {
+        expected << dirModel.itemForIndex(baseModel.mapToSource(baseModel.index(row, 0))).name();
+    }
+    QCOMPARE(expected.size(), 8);
+    QCOMPARE(names(model), expected);
+}
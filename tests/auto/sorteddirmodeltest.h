@@ -37,6 +37,10 @@ private Q_SLOTS:
     void initTestCase();
     void testHasDocuments_data();
     void testHasDocuments();
+    void testSortByName();
+    void testSortBySize();
+    void testSortMatchesBaseClass_data();
+    void testSortMatchesBaseClass();
 
 private:
     TestUtils::SandBoxDir mSandBoxDir;
@@ -0,0 +1,201 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "streamingdecodertest.h"
+#include <config-gwenview.h>
+
+// Qt
+#include <QBuffer>
+#include <QImageWriter>
+#include <QPainter>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/scanlinereducer.h"
+#include "../lib/streamingdecoder.h"
+#ifdef HAVE_FITS
+#include "../lib/imageformats/fitsformat/fitsdata.h"
+#endif
+
+QTEST_MAIN(StreamingDecoderTest)
+
+using namespace Gwenview;
+
+/**
+ * Creates an image made of four quadrants of different colors
+ */
+static QImage createQuadrantImage(const QSize& size, QImage::Format format)
+{
+    QImage image(size, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+    QPainter painter(&image);
+    const int halfWidth = size.width() / 2;
+    const int halfHeight = size.height() / 2;
+    painter.fillRect(halfWidth, 0, size.width() - halfWidth, halfHeight, Qt::green);
+    painter.fillRect(0, halfHeight, halfWidth, size.height() - halfHeight, Qt::blue);
+    painter.fillRect(halfWidth, halfHeight, size.width() - halfWidth, size.height() - halfHeight, Qt::white);
+    painter.end();
+    return image.convertToFormat(format);
+}
+
+static QByteArray toPng(const QImage& image)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, "png");
+    writer.write(image);
+    return data;
+}
+
+#ifdef HAVE_FITS
+static QByteArray fitsCard(const QString& keyword, const QString& value)
+{
+    QString card = keyword.leftJustified(8, QLatin1Char(' '));
+    if (!value.isEmpty()) {
+        card += QStringLiteral("= ") + value.rightJustified(20, QLatin1Char(' '));
+    }
+    return card.leftJustified(80, QLatin1Char(' ')).toLatin1();
+}
+
+/**
+ * Creates an 8 bit grayscale FITS image containing a gradient
+ */
+static QByteArray createFits(const QSize& size)
+{
+    QByteArray data;
+    data += fitsCard(QStringLiteral("SIMPLE"), QStringLiteral("T"));
+    data += fitsCard(QStringLiteral("BITPIX"), QStringLiteral("8"));
+    data += fitsCard(QStringLiteral("NAXIS"), QStringLiteral("2"));
+    data += fitsCard(QStringLiteral("NAXIS1"), QString::number(size.width()));
+    data += fitsCard(QStringLiteral("NAXIS2"), QString::number(size.height()));
+    data += fitsCard(QStringLiteral("END"), QString());
+    const int blockSize = 2880;
+    data += QByteArray((blockSize - data.size() % blockSize) % blockSize, ' ');
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            data += char((x * 3 + y * 5) & 0xff);
+        }
+    }
+    data += QByteArray((blockSize - data.size() % blockSize) % blockSize, 0);
+    return data;
+}
+#endif
+
+void StreamingDecoderTest::testReducer()
+{
+    QImage source(4, 4, QImage::Format_Grayscale8);
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            source.scanLine(y)[x] = uchar((y * 4 + x) * 10);
+        }
+    }
+
+    ScanlineReducer reducer(source.size(), QSize(2, 2), QImage::Format_Grayscale8);
+    for (int y = 0; y < source.height(); ++y) {
+        reducer.addLine(source.constScanLine(y));
+    }
+    const QImage image = reducer.image();
+    QCOMPARE(image.format(), QImage::Format_Grayscale8);
+    QCOMPARE(image.size(), QSize(2, 2));
+    // Each pixel is the average of a 2x2 box
+    QCOMPARE(int(image.constScanLine(0)[0]), (0 + 10 + 40 + 50) / 4);
+    QCOMPARE(int(image.constScanLine(0)[1]), (20 + 30 + 60 + 70) / 4);
+    QCOMPARE(int(image.constScanLine(1)[0]), (80 + 90 + 120 + 130) / 4);
+    QCOMPARE(int(image.constScanLine(1)[1]), (100 + 110 + 140 + 150) / 4);
+}
+
+void StreamingDecoderTest::testReducerAlpha()
+{
+    // Transparent pixels must not darken their opaque neighbours
+    QImage source(2, 1, QImage::Format_ARGB32);
+    source.setPixel(0, 0, qRgba(255, 255, 255, 255));
+    source.setPixel(1, 0, qRgba(0, 0, 0, 0));
+
+    ScanlineReducer reducer(source.size(), QSize(1, 1), QImage::Format_ARGB32);
+    reducer.addLine(source.constScanLine(0));
+    const QRgb pixel = reducer.image().pixel(0, 0);
+    QCOMPARE(qRed(pixel), 255);
+    QCOMPARE(qGreen(pixel), 255);
+    QCOMPARE(qBlue(pixel), 255);
+    QCOMPARE(qAlpha(pixel), 127);
+}
+
+void StreamingDecoderTest::testReadScaledPng_data()
+{
+    QTest::addColumn<int>("sourceFormat");
+    QTest::addColumn<int>("expectedFormat");
+
+    QTest::newRow("rgb") << int(QImage::Format_RGB32) << int(QImage::Format_RGB32);
+    QTest::newRow("argb") << int(QImage::Format_ARGB32) << int(QImage::Format_ARGB32);
+    QTest::newRow("indexed") << int(QImage::Format_Indexed8) << int(QImage::Format_RGB32);
+}
+
+void StreamingDecoderTest::testReadScaledPng()
+{
+    QFETCH(int, sourceFormat);
+    QFETCH(int, expectedFormat);
+    const QImage source = createQuadrantImage(QSize(100, 60), QImage::Format(sourceFormat));
+    QByteArray data = toPng(source);
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+
+    const QImage image = StreamingDecoder::readScaled(&buffer, "png", QSize(10, 6));
+    QCOMPARE(int(image.format()), expectedFormat);
+    QCOMPARE(image.size(), QSize(10, 6));
+    QCOMPARE(QColor(image.pixel(0, 0)), QColor(Qt::red));
+    QCOMPARE(QColor(image.pixel(9, 0)), QColor(Qt::green));
+    QCOMPARE(QColor(image.pixel(0, 5)), QColor(Qt::blue));
+    QCOMPARE(QColor(image.pixel(9, 5)), QColor(Qt::white));
+}
+
+void StreamingDecoderTest::testReadScaledTooBig()
+{
+    QByteArray data = toPng(createQuadrantImage(QSize(10, 10), QImage::Format_RGB32));
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QVERIFY(StreamingDecoder::readScaled(&buffer, "png", QSize(10, 10)).isNull());
+}
+
+void StreamingDecoderTest::testReadScaledFits()
+{
+#ifdef HAVE_FITS
+    QVERIFY(StreamingDecoder::canReadScaled("fits"));
+    QByteArray data = createFits(QSize(64, 40));
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    const QImage image = StreamingDecoder::readScaled(&buffer, "fits", QSize(16, 10));
+    QCOMPARE(image.format(), QImage::Format_Grayscale8);
+    QCOMPARE(image.size(), QSize(16, 10));
+
+    // The stretch must be the one of FITSData
+    buffer.seek(0);
+    const QImage fullImage = FITSData::FITSToImage(buffer).convertToFormat(QImage::Format_Grayscale8);
+    QCOMPARE(fullImage.size(), QSize(64, 40));
+    ScanlineReducer reducer(fullImage.size(), image.size(), QImage::Format_Grayscale8);
+    for (int y = 0; y < fullImage.height(); ++y) {
+        reducer.addLine(fullImage.constScanLine(y));
+    }
+    QCOMPARE(image, reducer.image());
+#else
+    QSKIP("FITS support is not enabled");
+#endif
+}
@@ -0,0 +1,117 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "tracingtest.h"
+
+// Qt
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/tracing.h"
+
+QTEST_MAIN(TracingTest)
+
+using namespace Gwenview;
+
+static QJsonArray readEvents(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QJsonArray();
+    }
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError) {
+        qWarning() << "Invalid trace:" << error.errorString();
+        return QJsonArray();
+    }
+    return doc.array();
+}
+
+static QJsonObject findEvent(const QJsonArray& events, const QString& name, const QString& phase)
+{
+    Q_FOREACH(const QJsonValue& value, events) {
+        const QJsonObject event = value.toObject();
+        if (event.value("name").toString() == name && event.value("ph").toString() == phase) {
+            return event;
+        }
+    }
+    return QJsonObject();
+}
+
+void TracingTest::initTestCase()
+{
+    QVERIFY(mTempDir.isValid());
+}
+
+void TracingTest::testDisabled()
+{
+    Tracing::setOutputFile(QString());
+    QVERIFY(!Tracing::isEnabled());
+    {
+        TraceSpan span("nothing");
+    }
+    Tracing::instant("nothing", QUrl());
+}
+
+void TracingTest::testEvents()
+{
+    const QString path = mTempDir.path() + "/trace.json";
+    const QUrl url = QUrl::fromLocalFile("/tmp/image.png");
+    Tracing::setOutputFile(path);
+    QVERIFY(Tracing::isEnabled());
+
+    {
+        TraceSpan span("span", url);
+        QTest::qSleep(2);
+    }
+    Tracing::instant("instant", url);
+    int id;
+    Tracing::beginAsync("async", url, &id);
+    Tracing::endAsync("async", url, &id);
+
+    Tracing::setOutputFile(QString());
+    QVERIFY(!Tracing::isEnabled());
+
+    const QJsonArray events = readEvents(path);
+    QVERIFY(!events.isEmpty());
+
+    QJsonObject event = findEvent(events, "span", "X");
+    QVERIFY(!event.isEmpty());
+    QVERIFY(event.value("dur").toDouble() >= 2000);
+    QCOMPARE(event.value("args").toObject().value("url").toString(), url.toDisplayString());
+
+    QVERIFY(!findEvent(events, "instant", "i").isEmpty());
+
+    const QJsonObject begin = findEvent(events, "async", "b");
+    const QJsonObject end = findEvent(events, "async", "e");
+    QVERIFY(!begin.isEmpty());
+    QVERIFY(!end.isEmpty());
+    QCOMPARE(begin.value("id").toString(), end.value("id").toString());
+    QVERIFY(begin.value("ts").toDouble() <= end.value("ts").toDouble());
+
+    QVERIFY(!findEvent(events, "thread_name", "M").isEmpty());
+}
@@ -0,0 +1,219 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "workerpooltest.h"
+
+// Qt
+#include <QAtomicInt>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+// KDE
+#include <qtest.h>
+
+// Local
+#include "../lib/workerpool.h"
+
+QTEST_MAIN(WorkerPoolTest)
+
+using namespace Gwenview;
+
+void WorkerPoolTest::testRun()
+{
+    QFuture<int> future = WorkerPool::run(WorkerLane::Interactive, []() {
+        return 42;
+    });
+    QCOMPARE(future.result(), 42);
+
+    bool called = false;
+    QFuture<void> voidFuture = WorkerPool::run(WorkerLane::BulkIO, [&called]() {
+        called = true;
+    });
+    voidFuture.waitForFinished();
+    QVERIFY(called);
+}
+
+void WorkerPoolTest::testStatistics()
+{
+    const WorkerLane::Enum lane = WorkerLane::Preload;
+    WorkerPool::setMaxThreadCount(lane, 1);
+    const qint64 finishedBefore = WorkerPool::statistics(lane).finished;
+
+    QSemaphore started;
+    QSemaphore release;
+    QFuture<void> blocking = WorkerPool::run(lane, [&started, &release]() {
+        started.release();
+        release.acquire();
+    });
+    started.acquire();
+    QFuture<void> queued = WorkerPool::run(lane, []() {});
+
+    WorkerPool::Statistics stats = WorkerPool::statistics(lane);
+    QCOMPARE(stats.maxThreadCount, 1);
+    QCOMPARE(stats.active, 1);
+    QCOMPARE(stats.queued, 1);
+    QVERIFY(stats.maxQueued >= 1);
+
+    release.release();
+    blocking.waitForFinished();
+    queued.waitForFinished();
+    // Statistics are updated after the result has been reported
+    QTRY_COMPARE(WorkerPool::statistics(lane).finished, finishedBefore + 2);
+    stats = WorkerPool::statistics(lane);
+    QCOMPARE(stats.active, 0);
+    QCOMPARE(stats.queued, 0);
+}
+
+void WorkerPoolTest::testLanesAreIndependent()
+{
+    WorkerPool::setMaxThreadCount(WorkerLane::Background, 1);
+    QSemaphore release;
+    QFuture<void> blocking = WorkerPool::run(WorkerLane::Background, [&release]() {
+        release.acquire();
+    });
+
+    // A busy background lane must not delay interactive work
+    QFuture<int> interactive = WorkerPool::run(WorkerLane::Interactive, []() {
+        return 1;
+    });
+    interactive.waitForFinished();
+    QCOMPARE(interactive.result(), 1);
+    QVERIFY(blocking.isRunning());
+
+    release.release();
+    blocking.waitForFinished();
+}
+
+void WorkerPoolTest::testPriorityIsRestored()
+{
+    // Waiting for a task which has not started yet runs it in the waiting
+    // thread, which must not keep the priority of the lane afterwards
+    QThread* thread = QThread::currentThread();
+    thread->setPriority(QThread::NormalPriority);
+    WorkerPool::taskQueued(WorkerLane::Preload);
+    {
+        WorkerPool::TaskScope scope(WorkerLane::Preload);
+        QCOMPARE(thread->priority(), QThread::LowPriority);
+    }
+    QCOMPARE(thread->priority(), QThread::NormalPriority);
+}
+
+void WorkerPoolTest::testMovableTask()
+{
+    const WorkerLane::Enum lane = WorkerLane::Preload;
+    WorkerPool::setMaxThreadCount(lane, 1);
+    QSemaphore started;
+    QSemaphore release;
+    QFuture<void> blocking = WorkerPool::run(lane, [&started, &release]() {
+        started.release();
+        release.acquire();
+    });
+    started.acquire();
+
+    QAtomicInt calls;
+    WorkerPool::MovableTask<int> task;
+    QFuture<int> future = task.run(lane, [&calls]() {
+        calls.ref();
+        return 42;
+    });
+    QFuture<int> queuedFuture = future;
+
+    // The task has not started, it can leave the busy lane
+    QVERIFY(!task.moveTo(lane, &future));
+    QVERIFY(task.moveTo(WorkerLane::Interactive, &future));
+    QCOMPARE(future.result(), 42);
+    QVERIFY(blocking.isRunning());
+    QVERIFY(!task.moveTo(lane, &future));
+
+    // The task queued first must not run the function again
+    release.release();
+    blocking.waitForFinished();
+    queuedFuture.waitForFinished();
+    QCOMPARE(calls.load(), 1);
+}
+
+void WorkerPoolTest::testRunInRanges_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("minCountPerRange");
+    QTest::addColumn<int>("threadCount");
+    QTest::addColumn<int>("expectedRanges");
+
+    QTest::newRow("split") << 1000 << 10 << 4 << 4;
+    QTest::newRow("uneven") << 1001 << 10 << 3 << 3;
+    QTest::newRow("small") << 25 << 10 << 4 << 2;
+    QTest::newRow("too-small") << 5 << 10 << 4 << 1;
+    QTest::newRow("one-thread") << 1000 << 10 << 1 << 1;
+    QTest::newRow("more-threads-than-items") << 3 << 1 << 8 << 3;
+    QTest::newRow("empty") << 0 << 1 << 4 << 1;
+}
+
+void WorkerPoolTest::testRunInRanges()
+{
+    QFETCH(int, count);
+    QFETCH(int, minCountPerRange);
+    QFETCH(int, threadCount);
+    QFETCH(int, expectedRanges);
+    const WorkerLane::Enum lane = WorkerLane::Interactive;
+    const int previousThreadCount = WorkerPool::pool(lane)->maxThreadCount();
+    WorkerPool::setMaxThreadCount(lane, threadCount);
+
+    QCOMPARE(WorkerPool::rangeCount(lane, count, minCountPerRange), expectedRanges);
+
+    QVector<int> hits(count);
+    QAtomicInt calls;
+    WorkerPool::runInRanges(lane, count, minCountPerRange, [&hits, &calls](int start, int end) {
+        calls.ref();
+        for (int idx = start; idx < end; ++idx) {
+            ++hits[idx];
+        }
+    });
+    WorkerPool::setMaxThreadCount(lane, previousThreadCount);
+
+    QCOMPARE(calls.load(), expectedRanges);
+    for (int idx = 0; idx < count; ++idx) {
+        QCOMPARE(hits[idx], 1);
+    }
+}
+
+void WorkerPoolTest::testNestedRunInRanges()
+{
+    // All threads of the lane wait for ranges which have not started yet:
+    // these must run in the waiting threads instead of dead-locking
+    const WorkerLane::Enum lane = WorkerLane::BulkIO;
+    const int previousThreadCount = WorkerPool::pool(lane)->maxThreadCount();
+    WorkerPool::setMaxThreadCount(lane, 2);
+
+    QAtomicInt total;
+    QFuture<void> future = WorkerPool::run(lane, [lane, &total]() {
+        WorkerPool::runInRanges(lane, 2, 1, [lane, &total](int start, int end) {
+            for (int idx = start; idx < end; ++idx) {
+                WorkerPool::runInRanges(lane, 100, 1, [&total](int first, int last) {
+                    total.fetchAndAddOrdered(last - first);
+                });
+            }
+        });
+    });
+    future.waitForFinished();
+    WorkerPool::setMaxThreadCount(lane, previousThreadCount);
+
+    QCOMPARE(total.load(), 200);
+}
@@ -0,0 +1,466 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#include "imagingbenchmark.h"
+
+// Qt
+#include <QBuffer>
+#include <QDataStream>
+#include <QFile>
+#include <QImage>
+#include <QImageWriter>
+#include <QRegion>
+#include <QSignalSpy>
+
+// KDE
+#include <KDirLister>
+#include <KDirModel>
+#include <qtest.h>
+
+// Local
+#include "../auto/testutils.h"
+#include <lib/document/documentfactory.h>
+#include <lib/imagescaler.h>
+#include <lib/jpegcontent.h>
+#include <lib/recursivedirmodel.h>
+#include <lib/semanticinfo/sorteddirmodel.h>
+#include <lib/thumbnailprovider/thumbnailgenerator.h>
+#include "config-gwenview.h"
+#ifdef HAVE_FITS
+#include <lib/imageformats/fitsformat/fitsdata.h>
+#endif
+
+QTEST_MAIN(ImagingBenchmark)
+
+using namespace Gwenview;
+
+static const QSize LARGE_IMAGE_SIZE(6000, 4000);
+static const QSize ANIMATION_SIZE(800, 600);
+static const int ANIMATION_FRAME_COUNT = 20;
+static const int FLAT_DIR_FILE_COUNT = 5000;
+static const int TREE_DIR_COUNT = 20;
+static const int TREE_DIR_FILE_COUNT = 250;
+
+//- Input generation ------------------------------------------------------
+static QImage createLargeImage()
+{
+    QImage image(LARGE_IMAGE_SIZE, QImage::Format_RGB32);
+    const int width = image.width();
+    const int height = image.height();
+    for (int y = 0; y < height; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            line[x] = qRgb(x * 255 / width, y * 255 / height, (x ^ y) & 0xff);
+        }
+    }
+    return image;
+}
+
+static void writeLe16(QByteArray* data, int value)
+{
+    data->append(char(value & 0xff));
+    data->append(char((value >> 8) & 0xff));
+}
+
+/**
+ * Encodes 8 bit pixels with LZW codes which are never combined. The output
+ * is larger than with a real encoder, but it is a valid GIF stream and it is
+ * much simpler to produce.
+ */
+static QByteArray encodeGifFrame(const QByteArray& pixels)
+{
+    const int clearCode = 256;
+    const int endCode = 257;
+    const int codeSize = 9;
+    // Emit a clear code often enough to keep the decoder code size at 9 bits
+    const int codesBetweenClears = 200;
+
+    QByteArray bytes;
+    quint32 bitBuffer = 0;
+    int bitCount = 0;
+    auto emitCode = [&](int code) {
+        bitBuffer |= quint32(code) << bitCount;
+        bitCount += codeSize;
+        while (bitCount >= 8) {
+            bytes.append(char(bitBuffer & 0xff));
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    };
+
+    for (int idx = 0; idx < pixels.size(); ++idx) {
+        if (idx % codesBetweenClears == 0) {
+            emitCode(clearCode);
+        }
+        emitCode(quint8(pixels.at(idx)));
+    }
+    emitCode(endCode);
+    if (bitCount > 0) {
+        bytes.append(char(bitBuffer & 0xff));
+    }
+
+    // Split in sub-blocks
+    QByteArray data;
+    data.append(char(8)); // LZW minimum code size
+    for (int pos = 0; pos < bytes.size(); pos += 255) {
+        const QByteArray block = bytes.mid(pos, 255);
+        data.append(char(block.size()));
+        data.append(block);
+    }
+    data.append(char(0));
+    return data;
+}
+
+static bool writeAnimatedGif(const QString& path)
+{
+    const int width = ANIMATION_SIZE.width();
+    const int height = ANIMATION_SIZE.height();
+    QByteArray data("GIF89a");
+    writeLe16(&data, width);
+    writeLe16(&data, height);
+    data.append(char(0xf7)); // Global color table, 256 entries
+    data.append(char(0));
+    data.append(char(0));
+    for (int idx = 0; idx < 256; ++idx) {
+        data.append(char(idx));
+        data.append(char(255 - idx));
+        data.append(char((idx * 7) & 0xff));
+    }
+    // Loop forever
+    data.append("\x21\xff\x0bNETSCAPE2.0\x03\x01", 16);
+    writeLe16(&data, 0);
+    data.append(char(0));
+
+    for (int frame = 0; frame < ANIMATION_FRAME_COUNT; ++frame) {
+        // Graphic control extension: 100 ms delay
+        data.append("\x21\xf9\x04\x00", 4);
+        writeLe16(&data, 10);
+        data.append(char(0));
+        data.append(char(0));
+        // Image descriptor
+        data.append(char(0x2c));
+        writeLe16(&data, 0);
+        writeLe16(&data, 0);
+        writeLe16(&data, width);
+        writeLe16(&data, height);
+        data.append(char(0));
+
+        QByteArray pixels(width * height, 0);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                pixels[y * width + x] = char((x + y + frame * 8) & 0xff);
+            }
+        }
+        data.append(encodeGifFrame(pixels));
+    }
+    data.append(char(0x3b));
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return file.write(data) == data.size();
+}
+
+#ifdef HAVE_FITS
+static QByteArray fitsCard(const QString& keyword, const QString& value)
+{
+    QString card = keyword.leftJustified(8, QLatin1Char(' '));
+    if (!value.isEmpty()) {
+        card += QStringLiteral("= ") + value.rightJustified(20, QLatin1Char(' '));
+    }
+    return card.leftJustified(80, QLatin1Char(' ')).toLatin1();
+}
+
+static bool writeFits(const QString& path)
+{
+    const int width = LARGE_IMAGE_SIZE.width();
+    const int height = LARGE_IMAGE_SIZE.height();
+    QByteArray data;
+    data += fitsCard(QStringLiteral("SIMPLE"), QStringLiteral("T"));
+    data += fitsCard(QStringLiteral("BITPIX"), QStringLiteral("8"));
+    data += fitsCard(QStringLiteral("NAXIS"), QStringLiteral("2"));
+    data += fitsCard(QStringLiteral("NAXIS1"), QString::number(width));
+    data += fitsCard(QStringLiteral("NAXIS2"), QString::number(height));
+    data += fitsCard(QStringLiteral("END"), QString());
+    const int blockSize = 2880;
+    data += QByteArray((blockSize - data.size() % blockSize) % blockSize, ' ');
+
+    QByteArray pixels(width * height, 0);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            pixels[y * width + x] = char((x ^ y) & 0xff);
+        }
+    }
+    data += pixels;
+    data += QByteArray((blockSize - data.size() % blockSize) % blockSize, 0);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return file.write(data) == data.size();
+}
+#endif
+
+static void createFiles(const QDir& dir, int count)
+{
+    for (int idx = 0; idx < count; ++idx) {
+        // Use non zero-padded numbers so that natural sorting has work to do
+        const QString name = QStringLiteral("img_%1.jpg").arg((idx * 7919) % count);
+        QFile file(dir.absoluteFilePath(name));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+    }
+}
+
+//- Helpers ---------------------------------------------------------------
+static void waitForDownSampledImage(const Document::Ptr& doc, qreal zoom)
+{
+    while (!doc->prepareDownSampledImageForZoom(zoom)) {
+        QVERIFY(doc->loadingState() != Document::LoadingFailed);
+        QSignalSpy spy(doc.data(), SIGNAL(downSampledImageReady()));
+        spy.wait(30000);
+    }
+}
+
+static void listDir(KDirLister* lister, const QString& path)
+{
+    QEventLoop loop;
+    QObject::connect(lister, SIGNAL(completed()), &loop, SLOT(quit()));
+    lister->openUrl(QUrl::fromLocalFile(path));
+    loop.exec();
+}
+
+//- ImagingBenchmark ------------------------------------------------------
+QString ImagingBenchmark::inputPath(const QByteArray& format) const
+{
+    if (format == "jpeg") {
+        return mJpegPath;
+    } else if (format == "png") {
+        return mPngPath;
+    } else if (format == "tiff") {
+        return mTiffPath;
+    }
+    return QString();
+}
+
+void ImagingBenchmark::initTestCase()
+{
+    QVERIFY(mTempDir.isValid());
+    QDir dir(mTempDir.path());
+
+    const QImage image = createLargeImage();
+    mJpegPath = dir.absoluteFilePath(QStringLiteral("large.jpg"));
+    QVERIFY(image.save(mJpegPath, "jpeg", 90));
+    mPngPath = dir.absoluteFilePath(QStringLiteral("large.png"));
+    QVERIFY(image.save(mPngPath, "png"));
+    if (QImageWriter::supportedImageFormats().contains("tiff")) {
+        mTiffPath = dir.absoluteFilePath(QStringLiteral("large.tif"));
+        QVERIFY(image.save(mTiffPath, "tiff"));
+    }
+#ifdef HAVE_FITS
+    mFitsPath = dir.absoluteFilePath(QStringLiteral("large.fits"));
+    QVERIFY(writeFits(mFitsPath));
+#endif
+    mGifPath = dir.absoluteFilePath(QStringLiteral("animated.gif"));
+    QVERIFY(writeAnimatedGif(mGifPath));
+
+    mFlatDirPath = dir.absoluteFilePath(QStringLiteral("flat"));
+    QVERIFY(dir.mkdir(QStringLiteral("flat")));
+    createFiles(QDir(mFlatDirPath), FLAT_DIR_FILE_COUNT);
+
+    mTreeDirPath = dir.absoluteFilePath(QStringLiteral("tree"));
+    QVERIFY(dir.mkdir(QStringLiteral("tree")));
+    QDir treeDir(mTreeDirPath);
+    for (int idx = 0; idx < TREE_DIR_COUNT; ++idx) {
+        const QString name = QStringLiteral("dir%1").arg(idx);
+        QVERIFY(treeDir.mkdir(name));
+        createFiles(QDir(treeDir.absoluteFilePath(name)), TREE_DIR_FILE_COUNT);
+    }
+}
+
+void ImagingBenchmark::cleanupTestCase()
+{
+    DocumentFactory::instance()->clearCache();
+}
+
+void ImagingBenchmark::benchImageScaler_data()
+{
+    QTest::addColumn<qreal>("zoom");
+    QTest::newRow("zoom=0.1") << qreal(0.1);
+    QTest::newRow("zoom=0.25") << qreal(0.25);
+    QTest::newRow("zoom=0.5") << qreal(0.5);
+    QTest::newRow("zoom=1") << qreal(1.);
+    QTest::newRow("zoom=2") << qreal(2.);
+}
+
+void ImagingBenchmark::benchImageScaler()
+{
+    QFETCH(qreal, zoom);
+    Document::Ptr doc = DocumentFactory::instance()->load(QUrl::fromLocalFile(mJpegPath));
+    if (zoom < Document::maxDownSampledZoom()) {
+        waitForDownSampledImage(doc, zoom);
+    } else {
+        doc->waitUntilLoaded();
+    }
+    QCOMPARE(doc->loadingState() == Document::LoadingFailed, false);
+
+    ImageScaler scaler;
+    scaler.setDocument(doc);
+    scaler.setZoom(zoom);
+    const QRect viewportRect = QRect(QPoint(0, 0), doc->size() * zoom).intersected(QRect(0, 0, 1920, 1080));
+    QSignalSpy spy(&scaler, SIGNAL(scaledRect(int,int,QImage)));
+    QBENCHMARK {
+        scaler.setDestinationRegion(QRegion(viewportRect));
+    }
+    QVERIFY(spy.count() > 0);
+}
+
+void ImagingBenchmark::benchDocumentDownSampling_data()
+{
+    QTest::addColumn<QByteArray>("format");
+    QTest::addColumn<qreal>("zoom");
+    QTest::newRow("jpeg, zoom=0.25") << QByteArray("jpeg") << qreal(0.25);
+    QTest::newRow("jpeg, zoom=0.1") << QByteArray("jpeg") << qreal(0.1);
+    QTest::newRow("png, zoom=0.25") << QByteArray("png") << qreal(0.25);
+    QTest::newRow("tiff, zoom=0.25") << QByteArray("tiff") << qreal(0.25);
+}
+
+void ImagingBenchmark::benchDocumentDownSampling()
+{
+    QFETCH(QByteArray, format);
+    QFETCH(qreal, zoom);
+    const QString path = inputPath(format);
+    if (path.isEmpty()) {
+        QSKIP("No writer for this format");
+    }
+    const QUrl url = QUrl::fromLocalFile(path);
+    QBENCHMARK {
+        DocumentFactory::instance()->clearCache();
+        Document::Ptr doc = DocumentFactory::instance()->load(url);
+        waitForDownSampledImage(doc, zoom);
+    }
+}
+
+void ImagingBenchmark::benchAnimatedDocumentLoading()
+{
+    const QUrl url = QUrl::fromLocalFile(mGifPath);
+    QBENCHMARK {
+        DocumentFactory::instance()->clearCache();
+        Document::Ptr doc = DocumentFactory::instance()->load(url);
+        doc->waitUntilLoaded();
+        QVERIFY(doc->isAnimated());
+    }
+}
+
+void ImagingBenchmark::benchThumbnailContextLoad_data()
+{
+    QTest::addColumn<QByteArray>("format");
+    QTest::addColumn<int>("pixelSize");
+    QTest::newRow("jpeg, 128") << QByteArray("jpeg") << 128;
+    QTest::newRow("jpeg, 256") << QByteArray("jpeg") << 256;
+    QTest::newRow("png, 256") << QByteArray("png") << 256;
+    QTest::newRow("tiff, 256") << QByteArray("tiff") << 256;
+}
+
+void ImagingBenchmark::benchThumbnailContextLoad()
+{
+    QFETCH(QByteArray, format);
+    QFETCH(int, pixelSize);
+    const QString path = inputPath(format);
+    if (path.isEmpty()) {
+        QSKIP("No writer for this format");
+    }
+    QBENCHMARK {
+        ThumbnailContext context;
+        QVERIFY(context.load(path, pixelSize));
+    }
+}
+
+void ImagingBenchmark::benchJpegContentTransform()
+{
+    QFile file(mJpegPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+
+    QBENCHMARK {
+        JpegContent content;
+        QVERIFY(content.loadFromData(data));
+        content.transform(ROT_90);
+        QByteArray output;
+        QBuffer buffer(&output);
+        buffer.open(QIODevice::WriteOnly);
+        // Saving applies the pending transformation
+        QVERIFY(content.save(&buffer));
+    }
+}
+
+void ImagingBenchmark::benchFitsToImage()
+{
+#ifdef HAVE_FITS
+    QFile file(mFitsPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QBENCHMARK {
+        file.seek(0);
+        const QImage image = FITSData::FITSToImage(file);
+        QVERIFY(!image.isNull());
+    }
+#else
+    QSKIP("Gwenview built without FITS support");
+#endif
+}
+
+void ImagingBenchmark::benchSortedDirModelSort()
+{
+    SortedDirModel model;
+    listDir(model.dirLister(), mFlatDirPath);
+    QCOMPARE(model.rowCount(), FLAT_DIR_FILE_COUNT);
+
+    Qt::SortOrder order = Qt::AscendingOrder;
+    QBENCHMARK {
+        order = order == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder;
+        model.sort(KDirModel::Name, order);
+    }
+}
+
+void ImagingBenchmark::benchSortedDirModelFilter()
+{
+    SortedDirModel model;
+    model.sort(KDirModel::Name, Qt::AscendingOrder);
+    listDir(model.dirLister(), mFlatDirPath);
+    QCOMPARE(model.rowCount(), FLAT_DIR_FILE_COUNT);
+
+    QBENCHMARK {
+        // Re-runs filterAcceptsRow() on all rows, then sorts again
+        model.invalidate();
+    }
+}
+
+void ImagingBenchmark::benchRecursiveDirModelListing()
+{
+    const QUrl url = QUrl::fromLocalFile(mTreeDirPath);
+    QBENCHMARK {
+        RecursiveDirModel model;
+        QEventLoop loop;
+        connect(&model, SIGNAL(completed()), &loop, SLOT(quit()));
+        model.setUrl(url);
+        loop.exec();
+        QCOMPARE(model.rowCount(QModelIndex()), TREE_DIR_COUNT * TREE_DIR_FILE_COUNT);
+    }
+}
@@ -0,0 +1,74 @@
+/*
+Gwenview: an image viewer
+Copyright 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#ifndef IMAGINGBENCHMARK_H
+#define IMAGINGBENCHMARK_H
+
+// Qt
+#include <QObject>
+#include <QTemporaryDir>
+
+/**
+ * Benchmarks for the imaging hot paths. All inputs are generated in
+ * initTestCase(), so the benchmark does not depend on any external file.
+ *
+ * Run the "benchmark" target to get the results in QTestLib XML format.
+ */
+class ImagingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchImageScaler_data();
+    void benchImageScaler();
+
+    void benchDocumentDownSampling_data();
+    void benchDocumentDownSampling();
+
+    void benchAnimatedDocumentLoading();
+
+    void benchThumbnailContextLoad_data();
+    void benchThumbnailContextLoad();
+
+    void benchJpegContentTransform();
+
+    void benchFitsToImage();
+
+    void benchSortedDirModelSort();
+    void benchSortedDirModelFilter();
+
+    void benchRecursiveDirModelListing();
+
+private:
+    QTemporaryDir mTempDir;
+    QString mJpegPath;
+    QString mPngPath;
+    QString mTiffPath;
+    QString mFitsPath;
+    QString mGifPath;
+    QString mFlatDirPath;
+    QString mTreeDirPath;
+
+    QString inputPath(const QByteArray& format) const;
+};
+
+#endif /* IMAGINGBENCHMARK_H */